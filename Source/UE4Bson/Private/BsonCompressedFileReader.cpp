@@ -0,0 +1,302 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BsonCompressedFileReader.h"
+#include "BsonCompressedFormat.h"
+#include "UE4Bson.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/Compression.h"
+
+
+FBsonCompressedFileReader::FBsonCompressedFileReader(const FString& InFilename)
+	: Filename(InFilename), Data(nullptr), Size(0), BufferSize(0), CurrentBlock(INDEX_NONE), CurrentPosition(0)
+{
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (!MappedFile.IsValid())
+	{
+		UE_LOG(LogBson, Error, TEXT("FBsonCompressedFileReader: could not open %s for mapping."), *Filename);
+		return;
+	}
+
+	Size = MappedFile->GetFileSize();
+	FBsonCompressedFileHeader Header;
+	if (Size >= (int64)sizeof(Header))
+	{
+		MappedRegion.Reset(MappedFile->MapRegion(0, Size));
+	}
+	if (!MappedRegion.IsValid())
+	{
+		UE_LOG(LogBson, Error, TEXT("FBsonCompressedFileReader: could not map %s."), *Filename);
+		MappedFile.Reset();
+		return;
+	}
+	Data = MappedRegion->GetMappedPtr();
+
+	FMemory::Memcpy(&Header, Data, sizeof(Header));
+	if (Header.Magic != BsonCompressedFileMagic || Header.Version != BsonCompressedFileVersion || Header.BufferSize == 0)
+	{
+		UE_LOG(LogBson, Error, TEXT("FBsonCompressedFileReader: %s is not a compressed Bson file."), *Filename);
+		MappedRegion.Reset();
+		MappedFile.Reset();
+		return;
+	}
+	Header.Format[sizeof(Header.Format) - 1] = 0;
+	Format = FName(ANSI_TO_TCHAR(Header.Format));
+	BufferSize = Header.BufferSize;
+
+	// Use the block index if the file was closed properly.
+	FBsonCompressedFileFooter Footer;
+	if (Size >= (int64)(sizeof(Header) + sizeof(Footer)))
+	{
+		FMemory::Memcpy(&Footer, Data + Size - sizeof(Footer), sizeof(Footer));
+		const int64 IndexSize = (int64)Footer.NumBlocks * sizeof(FBsonCompressedBlock);
+		if (Footer.Magic == BsonCompressedFooterMagic && Footer.IndexOffset >= (int64)sizeof(Header)
+			&& Footer.IndexOffset + IndexSize + (int64)sizeof(Footer) == Size)
+		{
+			Blocks.SetNumUninitialized(Footer.NumBlocks);
+			FMemory::Memcpy(Blocks.GetData(), Data + Footer.IndexOffset, IndexSize);
+			if (ValidateBlocks(Footer.IndexOffset))
+			{
+				return;
+			}
+
+			UE_LOG(LogBson, Warning, TEXT("FBsonCompressedFileReader: the block index of %s is corrupt, walking the blocks."), *Filename);
+			Blocks.Reset();
+		}
+	}
+
+	ScanBlocks(sizeof(Header));
+}
+
+
+FBsonCompressedFileReader::~FBsonCompressedFileReader()
+{
+	// The region has to be unmapped before the file is closed.
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+
+void FBsonCompressedFileReader::ScanBlocks(int64 FirstBlockOffset)
+{
+	int64 Offset = FirstBlockOffset;
+	int64 Document = 0;
+	FBsonCompressedBlockHeader BlockHeader;
+	while (Offset + (int64)sizeof(BlockHeader) <= Size)
+	{
+		FMemory::Memcpy(&BlockHeader, Data + Offset, sizeof(BlockHeader));
+		const int64 PayloadOffset = Offset + sizeof(BlockHeader);
+		if (BlockHeader.Magic != BsonCompressedBlockMagic || PayloadOffset + BlockHeader.CompressedSize > Size)
+		{
+			// The footer, or a block that is still being written.
+			break;
+		}
+
+		FBsonCompressedBlock Block;
+		Block.Offset = PayloadOffset;
+		Block.FirstDocument = Document;
+		Block.CompressedSize = BlockHeader.CompressedSize;
+		Block.UncompressedSize = BlockHeader.UncompressedSize;
+		Block.NumDocuments = BlockHeader.NumDocuments;
+		Block.Flags = BlockHeader.Flags;
+		if (!IsBsonCompressedBlockSizeValid(Block, BufferSize))
+		{
+			UE_LOG(LogBson, Error, TEXT("FBsonCompressedFileReader: corrupt block header at offset %lld of %s."), Offset, *Filename);
+			break;
+		}
+		Blocks.Add(Block);
+
+		Document += BlockHeader.NumDocuments;
+		Offset = PayloadOffset + BlockHeader.CompressedSize;
+	}
+}
+
+
+bool FBsonCompressedFileReader::ValidateBlocks(int64 BlocksEnd) const
+{
+	int64 Document = 0;
+	for (const FBsonCompressedBlock& Block : Blocks)
+	{
+		if (Block.Offset < (int64)(sizeof(FBsonCompressedFileHeader) + sizeof(FBsonCompressedBlockHeader))
+			|| Block.Offset + Block.CompressedSize > BlocksEnd
+			|| !IsBsonCompressedBlockSizeValid(Block, BufferSize)
+			|| Block.FirstDocument != Document)
+		{
+			return false;
+		}
+		Document += Block.NumDocuments;
+	}
+	return true;
+}
+
+
+bool FBsonCompressedFileReader::IsOpen() const
+{
+	return MappedRegion.IsValid();
+}
+
+
+int64 FBsonCompressedFileReader::GetNumDocuments() const
+{
+	return Blocks.Num() > 0 ? Blocks.Last().FirstDocument + Blocks.Last().NumDocuments : 0;
+}
+
+
+bool FBsonCompressedFileReader::DecompressBlock(int32 BlockIndex, TArray<uint8>& OutDocuments) const
+{
+	const FBsonCompressedBlock& Block = Blocks[BlockIndex];
+	if (Block.Offset + Block.CompressedSize > Size || !IsBsonCompressedBlockSizeValid(Block, BufferSize))
+	{
+		OutDocuments.Reset();
+		return false;
+	}
+	OutDocuments.SetNumUninitialized((int32)Block.UncompressedSize, false);
+
+	const double StartTime = FPlatformTime::Seconds();
+	bool bSuccess;
+	if (Block.Flags & BsonCompressedBlockStored)
+	{
+		bSuccess = Block.CompressedSize == Block.UncompressedSize;
+		if (bSuccess)
+		{
+			FMemory::Memcpy(OutDocuments.GetData(), Data + Block.Offset, Block.UncompressedSize);
+		}
+	}
+	else
+	{
+		bSuccess = FCompression::UncompressMemory(Format, OutDocuments.GetData(), Block.UncompressedSize, Data + Block.Offset, Block.CompressedSize);
+	}
+	const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+	if (!bSuccess)
+	{
+		UE_LOG(LogBson, Error, TEXT("FBsonCompressedFileReader: block %d of %s is corrupt."), BlockIndex, *Filename);
+		OutDocuments.Reset();
+		return false;
+	}
+
+	FScopeLock Lock(&StatsLock);
+	Stats.Documents += Block.NumDocuments;
+	Stats.UncompressedBytes += Block.UncompressedSize;
+	Stats.FileBytes += Block.CompressedSize + sizeof(FBsonCompressedBlockHeader);
+	Stats.CompressionSeconds += Seconds;
+	return true;
+}
+
+
+bool FBsonCompressedFileReader::ReadDocumentAt(const TArray<uint8>& Documents, int32 Position, TArrayView<const uint8>& OutDocument)
+{
+	const int32 Remaining = Documents.Num() - Position;
+	if (Remaining < 5)
+	{
+		return false;
+	}
+
+	const uint8* Header = Documents.GetData() + Position;
+	const int32 Length = (int32)((uint32)Header[0] | ((uint32)Header[1] << 8) | ((uint32)Header[2] << 16) | ((uint32)Header[3] << 24));
+	if (Length < 5 || Length > Remaining || Header[Length - 1] != 0)
+	{
+		return false;
+	}
+
+	OutDocument = TArrayView<const uint8>(Header, Length);
+	return true;
+}
+
+
+bool FBsonCompressedFileReader::LoadCurrentBlock(int32 BlockIndex)
+{
+	CurrentBlock = BlockIndex;
+	CurrentPosition = 0;
+	if (!DecompressBlock(BlockIndex, CurrentDocuments))
+	{
+		// stop reading
+		CurrentBlock = Blocks.Num();
+		return false;
+	}
+	return true;
+}
+
+
+bool FBsonCompressedFileReader::Next(FBsonObject& OutObject)
+{
+	if (CurrentBlock == INDEX_NONE && Blocks.Num() > 0 && !LoadCurrentBlock(0))
+	{
+		return false;
+	}
+
+	while (CurrentBlock != INDEX_NONE && CurrentBlock < Blocks.Num())
+	{
+		if (CurrentPosition < CurrentDocuments.Num())
+		{
+			TArrayView<const uint8> Document;
+			if (!ReadDocumentAt(CurrentDocuments, CurrentPosition, Document))
+			{
+				UE_LOG(LogBson, Error, TEXT("FBsonCompressedFileReader: corrupt document in block %d of %s."), CurrentBlock, *Filename);
+				CurrentBlock = Blocks.Num();
+				return false;
+			}
+			CurrentPosition += Document.Num();
+			OutObject.SetBorrowed(Document.GetData(), Document.Num());
+			return true;
+		}
+
+		if (CurrentBlock + 1 >= Blocks.Num() || !LoadCurrentBlock(CurrentBlock + 1))
+		{
+			CurrentBlock = Blocks.Num();
+			return false;
+		}
+	}
+	return false;
+}
+
+
+bool FBsonCompressedFileReader::SeekToDocument(int64 DocumentIndex)
+{
+	if (DocumentIndex < 0 || DocumentIndex >= GetNumDocuments())
+	{
+		return false;
+	}
+
+	// The last block starting at or before the document.
+	int32 First = 0;
+	int32 Count = Blocks.Num();
+	while (Count > 0)
+	{
+		const int32 Step = Count / 2;
+		if (Blocks[First + Step].FirstDocument <= DocumentIndex)
+		{
+			First += Step + 1;
+			Count -= Step + 1;
+		}
+		else
+		{
+			Count = Step;
+		}
+	}
+	const int32 BlockIndex = First - 1;
+
+	if (!LoadCurrentBlock(BlockIndex))
+	{
+		return false;
+	}
+
+	TArrayView<const uint8> Document;
+	for (int64 Skip = DocumentIndex - Blocks[BlockIndex].FirstDocument; Skip > 0; Skip--)
+	{
+		if (!ReadDocumentAt(CurrentDocuments, CurrentPosition, Document))
+		{
+			CurrentBlock = Blocks.Num();
+			return false;
+		}
+		CurrentPosition += Document.Num();
+	}
+	return true;
+}
+
+
+FBsonFileStats FBsonCompressedFileReader::GetStats() const
+{
+	FScopeLock Lock(&StatsLock);
+	return Stats;
+}
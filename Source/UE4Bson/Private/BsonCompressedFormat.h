@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BsonCompressedFileReader.h"
+
+/**
+* Layout of block-compressed Bson files, written by FBsonFileWriter with a compression format and read by
+* FBsonCompressedFileReader. Everything is little-endian.
+*
+* The file header is followed by the blocks, each a block header and its payload: concatenated documents,
+* compressed as a whole. Closing the writer appends the block index (an FBsonCompressedBlock per block) and
+* the footer. A file without footer, e.g. one that is still being written, is read by walking the block headers.
+*/
+struct FBsonCompressedFileHeader
+{
+	uint32 Magic;
+	uint32 Version;
+	/** FName of the FCompression format, zero-terminated. */
+	ANSICHAR Format[24];
+	/** FBsonFileWriterSettings::BufferSize of the writer, the largest block of several documents. */
+	uint32 BufferSize;
+	uint32 Reserved;
+};
+
+struct FBsonCompressedBlockHeader
+{
+	uint32 Magic;
+	uint32 Flags;
+	uint32 CompressedSize;
+	uint32 UncompressedSize;
+	uint32 NumDocuments;
+	uint32 Reserved;
+};
+
+struct FBsonCompressedFileFooter
+{
+	int64 IndexOffset;
+	uint32 NumBlocks;
+	uint32 Magic;
+};
+
+static const uint32 BsonCompressedFileMagic = 0x5A435342; // "BSCZ"
+static const uint32 BsonCompressedBlockMagic = 0x4B4C4342; // "BCLK"
+static const uint32 BsonCompressedFooterMagic = 0x58444942; // "BIDX"
+static const uint32 BsonCompressedFileVersion = 2;
+
+/** Largest UncompressedSize of a block holding a single document, which may be larger than the writer's buffers. */
+static const uint32 BsonCompressedMaxDocumentBlockSize = MAX_int32;
+
+/** Largest UncompressedSize / CompressedSize of a compressed block, the limit of deflate (zlib, gzip). */
+static const uint32 BsonCompressedMaxRatio = 1032;
+
+/** Set on blocks that are stored uncompressed because compressing didn't make them smaller. */
+static const uint32 BsonCompressedBlockStored = 1;
+
+
+/**
+* Checks the sizes of a block against what FBsonFileWriter writes: several documents fill at most one buffer,
+* a stored block is as large as its documents and a compressed one smaller, but not beyond BsonCompressedMaxRatio.
+*
+* @param BufferSize the writer's buffer size from the file header.
+*/
+inline bool IsBsonCompressedBlockSizeValid(const FBsonCompressedBlock& Block, uint32 BufferSize)
+{
+	// a document is at least its length header and the terminating zero
+	if (Block.NumDocuments == 0 || Block.UncompressedSize < (uint64)Block.NumDocuments * 5
+		|| Block.UncompressedSize > (Block.NumDocuments == 1 ? BsonCompressedMaxDocumentBlockSize : BufferSize))
+	{
+		return false;
+	}
+
+	if (Block.Flags & BsonCompressedBlockStored)
+	{
+		return Block.CompressedSize == Block.UncompressedSize;
+	}
+	return Block.CompressedSize < Block.UncompressedSize
+		&& Block.UncompressedSize <= (uint64)Block.CompressedSize * BsonCompressedMaxRatio;
+}
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BsonFieldSet.h"
+
+
+FBsonFieldSet::FBsonFieldSet(const TArray<FString>& FieldNames)
+{
+	for (const FString& FieldName : FieldNames)
+	{
+		Add(FieldName);
+	}
+}
+
+int32 FBsonFieldSet::Add(const FBsonKey& Key)
+{
+	int32 Index = Keys.Add(Key);
+
+	// a name that is already part of the set stays reachable through its first slot only
+	if (Find(Key) != INDEX_NONE)
+	{
+		return Index;
+	}
+	NumUniqueKeys++;
+
+	// keep the table at most half full
+	if (NumUniqueKeys * 2 > Buckets.Num())
+	{
+		Rehash();
+	}
+	else
+	{
+		Insert(Index);
+	}
+
+	return Index;
+}
+
+int32 FBsonFieldSet::Find(const FBsonKey& Key) const
+{
+	if (Buckets.Num() == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	int32 Mask = Buckets.Num() - 1;
+	for (int32 Bucket = Key.GetHash() & Mask; Buckets[Bucket] != INDEX_NONE; Bucket = (Bucket + 1) & Mask)
+	{
+		if (Keys[Buckets[Bucket]] == Key)
+		{
+			return Buckets[Bucket];
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+void FBsonFieldSet::Insert(int32 Index)
+{
+	int32 Mask = Buckets.Num() - 1;
+	int32 Bucket = Keys[Index].GetHash() & Mask;
+	while (Buckets[Bucket] != INDEX_NONE)
+	{
+		Bucket = (Bucket + 1) & Mask;
+	}
+	Buckets[Bucket] = Index;
+}
+
+void FBsonFieldSet::Rehash()
+{
+	Buckets.Init(INDEX_NONE, FMath::Max(8, (int32)FMath::RoundUpToPowerOfTwo(NumUniqueKeys * 4)));
+	for (int32 Index = 0; Index < Num(); Index++)
+	{
+		if (Find(Keys[Index]) == INDEX_NONE)
+		{
+			Insert(Index);
+		}
+	}
+}
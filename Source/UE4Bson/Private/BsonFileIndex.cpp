@@ -0,0 +1,348 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BsonFileIndex.h"
+#include "BsonObjectImpl.h"
+#include "UE4Bson.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+
+
+/**
+* Header of a sidecar file. The header and the entries are stored little-endian, like Bson itself.
+*/
+struct FBsonFileIndexHeader
+{
+	uint32 Magic;
+	uint32 Version;
+	uint32 Flags;
+
+	/** Length and CRC of the start of the first document, to detect a dump that was replaced since the last update. */
+	uint32 FirstDocumentLength;
+	uint32 FirstDocumentCrc;
+
+	uint32 Reserved;
+};
+
+static const uint32 BsonFileIndexMagic = 0x58495342; // "BSIX"
+static const uint32 BsonFileIndexVersion = 2;
+static const uint32 BsonFileIndexHasTimestamps = 1;
+
+/** Number of bytes at the start of the first document that FirstDocumentCrc covers. */
+static const int32 BsonFileIndexCheckedBytes = 64;
+
+/** Size of the blocks the dump is read in. */
+static const int32 BsonFileIndexReadBlockSize = 4 * 1024 * 1024;
+
+
+static int64 ReadDocumentLength(const uint8* Header)
+{
+	return (int32)((uint32)Header[0] | ((uint32)Header[1] << 8) | ((uint32)Header[2] << 16) | ((uint32)Header[3] << 24));
+}
+
+
+/**
+* Reads the length of the first document of a dump and the CRC of its first bytes.
+*
+* @return false if the dump doesn't hold a complete length header yet.
+*/
+static bool ReadFirstDocumentCheck(IFileHandle& DumpFile, int64 DumpSize, uint32& OutLength, uint32& OutCrc)
+{
+	uint8 Bytes[BsonFileIndexCheckedBytes];
+	const int32 NumBytes = (int32)FMath::Min<int64>(DumpSize, BsonFileIndexCheckedBytes);
+	if (NumBytes < 4 || !DumpFile.Seek(0) || !DumpFile.Read(Bytes, NumBytes))
+	{
+		return false;
+	}
+
+	OutLength = (uint32)ReadDocumentLength(Bytes);
+	OutCrc = FCrc::MemCrc32(Bytes, (int32)FMath::Min<uint32>(OutLength, NumBytes));
+	return true;
+}
+
+
+FString FBsonFileIndex::GetIndexFilename(const FString& DumpFilename)
+{
+	return DumpFilename + TEXT(".idx");
+}
+
+
+int64 FBsonFileIndex::Update(const FString& DumpFilename, const FString& IndexFilename)
+{
+	return UpdateIndex(DumpFilename, IndexFilename, nullptr);
+}
+
+
+int64 FBsonFileIndex::Update(const FString& DumpFilename, const FString& IndexFilename, const FString& TimestampField)
+{
+	const FTransientBsonKey TimestampKey(TimestampField);
+	return UpdateIndex(DumpFilename, IndexFilename, &TimestampKey);
+}
+
+
+int64 FBsonFileIndex::Update(const FString& DumpFilename, const FString& IndexFilename, const FBsonKey& TimestampKey)
+{
+	return UpdateIndex(DumpFilename, IndexFilename, &TimestampKey);
+}
+
+
+int64 FBsonFileIndex::UpdateIndex(const FString& DumpFilename, const FString& IndexFilename, const FBsonKey* TimestampKey)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	// Allow a writer to keep appending to the dump while it is indexed.
+	TUniquePtr<IFileHandle> DumpFile(PlatformFile.OpenRead(*DumpFilename, true));
+	if (!DumpFile.IsValid())
+	{
+		UE_LOG(LogBson, Error, TEXT("FBsonFileIndex: could not open %s."), *DumpFilename);
+		return INDEX_NONE;
+	}
+	const int64 DumpSize = DumpFile->Size();
+
+	const uint32 Flags = TimestampKey ? BsonFileIndexHasTimestamps : 0;
+	const int64 EntrySize = TimestampKey ? 2 * sizeof(int64) : sizeof(int64);
+
+	uint32 FirstDocumentLength = 0;
+	uint32 FirstDocumentCrc = 0;
+	ReadFirstDocumentCheck(*DumpFile, DumpSize, FirstDocumentLength, FirstDocumentCrc);
+
+	// Continue after the last indexed document if the sidecar exists and matches. A sidecar without
+	// entries is rebuilt, as it was written before the first document was there to check against.
+	int64 DumpOffset = 0;
+	int64 LastTimestamp = 0;
+	bool bAppend = false;
+	{
+		TUniquePtr<IFileHandle> IndexFile(PlatformFile.OpenRead(*IndexFilename));
+		FBsonFileIndexHeader Header;
+		if (IndexFile.IsValid()
+			&& IndexFile->Read((uint8*)&Header, sizeof(Header))
+			&& Header.Magic == BsonFileIndexMagic && Header.Version == BsonFileIndexVersion && Header.Flags == Flags
+			&& (IndexFile->Size() - (int64)sizeof(Header)) % EntrySize == 0)
+		{
+			if (IndexFile->Size() > (int64)sizeof(Header))
+			{
+				int64 LastEntry[2] = { 0, 0 };
+				uint8 LengthHeader[4];
+				uint8 Terminator = 1;
+				int64 LastLength = 0;
+				bAppend = Header.FirstDocumentLength == FirstDocumentLength && Header.FirstDocumentCrc == FirstDocumentCrc
+					&& IndexFile->Seek(IndexFile->Size() - EntrySize) && IndexFile->Read((uint8*)LastEntry, EntrySize)
+					&& LastEntry[0] >= 0 && LastEntry[0] + 4 <= DumpSize
+					&& DumpFile->Seek(LastEntry[0]) && DumpFile->Read(LengthHeader, 4);
+				if (bAppend)
+				{
+					// the last indexed document must be complete and terminated in this dump
+					LastLength = ReadDocumentLength(LengthHeader);
+					bAppend = LastLength >= 5 && LastEntry[0] + LastLength <= DumpSize
+						&& DumpFile->Seek(LastEntry[0] + LastLength - 1) && DumpFile->Read(&Terminator, 1) && Terminator == 0;
+				}
+
+				if (bAppend)
+				{
+					DumpOffset = LastEntry[0] + LastLength;
+					LastTimestamp = LastEntry[1];
+				}
+				else
+				{
+					UE_LOG(LogBson, Warning, TEXT("FBsonFileIndex: %s doesn't match %s, rebuilding it."), *IndexFilename, *DumpFilename);
+				}
+			}
+		}
+		else if (IndexFile.IsValid())
+		{
+			UE_LOG(LogBson, Warning, TEXT("FBsonFileIndex: %s is not an index of this kind, rebuilding it."), *IndexFilename);
+		}
+	}
+
+	if (!DumpFile->Seek(DumpOffset))
+	{
+		return INDEX_NONE;
+	}
+
+	// Offsets, or pairs of offset and timestamp.
+	TArray<int64> Entries;
+
+	// The dump is read in large blocks, Buffer[0] is at BufferStart in the file.
+	TArray<uint8> Buffer;
+	Buffer.SetNumUninitialized(BsonFileIndexReadBlockSize);
+	int64 BufferStart = DumpOffset;
+	int32 Cursor = 0;
+	int32 Filled = 0;
+
+	auto Refill = [&]() -> bool
+	{
+		if (Cursor > 0)
+		{
+			FMemory::Memmove(Buffer.GetData(), Buffer.GetData() + Cursor, Filled - Cursor);
+			BufferStart += Cursor;
+			Filled -= Cursor;
+			Cursor = 0;
+		}
+		const int64 BytesToRead = FMath::Min<int64>(Buffer.Num() - Filled, DumpSize - (BufferStart + Filled));
+		if (BytesToRead <= 0 || !DumpFile->Read(Buffer.GetData() + Filled, BytesToRead))
+		{
+			return false;
+		}
+		Filled += (int32)BytesToRead;
+		return true;
+	};
+
+	while (true)
+	{
+		if (Filled - Cursor < 4)
+		{
+			if (!Refill())
+			{
+				break;
+			}
+			continue;
+		}
+
+		const int64 DocumentOffset = BufferStart + Cursor;
+		const int64 Length = ReadDocumentLength(Buffer.GetData() + Cursor);
+		if (Length < 5)
+		{
+			UE_LOG(LogBson, Error, TEXT("FBsonFileIndex: corrupt document at offset %lld of %s."), DocumentOffset, *DumpFilename);
+			break;
+		}
+		if (DocumentOffset + Length > DumpSize)
+		{
+			// Still being written.
+			break;
+		}
+
+		if (Filled - Cursor < Length)
+		{
+			if (TimestampKey)
+			{
+				if (Length > Buffer.Num())
+				{
+					Buffer.SetNumUninitialized((int32)Length);
+				}
+				if (!Refill())
+				{
+					break;
+				}
+				continue;
+			}
+
+			// Only the offset is needed, skip the document without reading it.
+			if (!DumpFile->Seek(DocumentOffset + Length))
+			{
+				break;
+			}
+			Entries.Add(DocumentOffset);
+			BufferStart = DocumentOffset + Length;
+			Cursor = 0;
+			Filled = 0;
+			continue;
+		}
+
+		const uint8* Document = Buffer.GetData() + Cursor;
+		if (Document[Length - 1] != 0)
+		{
+			UE_LOG(LogBson, Error, TEXT("FBsonFileIndex: corrupt document at offset %lld of %s."), DocumentOffset, *DumpFilename);
+			break;
+		}
+
+		Entries.Add(DocumentOffset);
+		if (TimestampKey)
+		{
+			FBsonValueView View;
+			int64 Timestamp;
+			if (FBsonObject::Borrow(Document, (uint32)Length).TryGetFieldView(*TimestampKey, View) && View.TryGetNumber(Timestamp))
+			{
+				LastTimestamp = Timestamp;
+			}
+			Entries.Add(LastTimestamp);
+		}
+		Cursor += (int32)Length;
+	}
+
+	TUniquePtr<IFileHandle> IndexFile(PlatformFile.OpenWrite(*IndexFilename, bAppend));
+	if (!IndexFile.IsValid())
+	{
+		UE_LOG(LogBson, Error, TEXT("FBsonFileIndex: could not open %s for writing."), *IndexFilename);
+		return INDEX_NONE;
+	}
+
+	if (!bAppend)
+	{
+		FBsonFileIndexHeader Header = { BsonFileIndexMagic, BsonFileIndexVersion, Flags, FirstDocumentLength, FirstDocumentCrc, 0 };
+		if (!IndexFile->Write((const uint8*)&Header, sizeof(Header)))
+		{
+			return INDEX_NONE;
+		}
+	}
+
+	if (Entries.Num() > 0 && !IndexFile->Write((const uint8*)Entries.GetData(), Entries.Num() * sizeof(int64)))
+	{
+		UE_LOG(LogBson, Error, TEXT("FBsonFileIndex: could not write %s."), *IndexFilename);
+		return INDEX_NONE;
+	}
+
+	return Entries.Num() * (int64)sizeof(int64) / EntrySize;
+}
+
+
+bool FBsonFileIndex::Load(const FString& IndexFilename)
+{
+	Offsets.Reset();
+	Timestamps.Reset();
+	bTimestamps = false;
+
+	TArray<uint8> Bytes;
+	FBsonFileIndexHeader Header;
+	if (!FFileHelper::LoadFileToArray(Bytes, *IndexFilename) || Bytes.Num() < (int32)sizeof(Header))
+	{
+		return false;
+	}
+
+	FMemory::Memcpy(&Header, Bytes.GetData(), sizeof(Header));
+	if (Header.Magic != BsonFileIndexMagic || Header.Version != BsonFileIndexVersion)
+	{
+		UE_LOG(LogBson, Error, TEXT("FBsonFileIndex: %s is not an index."), *IndexFilename);
+		return false;
+	}
+
+	// A partial entry at the end is ignored, Update() rebuilds such an index.
+	bTimestamps = (Header.Flags & BsonFileIndexHasTimestamps) != 0;
+	const int32 EntrySize = bTimestamps ? 2 * sizeof(int64) : sizeof(int64);
+	const int32 NumEntries = (Bytes.Num() - (int32)sizeof(Header)) / EntrySize;
+
+	const uint8* Entry = Bytes.GetData() + sizeof(Header);
+	Offsets.SetNumUninitialized(NumEntries);
+	if (bTimestamps)
+	{
+		Timestamps.SetNumUninitialized(NumEntries);
+	}
+	for (int32 Index = 0; Index < NumEntries; Index++, Entry += EntrySize)
+	{
+		FMemory::Memcpy(&Offsets[Index], Entry, sizeof(int64));
+		if (bTimestamps)
+		{
+			FMemory::Memcpy(&Timestamps[Index], Entry + sizeof(int64), sizeof(int64));
+		}
+	}
+	return true;
+}
+
+
+int32 FBsonFileIndex::FindTimestamp(int64 Timestamp) const
+{
+	int32 First = 0;
+	int32 Count = Timestamps.Num();
+	while (Count > 0)
+	{
+		const int32 Step = Count / 2;
+		if (Timestamps[First + Step] < Timestamp)
+		{
+			First += Step + 1;
+			Count -= Step + 1;
+		}
+		else
+		{
+			Count = Step;
+		}
+	}
+	return First < Timestamps.Num() ? First : INDEX_NONE;
+}
@@ -0,0 +1,232 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BsonFileReader.h"
+#include "BsonObject.h"
+#include "UE4Bson.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+
+
+/** A document is at least its length header and the terminating zero. */
+static const int64 MinDocumentLength = 5;
+
+
+FBsonFileReader::FBsonFileReader(const FString& InFilename)
+	: Filename(InFilename), Data(nullptr), Size(0), Offset(0), bError(false)
+{
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (!MappedFile.IsValid())
+	{
+		UE_LOG(LogBson, Error, TEXT("FBsonFileReader: could not open %s for mapping."), *Filename);
+		return;
+	}
+
+	Size = MappedFile->GetFileSize();
+	if (Size == 0)
+	{
+		return;
+	}
+
+	MappedRegion.Reset(MappedFile->MapRegion(0, Size));
+	if (!MappedRegion.IsValid())
+	{
+		UE_LOG(LogBson, Error, TEXT("FBsonFileReader: could not map %s."), *Filename);
+		MappedFile.Reset();
+		Size = 0;
+		return;
+	}
+
+	Data = MappedRegion->GetMappedPtr();
+}
+
+
+FBsonFileReader::~FBsonFileReader()
+{
+	// The region has to be unmapped before the file is closed.
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+
+bool FBsonFileReader::IsOpen() const
+{
+	return MappedFile.IsValid();
+}
+
+
+bool FBsonFileReader::Next(FBsonObject& OutObject)
+{
+	TArrayView<const uint8> Document;
+	if (!Next(Document))
+	{
+		return false;
+	}
+
+	OutObject.SetBorrowed(Document.GetData(), Document.Num());
+	return true;
+}
+
+
+bool FBsonFileReader::Next(TArrayView<const uint8>& OutDocument)
+{
+	if (bError || Offset >= Size)
+	{
+		return false;
+	}
+
+	if (!ReadDocumentAt(Offset, OutDocument))
+	{
+		UE_LOG(LogBson, Error, TEXT("FBsonFileReader: corrupt document at offset %lld."), Offset);
+		bError = true;
+		return false;
+	}
+
+	Offset += OutDocument.Num();
+	return true;
+}
+
+
+bool FBsonFileReader::ReadDocumentAt(int64 InOffset, TArrayView<const uint8>& OutDocument) const
+{
+	const int64 Remaining = Size - InOffset;
+	if (InOffset < 0 || Remaining < MinDocumentLength)
+	{
+		return false;
+	}
+
+	// The length header is a little-endian int32 that includes itself.
+	const uint8* Header = Data + InOffset;
+	const int64 Length = (int32)((uint32)Header[0] | ((uint32)Header[1] << 8) | ((uint32)Header[2] << 16) | ((uint32)Header[3] << 24));
+	if (Length < MinDocumentLength || Length > Remaining || Header[Length - 1] != 0)
+	{
+		return false;
+	}
+
+	OutDocument = TArrayView<const uint8>(Header, (int32)Length);
+	return true;
+}
+
+
+TArray<FBsonFileChunk> FBsonFileReader::SplitIntoChunks(int32 NumChunks) const
+{
+	TArray<FBsonFileChunk> Chunks;
+	if (Size == 0 || NumChunks < 1)
+	{
+		return Chunks;
+	}
+
+	FBsonFileChunk Chunk;
+	Chunk.Begin = 0;
+	Chunk.End = Size;
+	Chunk.FirstDocument = 0;
+
+	if (Index.Num() > 0)
+	{
+		// Split by document count, the last chunk also covers the documents after the index.
+		NumChunks = FMath::Min(NumChunks, Index.Num());
+		for (int32 ChunkIndex = 1; ChunkIndex < NumChunks; ChunkIndex++)
+		{
+			const int32 First = (int32)((int64)Index.Num() * ChunkIndex / NumChunks);
+			const int64 Begin = Index.GetOffset(First);
+			if (Begin <= Chunk.Begin || Begin >= Size)
+			{
+				break;
+			}
+			Chunk.End = Begin;
+			Chunks.Add(Chunk);
+			Chunk.Begin = Begin;
+			Chunk.End = Size;
+			Chunk.FirstDocument = First;
+		}
+		Chunks.Add(Chunk);
+		return Chunks;
+	}
+
+	// Split by size, walking the length headers. A corrupt document ends the walk, the last chunk
+	// still reaches the end of the file so the scan runs into it and reports it.
+	const int64 TargetSize = FMath::Max<int64>(Size / NumChunks, 1);
+	int64 Position = 0;
+	int64 Document = 0;
+	TArrayView<const uint8> Bytes;
+	while (ReadDocumentAt(Position, Bytes))
+	{
+		Position += Bytes.Num();
+		Document++;
+		if (Position - Chunk.Begin >= TargetSize && Position < Size && Chunks.Num() < NumChunks - 1)
+		{
+			Chunk.End = Position;
+			Chunks.Add(Chunk);
+			Chunk.Begin = Position;
+			Chunk.End = Size;
+			Chunk.FirstDocument = Document;
+		}
+	}
+	Chunks.Add(Chunk);
+	return Chunks;
+}
+
+
+void FBsonFileReader::Seek(int64 InOffset)
+{
+	Offset = FMath::Clamp<int64>(InOffset, 0, Size);
+	bError = false;
+}
+
+
+bool FBsonFileReader::LoadIndex(const FString& IndexFilename)
+{
+	return Index.Load(IndexFilename.IsEmpty() ? FBsonFileIndex::GetIndexFilename(Filename) : IndexFilename);
+}
+
+
+bool FBsonFileReader::SeekToDocument(int64 DocumentIndex)
+{
+	if (DocumentIndex < 0)
+	{
+		return false;
+	}
+
+	int64 Start = 0;
+	int64 Skip = DocumentIndex;
+	if (Index.Num() > 0)
+	{
+		const int32 Indexed = (int32)FMath::Min<int64>(DocumentIndex, Index.Num() - 1);
+		Start = Index.GetOffset(Indexed);
+		Skip = DocumentIndex - Indexed;
+	}
+
+	if (Start >= Size)
+	{
+		return false;
+	}
+
+	Seek(Start);
+	TArrayView<const uint8> Document;
+	for (; Skip > 0; Skip--)
+	{
+		if (!Next(Document))
+		{
+			return false;
+		}
+	}
+	return Offset < Size;
+}
+
+
+bool FBsonFileReader::SeekToTimestamp(int64 Timestamp)
+{
+	if (!Index.HasTimestamps())
+	{
+		UE_LOG(LogBson, Warning, TEXT("FBsonFileReader: no index with timestamps loaded for %s."), *Filename);
+		return false;
+	}
+
+	const int32 Found = Index.FindTimestamp(Timestamp);
+	if (Found == INDEX_NONE || Index.GetOffset(Found) >= Size)
+	{
+		return false;
+	}
+
+	Seek(Index.GetOffset(Found));
+	return true;
+}
@@ -0,0 +1,672 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BsonFileWriter.h"
+#include "BsonObject.h"
+#include "BsonObjectImpl.h"
+#include "BsonCompressedFormat.h"
+#include "UE4Bson.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Paths.h"
+#include "Misc/Compression.h"
+
+
+/**
+* The background thread of an FBsonFileWriter, together with everything it shares with the writer:
+* the file, the pool of buffers, the queue of full buffers and the buffer that is being filled.
+*/
+class FBsonFileWriterThread : public FRunnable
+{
+public:
+
+	typedef FBsonFileWriter::FBuffer FBuffer;
+
+	FBsonFileWriterThread(IFileHandle* InFile, const FBsonFileWriterSettings& InSettings)
+		: File(InFile)
+		, Settings(InSettings)
+		, bFlushRequested(false)
+		, bStopping(false)
+		, DroppedDocuments(0)
+		, WrittenBytes(0)
+		, Current(nullptr)
+		, CurrentStartTime(0)
+		, LastFlushTime(FPlatformTime::Seconds())
+		, bCompressed(!InSettings.CompressionFormat.IsNone())
+		, bWriteFailed(false)
+		, FileOffset(0)
+		, NextDocument(0)
+	{
+		if (bCompressed)
+		{
+			WriteFileHeader();
+		}
+
+		// One buffer being filled, one being written, the rest queued.
+		MaxBuffers = FMath::Max(Settings.MaxQueuedBuffers, 1) + 2;
+
+		WorkEvent = FPlatformProcess::GetSynchEventFromPool();
+		BufferReturnedEvent = FPlatformProcess::GetSynchEventFromPool();
+		FlushedEvent = FPlatformProcess::GetSynchEventFromPool();
+		RunnableThread = FRunnableThread::Create(this, TEXT("BsonFileWriter"), 0, TPri_BelowNormal);
+	}
+
+	virtual ~FBsonFileWriterThread()
+	{
+		delete RunnableThread;
+		FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+		FPlatformProcess::ReturnSynchEventToPool(BufferReturnedEvent);
+		FPlatformProcess::ReturnSynchEventToPool(FlushedEvent);
+		for (FBuffer* Buffer : Buffers)
+		{
+			FBsonObject::FreeReleasedBuffer(Buffer->Released);
+			delete Buffer;
+		}
+		delete File;
+	}
+
+	/**
+	* Returns an empty buffer from the pool, allocating one if the pool is not at its limit yet.
+	* Otherwise applies the overflow policy of the settings.
+	*
+	* @return the buffer, nullptr if the document has to be dropped.
+	*/
+	FBuffer* AcquireBuffer()
+	{
+		while (true)
+		{
+			{
+				FScopeLock Lock(&QueueLock);
+				if (FreeBuffers.Num() > 0)
+				{
+					return FreeBuffers.Pop(false);
+				}
+
+				if (Buffers.Num() < MaxBuffers)
+				{
+					FBuffer* Buffer = new FBuffer();
+					Buffer->Data.Reserve(Settings.BufferSize);
+					Buffers.Add(Buffer);
+					return Buffer;
+				}
+
+				if (Settings.Overflow == EBsonFileWriterOverflow::DropNewest)
+				{
+					return nullptr;
+				}
+
+				if (Settings.Overflow == EBsonFileWriterOverflow::DropOldest && QueuedBuffers.Num() > 0)
+				{
+					FBuffer* Oldest = QueuedBuffers[0];
+					QueuedBuffers.RemoveAt(0, 1, false);
+					DroppedDocuments += Oldest->NumDocuments;
+					ResetBuffer(Oldest);
+					return Oldest;
+				}
+			}
+
+			BufferReturnedEvent->Wait();
+		}
+	}
+
+	/** Queues a buffer with documents for writing. */
+	void Submit(FBuffer* Buffer)
+	{
+		{
+			FScopeLock Lock(&QueueLock);
+			QueuedBuffers.Add(Buffer);
+		}
+		WorkEvent->Trigger();
+	}
+
+	/**
+	* Copies a document into the current buffer. A full buffer is queued first, and a new one is acquired
+	* without holding CurrentLock, as waiting for a free buffer needs the background thread.
+	*
+	* @return false if the document was dropped.
+	*/
+	bool Append(const uint8* Data, uint32 Length)
+	{
+		{
+			FScopeLock Lock(&CurrentLock);
+			if (Current && (uint32)Current->Data.Num() + Length <= Settings.BufferSize)
+			{
+				Current->Data.Append(Data, Length);
+				Current->NumDocuments++;
+				return true;
+			}
+			SubmitCurrent();
+		}
+
+		FBuffer* Buffer = AcquireBuffer();
+		if (!Buffer)
+		{
+			AddDropped(1);
+			return false;
+		}
+
+		// A document larger than BufferSize gets a buffer of its own, which grows to fit.
+		Buffer->Data.Append(Data, Length);
+		Buffer->NumDocuments = 1;
+
+		FScopeLock Lock(&CurrentLock);
+		Current = Buffer;
+		CurrentStartTime = FPlatformTime::Seconds();
+		return true;
+	}
+
+	/**
+	* Queues a document obtained from FBsonObject::Release() on its own, after the current buffer.
+	*
+	* @return false if the document was dropped, it is freed then.
+	*/
+	bool AppendReleased(uint8* Data, uint32 Length)
+	{
+		HandOverCurrent();
+
+		FBuffer* Buffer = AcquireBuffer();
+		if (!Buffer)
+		{
+			FBsonObject::FreeReleasedBuffer(Data);
+			AddDropped(1);
+			return false;
+		}
+
+		Buffer->Released = Data;
+		Buffer->ReleasedLength = Length;
+		Buffer->NumDocuments = 1;
+		Submit(Buffer);
+		return true;
+	}
+
+	/** Queues the current buffer, if there is one. */
+	void HandOverCurrent()
+	{
+		FScopeLock Lock(&CurrentLock);
+		SubmitCurrent();
+	}
+
+	/** Counts documents the writer dropped itself. */
+	void AddDropped(uint64 Count)
+	{
+		FScopeLock Lock(&QueueLock);
+		DroppedDocuments += Count;
+	}
+
+	/** Waits until all queued buffers are written and the file is flushed to disk. */
+	void WaitForFlush()
+	{
+		{
+			FScopeLock Lock(&QueueLock);
+			bFlushRequested = true;
+		}
+		WorkEvent->Trigger();
+		FlushedEvent->Wait();
+	}
+
+	/** Writes the remaining buffers and waits for the thread to exit. */
+	void StopAndWait()
+	{
+		Stop();
+		RunnableThread->WaitForCompletion();
+	}
+
+	void GetTotals(FBsonFileStats& OutStats, uint64& OutDroppedDocuments, uint64& OutWrittenBytes)
+	{
+		FScopeLock Lock(&QueueLock);
+		OutStats = Stats;
+		OutDroppedDocuments = DroppedDocuments;
+		OutWrittenBytes = WrittenBytes;
+	}
+
+	// FRunnable
+
+	virtual uint32 Run() override
+	{
+		while (true)
+		{
+			const double WaitSeconds = Settings.FlushIntervalSeconds > 0 ? QueueStaleBuffer() : -1.0;
+
+			FBuffer* Buffer = nullptr;
+			bool bFlush = false;
+			bool bExit = false;
+			{
+				FScopeLock Lock(&QueueLock);
+				if (QueuedBuffers.Num() > 0)
+				{
+					Buffer = QueuedBuffers[0];
+					QueuedBuffers.RemoveAt(0, 1, false);
+				}
+				else
+				{
+					bFlush = bFlushRequested;
+					bFlushRequested = false;
+					bExit = bStopping;
+				}
+			}
+
+			if (Buffer)
+			{
+				WriteBuffer(Buffer);
+				FlushFile(false);
+				ReturnBuffer(Buffer);
+				continue;
+			}
+
+			if (bFlush || bExit)
+			{
+				if (bExit && bCompressed)
+				{
+					WriteBlockIndex();
+				}
+				FlushFile(true);
+				if (bFlush)
+				{
+					FlushedEvent->Trigger();
+				}
+				if (bExit)
+				{
+					return 0;
+				}
+				continue;
+			}
+
+			WorkEvent->Wait(WaitSeconds >= 0 ? (uint32)(WaitSeconds * 1000.0) + 1 : MAX_uint32);
+			FlushFile(false);
+		}
+	}
+
+	virtual void Stop() override
+	{
+		{
+			FScopeLock Lock(&QueueLock);
+			bStopping = true;
+		}
+		WorkEvent->Trigger();
+	}
+
+private:
+
+	/** Queues the current buffer, the caller holds CurrentLock. */
+	void SubmitCurrent()
+	{
+		if (Current)
+		{
+			Submit(Current);
+			Current = nullptr;
+		}
+	}
+
+	/**
+	* Queues the current buffer once it is older than the flush interval. It goes behind all buffers
+	* queued before it was started, so documents stay in order.
+	*
+	* @return the seconds until the current buffer or the next flush is due.
+	*/
+	double QueueStaleBuffer()
+	{
+		FScopeLock Lock(&CurrentLock);
+		if (Current)
+		{
+			const double Age = FPlatformTime::Seconds() - CurrentStartTime;
+			if (Age < Settings.FlushIntervalSeconds)
+			{
+				return Settings.FlushIntervalSeconds - Age;
+			}
+			SubmitCurrent();
+		}
+		return Settings.FlushIntervalSeconds;
+	}
+
+	void WriteBuffer(FBuffer* Buffer)
+	{
+		uint32 FileBytes = Buffer->Num();
+		double CompressionSeconds = 0;
+		bool bWritten;
+		if (bCompressed)
+		{
+			bWritten = WriteBlock(*Buffer, FileBytes, CompressionSeconds);
+		}
+		else
+		{
+			bWritten = File->Write(Buffer->GetData(), Buffer->Num());
+		}
+
+		if (!bWritten)
+		{
+			UE_LOG(LogBson, Error, TEXT("FBsonFileWriter: failed to write %d documents."), Buffer->NumDocuments);
+		}
+
+		FScopeLock Lock(&QueueLock);
+		if (bWritten)
+		{
+			Stats.Documents += Buffer->NumDocuments;
+			Stats.UncompressedBytes += Buffer->Num();
+			Stats.FileBytes += FileBytes;
+			Stats.CompressionSeconds += CompressionSeconds;
+			WrittenBytes += FileBytes;
+		}
+		else
+		{
+			DroppedDocuments += Buffer->NumDocuments;
+		}
+		bPendingFlush = true;
+	}
+
+	void WriteFileHeader()
+	{
+		FBsonCompressedFileHeader Header;
+		FMemory::Memzero(Header);
+		Header.Magic = BsonCompressedFileMagic;
+		Header.Version = BsonCompressedFileVersion;
+		FCStringAnsi::Strncpy(Header.Format, TCHAR_TO_ANSI(*Settings.CompressionFormat.ToString()), sizeof(Header.Format));
+		Header.BufferSize = Settings.BufferSize;
+
+		bWriteFailed = !File->Write((const uint8*)&Header, sizeof(Header));
+		FileOffset = sizeof(Header);
+
+		FScopeLock Lock(&QueueLock);
+		WrittenBytes += sizeof(Header);
+	}
+
+	/**
+	* Compresses a buffer and writes it as an independent block.
+	* After a failed write the offsets are unknown, so all later blocks are dropped as well.
+	*/
+	bool WriteBlock(const FBuffer& Buffer, uint32& OutFileBytes, double& OutCompressionSeconds)
+	{
+		if (bWriteFailed)
+		{
+			return false;
+		}
+
+		const FName Format = Settings.CompressionFormat;
+		const int32 UncompressedSize = Buffer.Num();
+		const double StartTime = FPlatformTime::Seconds();
+		CompressedData.SetNumUninitialized(FCompression::CompressMemoryBound(Format, UncompressedSize), false);
+		int32 CompressedSize = CompressedData.Num();
+		// readers reject compression ratios beyond BsonCompressedMaxRatio as corrupt, such a block is stored
+		const bool bCompressedBlock = FCompression::CompressMemory(Format, CompressedData.GetData(), CompressedSize, Buffer.GetData(), UncompressedSize)
+			&& CompressedSize < UncompressedSize && UncompressedSize <= (int64)CompressedSize * BsonCompressedMaxRatio;
+		OutCompressionSeconds = FPlatformTime::Seconds() - StartTime;
+
+		FBsonCompressedBlockHeader Header;
+		Header.Magic = BsonCompressedBlockMagic;
+		Header.Flags = bCompressedBlock ? 0 : BsonCompressedBlockStored;
+		Header.CompressedSize = bCompressedBlock ? CompressedSize : UncompressedSize;
+		Header.UncompressedSize = UncompressedSize;
+		Header.NumDocuments = Buffer.NumDocuments;
+		Header.Reserved = 0;
+
+		const uint8* Payload = bCompressedBlock ? CompressedData.GetData() : Buffer.GetData();
+		if (!File->Write((const uint8*)&Header, sizeof(Header)) || !File->Write(Payload, Header.CompressedSize))
+		{
+			bWriteFailed = true;
+			return false;
+		}
+
+		FBsonCompressedBlock& Block = Blocks.AddDefaulted_GetRef();
+		Block.Offset = FileOffset + sizeof(Header);
+		Block.FirstDocument = NextDocument;
+		Block.CompressedSize = Header.CompressedSize;
+		Block.UncompressedSize = Header.UncompressedSize;
+		Block.NumDocuments = Header.NumDocuments;
+		Block.Flags = Header.Flags;
+
+		OutFileBytes = sizeof(Header) + Header.CompressedSize;
+		FileOffset += OutFileBytes;
+		NextDocument += Buffer.NumDocuments;
+		return true;
+	}
+
+	/** Appends the block index and the footer, which let readers find any block without walking the file. */
+	void WriteBlockIndex()
+	{
+		FBsonCompressedFileFooter Footer;
+		Footer.IndexOffset = FileOffset;
+		Footer.NumBlocks = Blocks.Num();
+		Footer.Magic = BsonCompressedFooterMagic;
+
+		const int64 IndexSize = Blocks.Num() * sizeof(FBsonCompressedBlock);
+		if (bWriteFailed
+			|| !File->Write((const uint8*)Blocks.GetData(), IndexSize)
+			|| !File->Write((const uint8*)&Footer, sizeof(Footer)))
+		{
+			UE_LOG(LogBson, Error, TEXT("FBsonFileWriter: failed to write the block index, readers will have to walk the blocks."));
+			return;
+		}
+
+		bPendingFlush = true;
+		FScopeLock Lock(&QueueLock);
+		WrittenBytes += IndexSize + sizeof(Footer);
+	}
+
+	/** Flushes the file to disk if anything was written and the flush interval has passed, or if forced. */
+	void FlushFile(bool bForce)
+	{
+		const double Now = FPlatformTime::Seconds();
+		if (bPendingFlush && (bForce || Now - LastFlushTime >= Settings.FlushIntervalSeconds))
+		{
+			File->Flush(true);
+			bPendingFlush = false;
+			LastFlushTime = Now;
+		}
+	}
+
+	/** Empties a written or dropped buffer for reuse. */
+	void ResetBuffer(FBuffer* Buffer)
+	{
+		// A single large document may have grown the buffer, don't keep that memory around.
+		if ((uint32)Buffer->Data.Max() > Settings.BufferSize)
+		{
+			Buffer->Data.Empty(Settings.BufferSize);
+		}
+		else
+		{
+			Buffer->Data.Reset();
+		}
+		Buffer->NumDocuments = 0;
+
+		FBsonObject::FreeReleasedBuffer(Buffer->Released);
+		Buffer->Released = nullptr;
+		Buffer->ReleasedLength = 0;
+	}
+
+	void ReturnBuffer(FBuffer* Buffer)
+	{
+		ResetBuffer(Buffer);
+
+		{
+			FScopeLock Lock(&QueueLock);
+			FreeBuffers.Add(Buffer);
+		}
+		BufferReturnedEvent->Trigger();
+	}
+
+	IFileHandle* File;
+	FBsonFileWriterSettings Settings;
+	FRunnableThread* RunnableThread;
+
+	/** Wakes the thread when a buffer is queued, a flush is requested or the thread is stopped. */
+	FEvent* WorkEvent;
+	/** Wakes a writer blocked in AcquireBuffer(). */
+	FEvent* BufferReturnedEvent;
+	/** Wakes a writer waiting in WaitForFlush(). */
+	FEvent* FlushedEvent;
+
+	/** Guards everything below. */
+	FCriticalSection QueueLock;
+	TArray<FBuffer*> Buffers;
+	TArray<FBuffer*> FreeBuffers;
+	TArray<FBuffer*> QueuedBuffers;
+	int32 MaxBuffers;
+	bool bFlushRequested;
+	bool bStopping;
+	FBsonFileStats Stats;
+	uint64 DroppedDocuments;
+	/** All bytes written, Stats.FileBytes plus the file header, block index and footer of compressed files. */
+	uint64 WrittenBytes;
+
+	/**
+	* The buffer Write() appends to, nullptr until the next document is written. Guarded by CurrentLock,
+	* which the background thread takes to queue it once it is older than the flush interval.
+	* Taken before QueueLock where both are held.
+	*/
+	FCriticalSection CurrentLock;
+	FBuffer* Current;
+	double CurrentStartTime;
+
+	/** Only used by the background thread. */
+	bool bPendingFlush = false;
+	double LastFlushTime;
+
+	/** Block format state, only used by the background thread. */
+	const bool bCompressed;
+	bool bWriteFailed;
+	int64 FileOffset;
+	int64 NextDocument;
+	TArray<uint8> CompressedData;
+	TArray<FBsonCompressedBlock> Blocks;
+};
+
+
+FBsonFileWriter::FBsonFileWriter(const FString& Filename, const FBsonFileWriterSettings& InSettings)
+	: Settings(InSettings), DroppedDocuments(0), WrittenBytes(0)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Filename));
+
+	if (Settings.bAppend && !Settings.CompressionFormat.IsNone())
+	{
+		UE_LOG(LogBson, Warning, TEXT("FBsonFileWriter: compressed files can't be appended to, replacing %s."), *Filename);
+		Settings.bAppend = false;
+	}
+
+	IFileHandle* File = PlatformFile.OpenWrite(*Filename, Settings.bAppend);
+	if (!File)
+	{
+		UE_LOG(LogBson, Error, TEXT("FBsonFileWriter: could not open %s for writing."), *Filename);
+		return;
+	}
+
+	Thread = MakeUnique<FBsonFileWriterThread>(File, Settings);
+}
+
+
+FBsonFileWriter::~FBsonFileWriter()
+{
+	Close();
+}
+
+
+bool FBsonFileWriter::IsOpen() const
+{
+	return Thread.IsValid();
+}
+
+
+bool FBsonFileWriter::Write(const FBsonObject& Object)
+{
+	return Write(Object.GetDataPointer(), Object.GetDataLength());
+}
+
+
+bool FBsonFileWriter::Write(FBsonObject&& Object)
+{
+	if (!Thread.IsValid())
+	{
+		return false;
+	}
+
+	// small documents are cheaper to copy into the current buffer than to write on their own,
+	// and an arena may free its documents before the background thread gets to them
+	if (Object.GetDataLength() < Settings.BufferSize / 2 || Object.ReadImpl().Arena)
+	{
+		const bool bWritten = Write(Object.GetDataPointer(), Object.GetDataLength());
+		Object.Reset();
+		return bWritten;
+	}
+
+	uint32 Length;
+	uint8* Data = Object.Release(Length);
+	return Thread->AppendReleased(Data, Length);
+}
+
+
+bool FBsonFileWriter::Write(const uint8* Data, uint32 Length)
+{
+	if (!Thread.IsValid())
+	{
+		return false;
+	}
+
+	return Thread->Append(Data, Length);
+}
+
+
+void FBsonFileWriter::Flush()
+{
+	if (!Thread.IsValid())
+	{
+		return;
+	}
+
+	Thread->HandOverCurrent();
+	Thread->WaitForFlush();
+}
+
+
+void FBsonFileWriter::Close()
+{
+	if (!Thread.IsValid())
+	{
+		return;
+	}
+
+	Thread->HandOverCurrent();
+	Thread->StopAndWait();
+	Thread->GetTotals(Stats, DroppedDocuments, WrittenBytes);
+	Thread.Reset();
+}
+
+
+uint64 FBsonFileWriter::GetWrittenBytes() const
+{
+	if (Thread.IsValid())
+	{
+		FBsonFileStats CurrentStats;
+		uint64 Dropped;
+		uint64 Written;
+		Thread->GetTotals(CurrentStats, Dropped, Written);
+		return Written;
+	}
+	return WrittenBytes;
+}
+
+
+FBsonFileStats FBsonFileWriter::GetStats() const
+{
+	if (Thread.IsValid())
+	{
+		FBsonFileStats CurrentStats;
+		uint64 Dropped;
+		uint64 Written;
+		Thread->GetTotals(CurrentStats, Dropped, Written);
+		return CurrentStats;
+	}
+	return Stats;
+}
+
+
+uint64 FBsonFileWriter::GetDroppedDocuments() const
+{
+	if (Thread.IsValid())
+	{
+		FBsonFileStats CurrentStats;
+		uint64 Dropped;
+		uint64 Written;
+		Thread->GetTotals(CurrentStats, Dropped, Written);
+		return Dropped;
+	}
+	return DroppedDocuments;
+}
@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BsonKey.h"
+
+
+FBsonKey::FBsonKey(const FString& Name)
+{
+	Intern(*Name);
+}
+
+FBsonKey::FBsonKey(FName Name)
+{
+	// the display index and number identify the exact spelling of a name, also with case preserving names
+	static FCriticalSection NameLock;
+	static TMap<uint64, FBsonKey> NameKeys;
+
+	const uint64 NameId = ((uint64)(uint32)Name.GetDisplayIndex() << 32) | (uint32)Name.GetNumber();
+	{
+		FScopeLock Lock(&NameLock);
+		if (const FBsonKey* Found = NameKeys.Find(NameId))
+		{
+			*this = *Found;
+			return;
+		}
+	}
+
+	Intern(*Name.ToString());
+
+	FScopeLock Lock(&NameLock);
+	NameKeys.Add(NameId, *this);
+}
+
+FString FBsonKey::ToString() const
+{
+	FUTF8ToTCHAR Converted(Utf8, Length);
+	return FString(Converted.Length(), Converted.Get());
+}
+
+void FBsonKey::Intern(const TCHAR* Name)
+{
+	// the converted names are never freed, a TArray keeps its allocation when the map relocates it
+	static FCriticalSection InternLock;
+	static TMap<FString, TArray<ANSICHAR>> InternedKeys;
+
+	FScopeLock Lock(&InternLock);
+
+	TArray<ANSICHAR>* Interned = InternedKeys.Find(Name);
+	if (!Interned)
+	{
+		FTCHARToUTF8 Converted(Name);
+		Interned = &InternedKeys.Add(Name);
+		Interned->Append(Converted.Get(), Converted.Length());
+		Interned->Add('\0');
+	}
+
+	Utf8 = Interned->GetData();
+	Length = Interned->Num() - 1;
+	Hash = HashUtf8(Utf8, Length);
+}
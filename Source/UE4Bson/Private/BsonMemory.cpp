@@ -0,0 +1,341 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BsonMemory.h"
+#include "BsonScopedArena.h"
+#include "UE4Bson.h"
+#include <bson.h>
+#include <stdlib.h>
+
+
+namespace
+{
+	/** Precedes every block handed to libbson. */
+	struct alignas(16) FBsonAllocationHeader
+	{
+		/** The arena the block was allocated from, nullptr for FMemory and malloc. */
+		FBsonScopedArena* Arena;
+
+		/** The size requested by libbson. */
+		uint32 Size;
+
+		/** Which allocator the block came from, one of the Bson*Block values. */
+		uint32 Source;
+	};
+
+	const uint32 BsonAllocationAlignment = 16;
+
+	/** Header sources, arbitrary values that a block not allocated through FBsonMemory is unlikely to contain. */
+	const uint32 BsonFMemoryBlock = 0x4D465342;
+	const uint32 BsonArenaBlock = 0x52415342;
+	const uint32 BsonSystemBlock = 0x4D535342;
+
+	/** The allocation state of a thread. */
+	struct FBsonThreadMemory
+	{
+		/** The innermost FBsonScopedArena of the thread. */
+		FBsonScopedArena* Arena = nullptr;
+
+		/** The arena to use instead of Arena while bOverridden, see FBsonMemory::FScopedArenaOverride. */
+		FBsonScopedArena* Override = nullptr;
+		bool bOverridden = false;
+
+		/** See FBsonMemory::FScopedSystemMalloc. */
+		bool bSystemMalloc = false;
+	};
+
+	thread_local FBsonThreadMemory GBsonThreadMemory;
+
+	/** Blocks allocated through FMemory or malloc that haven't been freed yet, see FBsonMemory::Uninstall(). */
+	volatile int64 GLiveBsonBlocks = 0;
+
+	SIZE_T AlignAllocationSize(SIZE_T Size)
+	{
+		return (Size + BsonAllocationAlignment - 1) & ~(SIZE_T)(BsonAllocationAlignment - 1);
+	}
+
+	FBsonAllocationHeader* GetHeader(void* Memory)
+	{
+		FBsonAllocationHeader* Header = (FBsonAllocationHeader*)Memory - 1;
+		checkf(Header->Source == BsonFMemoryBlock || Header->Source == BsonArenaBlock || Header->Source == BsonSystemBlock,
+			TEXT("libbson released a block that wasn't allocated through FBsonMemory, was it allocated before FBsonMemory::Install()?"));
+		return Header;
+	}
+}
+
+
+void* FBsonMemory::AllocateBlock(FBsonScopedArena* Arena, bool bSystemMalloc, size_t NumBytes)
+{
+	if (NumBytes > MAX_uint32)
+	{
+		return nullptr;
+	}
+	SIZE_T BlockSize = sizeof(FBsonAllocationHeader) + NumBytes;
+
+	FBsonAllocationHeader* Header;
+	if (Arena)
+	{
+		Header = (FBsonAllocationHeader*)Arena->Allocate(BlockSize);
+		Header->Source = BsonArenaBlock;
+	}
+	else
+	{
+		// malloc is 16-byte aligned on all 64-bit platforms
+		Header = bSystemMalloc
+			? (FBsonAllocationHeader*)malloc(BlockSize)
+			: (FBsonAllocationHeader*)FMemory::Malloc(BlockSize, BsonAllocationAlignment);
+		if (!Header)
+		{
+			return nullptr;
+		}
+		Header->Source = bSystemMalloc ? BsonSystemBlock : BsonFMemoryBlock;
+		FPlatformAtomics::InterlockedIncrement(&GLiveBsonBlocks);
+	}
+	Header->Arena = Arena;
+	Header->Size = (uint32)NumBytes;
+	return Header + 1;
+}
+
+
+void FBsonMemory::Install()
+{
+	bson_mem_vtable_t Vtable = {};
+	Vtable.malloc = &FBsonMemory::Malloc;
+	Vtable.calloc = &FBsonMemory::Calloc;
+	Vtable.realloc = &FBsonMemory::Realloc;
+	Vtable.free = &FBsonMemory::Free;
+	bson_mem_set_vtable(&Vtable);
+}
+
+
+void FBsonMemory::Uninstall()
+{
+	const int64 LiveBlocks = FPlatformAtomics::AtomicRead(&GLiveBsonBlocks);
+	if (LiveBlocks != 0)
+	{
+		UE_LOG(LogBson, Error, TEXT("%lld libbson allocations are still alive, keeping the FBsonMemory functions installed."), LiveBlocks);
+		return;
+	}
+	bson_mem_restore_vtable();
+}
+
+
+FBsonMemory::FScopedArenaOverride::FScopedArenaOverride(FBsonScopedArena* Arena)
+	: PreviousOverride(GBsonThreadMemory.Override)
+	, bPreviousOverridden(GBsonThreadMemory.bOverridden)
+{
+	GBsonThreadMemory.Override = FBsonScopedArena::IsActiveOnThisThread(Arena) ? Arena : nullptr;
+	GBsonThreadMemory.bOverridden = true;
+}
+
+
+FBsonMemory::FScopedArenaOverride::~FScopedArenaOverride()
+{
+	GBsonThreadMemory.Override = PreviousOverride;
+	GBsonThreadMemory.bOverridden = bPreviousOverridden;
+}
+
+
+FBsonMemory::FScopedSystemMalloc::FScopedSystemMalloc()
+	: bPrevious(GBsonThreadMemory.bSystemMalloc)
+{
+	GBsonThreadMemory.bSystemMalloc = true;
+}
+
+
+FBsonMemory::FScopedSystemMalloc::~FScopedSystemMalloc()
+{
+	GBsonThreadMemory.bSystemMalloc = bPrevious;
+}
+
+
+void* FBsonMemory::Malloc(size_t NumBytes)
+{
+	const FBsonThreadMemory& Thread = GBsonThreadMemory;
+	if (Thread.bSystemMalloc)
+	{
+		return AllocateBlock(nullptr, true, NumBytes);
+	}
+	return AllocateBlock(Thread.bOverridden ? Thread.Override : Thread.Arena, false, NumBytes);
+}
+
+
+void* FBsonMemory::Calloc(size_t NumMembers, size_t NumBytes)
+{
+	SIZE_T Total = NumMembers * NumBytes;
+	if (NumBytes && Total / NumBytes != NumMembers)
+	{
+		return nullptr;
+	}
+
+	void* Memory = Malloc(Total);
+	if (Memory)
+	{
+		FMemory::Memzero(Memory, Total);
+	}
+	return Memory;
+}
+
+
+void* FBsonMemory::Realloc(void* Memory, size_t NumBytes)
+{
+	if (!Memory)
+	{
+		return Malloc(NumBytes);
+	}
+	if (!NumBytes)
+	{
+		Free(Memory);
+		return nullptr;
+	}
+	if (NumBytes > MAX_uint32)
+	{
+		return nullptr;
+	}
+
+	FBsonAllocationHeader* Header = GetHeader(Memory);
+	SIZE_T BlockSize = sizeof(FBsonAllocationHeader) + NumBytes;
+
+	// FMemory and malloc blocks stay with their allocator
+	if (Header->Source != BsonArenaBlock)
+	{
+		Header = Header->Source == BsonSystemBlock
+			? (FBsonAllocationHeader*)realloc(Header, BlockSize)
+			: (FBsonAllocationHeader*)FMemory::Realloc(Header, BlockSize, BsonAllocationAlignment);
+		if (!Header)
+		{
+			return nullptr;
+		}
+		Header->Size = (uint32)NumBytes;
+		return Header + 1;
+	}
+
+	// stays in its arena as long as that can be used from this thread, moves to FMemory otherwise
+	FBsonScopedArena* Arena = FBsonScopedArena::IsActiveOnThisThread(Header->Arena) ? Header->Arena : nullptr;
+	if (Arena && Arena->TryResize(Header, BlockSize))
+	{
+		Header->Size = (uint32)NumBytes;
+		return Header + 1;
+	}
+
+	void* NewMemory = AllocateBlock(Arena, false, NumBytes);
+	if (NewMemory)
+	{
+		FMemory::Memcpy(NewMemory, Memory, FMath::Min<SIZE_T>(Header->Size, NumBytes));
+	}
+	return NewMemory;
+}
+
+
+void FBsonMemory::Free(void* Memory)
+{
+	if (!Memory)
+	{
+		return;
+	}
+
+	// arena memory is released with the whole arena
+	FBsonAllocationHeader* Header = GetHeader(Memory);
+	if (Header->Source == BsonFMemoryBlock)
+	{
+		FPlatformAtomics::InterlockedDecrement(&GLiveBsonBlocks);
+		FMemory::Free(Header);
+	}
+	else if (Header->Source == BsonSystemBlock)
+	{
+		FPlatformAtomics::InterlockedDecrement(&GLiveBsonBlocks);
+		free(Header);
+	}
+}
+
+
+FBsonScopedArena::FBsonScopedArena(uint32 InBlockSize)
+	: Previous(GBsonThreadMemory.Arena)
+	, BlockSize(InBlockSize)
+	, Cursor(nullptr)
+	, End(nullptr)
+	, LastAllocation(nullptr)
+	, AllocatedBytes(0)
+{
+	GBsonThreadMemory.Arena = this;
+}
+
+
+FBsonScopedArena::~FBsonScopedArena()
+{
+	checkf(GBsonThreadMemory.Arena == this, TEXT("FBsonScopedArena destroyed out of order or on another thread."));
+	GBsonThreadMemory.Arena = Previous;
+
+	for (uint8* Block : Blocks)
+	{
+		FMemory::Free(Block);
+	}
+}
+
+
+FBsonScopedArena* FBsonScopedArena::GetCurrent()
+{
+	return GBsonThreadMemory.Arena;
+}
+
+
+void* FBsonScopedArena::Allocate(SIZE_T Size)
+{
+	Size = AlignAllocationSize(Size);
+	AllocatedBytes += Size;
+
+	if (Cursor && Size <= (SIZE_T)(End - Cursor))
+	{
+		LastAllocation = Cursor;
+		Cursor += Size;
+		return LastAllocation;
+	}
+
+	// large allocations would waste most of a shared block
+	if (Size > BlockSize / 4)
+	{
+		uint8* Block = (uint8*)FMemory::Malloc(Size, BsonAllocationAlignment);
+		Blocks.Add(Block);
+		return Block;
+	}
+
+	uint8* Block = (uint8*)FMemory::Malloc(BlockSize, BsonAllocationAlignment);
+	Blocks.Add(Block);
+	End = Block + BlockSize;
+	LastAllocation = Block;
+	Cursor = Block + Size;
+	return LastAllocation;
+}
+
+
+bool FBsonScopedArena::TryResize(void* Memory, SIZE_T NewSize)
+{
+	if (Memory != LastAllocation)
+	{
+		return false;
+	}
+
+	NewSize = AlignAllocationSize(NewSize);
+	if (NewSize > (SIZE_T)(End - LastAllocation))
+	{
+		return false;
+	}
+
+	SIZE_T OldSize = Cursor - LastAllocation;
+	AllocatedBytes += NewSize;
+	AllocatedBytes -= OldSize;
+	Cursor = LastAllocation + NewSize;
+	return true;
+}
+
+
+bool FBsonScopedArena::IsActiveOnThisThread(const FBsonScopedArena* Arena)
+{
+	for (const FBsonScopedArena* Active = GBsonThreadMemory.Arena; Active; Active = Active->Previous)
+	{
+		if (Active == Arena)
+		{
+			return true;
+		}
+	}
+	return false;
+}
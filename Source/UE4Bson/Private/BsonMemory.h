@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FBsonScopedArena;
+
+/**
+* \brief The allocation functions handed to libbson.
+*
+* Every allocation is prefixed with a small header recording where it came from (FMemory, an
+* FBsonScopedArena or the C runtime), so it can be freed or grown from any thread.
+*/
+struct FBsonMemory {
+
+	/**
+	* Routes all libbson allocations through FMemory and FBsonScopedArena.
+	*
+	* Has to be called before libbson allocates anything: a block from libbson's default malloc has no
+	* header and would be misread when it is freed, which the checked header catches in builds with checks.
+	* Nothing in this module makes libbson allocate before FUE4BsonModule::StartupModule() calls this.
+	*/
+	static void Install();
+
+	/**
+	* Hands libbson its default allocation functions back, see bson_mem_restore_vtable().
+	*
+	* Only done once every block allocated through these functions has been freed, as the default free()
+	* can't release them. Otherwise the functions stay installed and an error is logged. Has to be called
+	* when no other thread uses libbson anymore.
+	*/
+	static void Uninstall();
+
+	/**
+	* Makes libbson allocate for a document created in the given arena while in scope: from that arena
+	* if it is active on the calling thread, through FMemory otherwise (also for nullptr), instead of
+	* from the current arena of the thread.
+	*/
+	struct FScopedArenaOverride {
+
+		explicit FScopedArenaOverride(FBsonScopedArena* Arena);
+		~FScopedArenaOverride();
+
+	private:
+
+		FBsonScopedArena* PreviousOverride;
+		bool bPreviousOverridden;
+	};
+
+	/**
+	* Makes libbson allocate with the C runtime's malloc on the calling thread while in scope, taking
+	* precedence over arenas. Only meant for comparisons, see the Bson.Benchmark.Memory automation test.
+	*/
+	struct FScopedSystemMalloc {
+
+		FScopedSystemMalloc();
+		~FScopedSystemMalloc();
+
+	private:
+
+		bool bPrevious;
+	};
+
+private:
+
+	/** Allocates a block with a header from the given arena, or from FMemory or malloc if there is none. */
+	static void* AllocateBlock(FBsonScopedArena* Arena, bool bSystemMalloc, size_t NumBytes);
+
+	static void* Malloc(size_t NumBytes);
+	static void* Calloc(size_t NumMembers, size_t NumBytes);
+	static void* Realloc(void* Memory, size_t NumBytes);
+	static void Free(void* Memory);
+};
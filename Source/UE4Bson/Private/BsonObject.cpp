@@ -1,188 +1,85 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "BsonObject.h"
-#include "UE4Bson.h"
-#include <bson.h>
+#include "BsonObjectImpl.h"
 
 
-struct FBsonObject::LibbsonImpl {
+FBsonObject::FBsonObject(){
+	Impl = new LibbsonImpl;
 	
-	bson_t *bsonDoc;
+}
 
-	LibbsonImpl() {
-		bsonDoc = new bson_t;
-		bson_init(bsonDoc);
-	}
+FBsonObject::FBsonObject(uint32 ReserveBytes) {
+	Impl = new LibbsonImpl(ReserveBytes);
+}
 
-	LibbsonImpl(const uint8_t* Data, size_t Length) {
-		bsonDoc = bson_new_from_data(Data, Length);
-	}
+FBsonObject::FBsonObject(const uint8_t* Data, size_t Length) {
+	Impl = new LibbsonImpl(Data, Length);
+}
 
-	LibbsonImpl(FString Data) {
-		bson_error_t t;
-		bsonDoc = new bson_t;
-		if (!bson_init_from_json(bsonDoc, TCHAR_TO_ANSI(*Data), -1, &t)) {
-			UE_LOG(LogBson, Error, TEXT("Error while converting from JSON: %s\nDocument has been initialized empty."), t.message);
-			bson_init(bsonDoc);
-		}
-	}
+FBsonObject::FBsonObject(FString Data) {
+	Impl = new LibbsonImpl(Data);
+}
 
-	void SetBsonDoc(bson_t *initDoc) {
-		bson_steal(bsonDoc, initDoc);
-	}
+FBsonObject::FBsonObject(TArray<uint8>&& Buffer) {
+	Impl = new LibbsonImpl(MoveTemp(Buffer));
+}
 
-	~LibbsonImpl() {
-		bson_destroy(bsonDoc);
-	}
+FBsonObject::FBsonObject(LibbsonImpl *InImpl) {
+	Impl = InImpl;
+}
 
-	/**
-	* Creates a bson_t document from all the FBsonValues inside a given TArray.
-	*
-	* @param InArray the TArray of TSharedPtr<FBsonValue> to convert.
-	* @param OutArray a TSharedPtr to the bson_t document containing the array.
-	*/
-	void BsonFromFBsonValueArray(const TArray<TSharedPtr<FBsonValue> > &InArray, TSharedPtr<bson_t> &OutArray) {
-		int ArrayIndex = 0;
-		FString IndexAsFString;
-		TSharedPtr<bson_t> SubArray;
-		for (auto Value : InArray) {
-			IndexAsFString = FString::FromInt(ArrayIndex);
-			switch (Value->Type) {
-			case EBson::Array:
-				SubArray = MakeShareable(new bson_t);
-				bson_init(SubArray.Get());
-				BsonFromFBsonValueArray(Value->AsArray(), SubArray);
-				BSON_APPEND_ARRAY(OutArray.Get(), TCHAR_TO_UTF8(*IndexAsFString), SubArray.Get());
-				break;
-			case EBson::Boolean:
-				BSON_APPEND_BOOL(OutArray.Get(), TCHAR_TO_UTF8(*IndexAsFString), Value->AsBool());
-				break;
-			case EBson::Number:
-				BSON_APPEND_DOUBLE(OutArray.Get(), TCHAR_TO_UTF8(*IndexAsFString), Value->AsNumber());
-				break;
-			case EBson::Object:
-				BSON_APPEND_DOCUMENT(OutArray.Get(), TCHAR_TO_UTF8(*IndexAsFString), Value->AsObject()->Impl->bsonDoc);
-				break;
-			case EBson::String:
-				BSON_APPEND_UTF8(OutArray.Get(), TCHAR_TO_UTF8(*IndexAsFString), TCHAR_TO_UTF8(*(Value->AsString())));
-				break;
-			case EBson::None:
-
-				// TODO
-
-				break;
-			}
-			ArrayIndex++;
-		}
-	}
+FBsonObject::FBsonObject(const FBsonObject& Other) {
+	Impl = Other.ReadImpl().Share();
+}
 
-	/**
-	* Converts an Array in a bson_t to an FBsonValueArray.
-	*
-	* @param iter an iterator placed on an array in a bson_t.
-	* @return the resulting FBsonValueArray in a TSharedPtr
-	*/
-	TSharedPtr<FBsonValueArray> FBsonValueArrayFromBson(bson_iter_t *iter) const {
-		TArray<TSharedPtr<FBsonValue>> returnArray;
-		TSharedPtr<bson_iter_t> recurse;
-		while (bson_iter_next(iter)) {
-			switch (bson_iter_type(iter)) {
-			case BSON_TYPE_ARRAY:
-				recurse = MakeShareable(new bson_iter_t);
-				bson_iter_recurse(iter, recurse.Get());
-				returnArray.Add(FBsonValueArrayFromBson(recurse.Get()));
-				break;
-			case BSON_TYPE_BOOL:
-				returnArray.Add(MakeShareable(new FBsonValueBoolean{ bson_iter_as_bool(iter) }));
-				break;
-			case BSON_TYPE_DOUBLE:
-				returnArray.Add(MakeShareable(new FBsonValueNumber{ bson_iter_as_double(iter) }));
-				break;
-			case BSON_TYPE_UTF8:
-				returnArray.Add(MakeShareable(new FBsonValueString{ bson_iter_utf8(iter, NULL) }));
-				break;
-			case BSON_TYPE_DOCUMENT:
-			{
-				uint32_t *length = new uint32_t;
-				const void *data = nullptr;
-
-				bson_iter_document(iter, length, (const uint8_t**)&data);
-				size_t size = *length;
-				TSharedPtr<FBsonObject> NewObject = MakeShareable(new FBsonObject);
-				NewObject->Impl->SetBsonDoc(bson_new_from_data((uint8_t*)data, size));
-				
-				returnArray.Add(MakeShareable(new FBsonValueObject{ NewObject }));
-				delete length;
-
-				break;
-			}
-			}
-		}
+FBsonObject::FBsonObject(FBsonObject&& Other) {
+	// the moved-from object creates a new implementation only if it is used again
+	Impl = Other.Impl;
+	Other.Impl = nullptr;
+}
 
-		return MakeShareable(new FBsonValueArray{ returnArray });
+FBsonObject& FBsonObject::operator=(const FBsonObject& Other) {
+	if (this != &Other) {
+		LibbsonImpl *Shared = Other.ReadImpl().Share();
+		delete Impl;
+		Impl = Shared;
 	}
-	
+	return *this;
+}
 
-	/**
-	* Returns the appropriate EBson for a given bson_type_t.
-	*
-	* @param fieldType The bson_type_t to convert.
-	* @return EBson the converted EBson
-	*/
-	EBson FindEquivalentFieldType(bson_type_t fieldType) const {
-		switch (fieldType) {
-		case BSON_TYPE_ARRAY:
-			return EBson::Array;
-		case BSON_TYPE_BOOL:
-			return EBson::Boolean;
-		case BSON_TYPE_DOUBLE:
-			return EBson::Number;
-		case BSON_TYPE_UTF8:
-			return EBson::String;
-		case BSON_TYPE_DOCUMENT:
-			return EBson::Object;
-		default:
-			return EBson::None;
-		}
+FBsonObject& FBsonObject::operator=(FBsonObject&& Other) {
+	if (this != &Other) {
+		delete Impl;
+		Impl = Other.Impl;
+		Other.Impl = nullptr;
 	}
+	return *this;
+}
 
-	/**
-	* Returns the appropriate bson_type_t for a given EBson.
-	*
-	* @param fieldType The EBson to convert.
-	* @return bson_type_t the converted bson_type_t
-	*/
-	bson_type_t FindEquivalentFieldType(EBson fieldType) const {
-		switch (fieldType) {
-		case EBson::Array:
-			return BSON_TYPE_ARRAY;
-		case EBson::Boolean:
-			return BSON_TYPE_BOOL;
-		case EBson::Number:
-			return BSON_TYPE_DOUBLE;
-		case EBson::String:
-			return BSON_TYPE_UTF8;
-		case EBson::Object:
-			return BSON_TYPE_DOCUMENT;
-		default:
-			return BSON_TYPE_UNDEFINED;
-		}
-	}
+FBsonObject FBsonObject::Borrow(const uint8* Data, uint32 Length) {
+	// no owner to keep alive, the caller is responsible for the bytes
+	return FBsonObject(new LibbsonImpl(FBsonSharedDocumentPtr(), Data, Length));
+}
 
-};
+bool FBsonObject::SetBorrowed(const uint8* Data, uint32 Length) {
+	return WriteImpl().SetBorrowedDoc(Data, Length);
+}
 
+uint8* FBsonObject::Release(uint32& OutLength) {
+	return WriteImpl().ReleaseBuffer(&OutLength);
+}
 
-FBsonObject::FBsonObject(){
-	Impl = new LibbsonImpl;
-	
+void FBsonObject::FreeReleasedBuffer(uint8* Buffer) {
+	bson_free(Buffer);
 }
 
-FBsonObject::FBsonObject(const uint8_t* Data, size_t Length) {
-	Impl = new LibbsonImpl(Data, Length);
+void FBsonObject::Reset() {
+	WriteImpl().Reset();
 }
 
-FBsonObject::FBsonObject(FString Data) {
-	Impl = new LibbsonImpl(Data);
+uint32 FBsonObject::GetPeakDataLength() const {
+	return FMath::Max<uint32>(ReadImpl().PeakLength, ReadImpl().bsonDoc->len);
 }
 
 
@@ -194,74 +91,45 @@ FBsonObject::~FBsonObject()
 
 const uint8_t* FBsonObject::GetDataPointer() const 
 {
-	return bson_get_data(Impl->bsonDoc);
+	return bson_get_data(ReadImpl().bsonDoc);
 }
 
 const size_t FBsonObject::GetDataLength() const
 {
-	return Impl->bsonDoc->len;
+	return ReadImpl().bsonDoc->len;
 }
 
 bool FBsonObject::Compare(const TSharedPtr<FBsonObject> &ToCompare) const {
-	if (bson_compare(Impl->bsonDoc, ToCompare->Impl->bsonDoc) == 0)
+	if (bson_compare(ReadImpl().bsonDoc, ToCompare->ReadImpl().bsonDoc) == 0)
 		return true;
 	return false;
 }
 
 TSharedPtr<FBsonObject> FBsonObject::Copy() const {
-	TSharedPtr<FBsonObject> Copy = MakeShareable(new FBsonObject());
-	Copy->Impl->bsonDoc = bson_copy(Impl->bsonDoc);
-	return Copy;
+	return MakeShareable(new FBsonObject(*this));
 }
 
 FString FBsonObject::PrintAsCanonicalJson() const {
-	return bson_as_canonical_extended_json(Impl->bsonDoc, NULL);
+	return bson_as_canonical_extended_json(ReadImpl().bsonDoc, NULL);
 }
 
 FString FBsonObject::PrintAsJson() const {
-	return bson_as_relaxed_extended_json(Impl->bsonDoc, NULL);
+	return bson_as_relaxed_extended_json(ReadImpl().bsonDoc, NULL);
 }
 
 
 TSharedPtr<FBsonValue> FBsonObject::GetField(const FString &FieldName) const
 {
-	bson_iter_t iter;
-	if (bson_iter_init_find(&iter, Impl->bsonDoc, TCHAR_TO_UTF8(*FieldName))) {
-
-		// if the requested field is of type BSON_TYPE_ARRAY this will be necessary to recurse into it
-
+	return GetField(FTransientBsonKey(FieldName));
+}
 
-		switch (bson_iter_type(&iter)) {
-		case BSON_TYPE_ARRAY:
-		{
-			bson_iter_t arrayIter;
-			bson_iter_recurse(&iter, &arrayIter);
-			return Impl->FBsonValueArrayFromBson(&arrayIter);
-		}
-		case BSON_TYPE_BOOL:
-			return MakeShareable(new FBsonValueBoolean{ bson_iter_as_bool(&iter) });
-		case BSON_TYPE_DOUBLE:
-			return MakeShareable(new FBsonValueNumber{ bson_iter_as_double(&iter) });
-		case BSON_TYPE_UTF8:
-			return MakeShareable(new FBsonValueString{ bson_iter_utf8(&iter, NULL) });
-		case BSON_TYPE_DOCUMENT:
-		{
-			uint32_t *length = new uint32_t;
-			void *data = nullptr;
-			bson_iter_document(&iter, length, (const uint8_t**)&data);
-			size_t size = *length;
-			TSharedPtr<FBsonObject> NewObject = MakeShareable(new FBsonObject);
-			NewObject->Impl->SetBsonDoc(bson_new_from_data((uint8_t*)data, size));
-			TSharedPtr<FBsonValueObject> ReturnObject = MakeShareable(new FBsonValueObject{NewObject});
-			delete length;
-			return ReturnObject;
-		}
-		default:
-			UE_LOG(LogBson, Warning, TEXT("Unsupported Type: %d (see http://mongoc.org/libbson/current/bson_type_t.html for reference)."), bson_iter_type(&iter))
-				return MakeShareable(new FBsonValueNull());
-		}
+TSharedPtr<FBsonValue> FBsonObject::GetField(const FBsonKey& Key) const
+{
+	bson_iter_t iter;
+	if (ReadImpl().FindField(Key, &iter)) {
+		return ReadImpl().ValueFromIter(&iter);
 	}
-	UE_LOG(LogBson, Warning, TEXT("Field %s was not found."), *FieldName);
+	UE_LOG(LogBson, Warning, TEXT("Field %s was not found."), *Key.ToString());
 
 	return MakeShareable(new FBsonValueNull());
 }
@@ -273,95 +141,486 @@ TSharedPtr<FBsonValue> FBsonObject::GetField(const FString &FieldName) const
 * @return TSharedPtr with an appropriate FBsonValue or nullptr
 */
 TSharedPtr<FBsonValue> FBsonObject::TryGetField(const FString& FieldName) const {
-	TSharedPtr<FBsonValue> checkExisting = GetField(FieldName);
-	if (&checkExisting != nullptr && checkExisting.IsValid() && checkExisting->Type == EBson::Null) {
-		return nullptr;
+	return TryGetField(FTransientBsonKey(FieldName));
+}
+
+TSharedPtr<FBsonValue> FBsonObject::TryGetField(const FBsonKey& Key) const {
+	bson_iter_t iter;
+	if (ReadImpl().FindField(Key, &iter)) {
+		TSharedPtr<FBsonValue> checkExisting = ReadImpl().ValueFromIter(&iter);
+		if (checkExisting->Type != EBson::Null) {
+			return checkExisting;
+		}
 	}
-	return checkExisting;
+	return nullptr;
 }
 
 bool FBsonObject::HasField(const FString& FieldName) const {
-	return bson_has_field(Impl->bsonDoc, TCHAR_TO_UTF8(*FieldName));
+	return HasField(FTransientBsonKey(FieldName));
+}
+
+bool FBsonObject::HasField(const FBsonKey& Key) const {
+	bson_iter_t iter;
+	return ReadImpl().FindField(Key, &iter);
+}
+
+FBsonValueView FBsonObject::GetFieldView(const FString& FieldName) const {
+	return GetFieldView(FTransientBsonKey(FieldName));
+}
+
+FBsonValueView FBsonObject::GetFieldView(const FBsonKey& Key) const {
+	FBsonValueView View;
+	TryGetFieldView(Key, View);
+	return View;
+}
+
+bool FBsonObject::TryGetFieldView(const FString& FieldName, FBsonValueView& OutView) const {
+	return TryGetFieldView(FTransientBsonKey(FieldName), OutView);
+}
+
+bool FBsonObject::TryGetFieldView(const FBsonKey& Key, FBsonValueView& OutView) const {
+	bson_iter_t iter;
+	if (ReadImpl().FindField(Key, &iter)) {
+		OutView = ReadImpl().ViewFromIter(&iter);
+		return true;
+	}
+	return false;
+}
+
+TSharedPtr<FBsonValue> FBsonObject::GetFieldByPath(const FString& Path) const {
+	return GetFieldByPath(FBsonPath(Path));
+}
+
+TSharedPtr<FBsonValue> FBsonObject::GetFieldByPath(const FBsonPath& Path) const {
+	bson_iter_t iter;
+	if (ReadImpl().FindPath(Path, &iter)) {
+		return ReadImpl().ValueFromIter(&iter);
+	}
+	return MakeShareable(new FBsonValueNull());
+}
+
+FBsonValueView FBsonObject::GetFieldViewByPath(const FBsonPath& Path) const {
+	FBsonValueView View;
+	TryGetFieldViewByPath(Path, View);
+	return View;
+}
+
+bool FBsonObject::TryGetFieldViewByPath(const FBsonPath& Path, FBsonValueView& OutView) const {
+	bson_iter_t iter;
+	if (ReadImpl().FindPath(Path, &iter)) {
+		OutView = ReadImpl().ViewFromIter(&iter);
+		return true;
+	}
+	return false;
+}
+
+int32 FBsonObject::GetFields(const FBsonFieldSet& Fields, TArray<TSharedPtr<FBsonValue>>& OutValues) const {
+	OutValues.Reset(Fields.Num());
+	OutValues.SetNum(Fields.Num());
+	return ReadImpl().FindFields(Fields, [this, &OutValues](int32 Slot, const bson_iter_t *iter) {
+		OutValues[Slot] = ReadImpl().ValueFromIter(iter);
+	});
+}
+
+int32 FBsonObject::GetFieldViews(const FBsonFieldSet& Fields, TArrayView<FBsonValueView> OutViews) const {
+	check(OutViews.Num() == Fields.Num());
+	for (FBsonValueView& View : OutViews) {
+		View = FBsonValueView();
+	}
+	return ReadImpl().FindFields(Fields, [this, &OutViews](int32 Slot, const bson_iter_t *iter) {
+		OutViews[Slot] = ReadImpl().ViewFromIter(iter);
+	});
 }
 
 
 void FBsonObject::SetField(const FString &FieldName, const TSharedPtr<FBsonValue> &Value)
 {
-	switch (Value->Type) {
-	case EBson::Array:
-		SetArrayField(FieldName, Value->AsArray());
-		break;
-	case EBson::Boolean:
-		SetBoolField(FieldName, Value->AsBool());
-		break;
-	case EBson::Number:
-		SetNumberField(FieldName, Value->AsNumber());
-		break;
-	case EBson::Object:
-		SetObjectField(FieldName, Value->AsObject());
-		break;
-	case EBson::String:
-		SetStringField(FieldName, Value->AsString());
-		break;
-	case EBson::None:
-
-		// TODO
-
-		break;
-	default:
-		UE_LOG(LogBson, Warning, TEXT("Can not set field of unknown type."))
-	}
+	SetField(FTransientBsonKey(FieldName), Value);
+}
+
+void FBsonObject::SetField(const FBsonKey& Key, const TSharedPtr<FBsonValue> &Value)
+{
+	WriteImpl().UpsertField(Key,
+		[this, &Value](bson_iter_t *iter) { return WriteImpl().OverwriteFBsonValue(iter, *Value); },
+		[&Key, &Value](bson_t *Doc) { LibbsonImpl::AppendFBsonValue(Doc, Key.GetUtf8(), Key.Len(), *Value); });
 }
 
 void FBsonObject::SetNumberField(const FString &FieldName, double Number) {
-	BSON_APPEND_DOUBLE(Impl->bsonDoc, TCHAR_TO_UTF8(*FieldName), Number);
+	SetNumberField(FTransientBsonKey(FieldName), Number);
+}
+
+void FBsonObject::SetNumberField(const FBsonKey& Key, double Number) {
+	WriteImpl().UpsertField(Key,
+		[&](bson_iter_t *iter) {
+			if (!BSON_ITER_HOLDS_DOUBLE(iter)) {
+				return false;
+			}
+			bson_iter_overwrite_double(iter, Number);
+			return true;
+		},
+		[&](bson_t *Doc) { bson_append_double(Doc, Key.GetUtf8(), Key.Len(), Number); });
+}
+
+void FBsonObject::SetInt32Field(const FString &FieldName, int32 Number) {
+	SetInt32Field(FTransientBsonKey(FieldName), Number);
+}
+
+void FBsonObject::SetInt32Field(const FBsonKey& Key, int32 Number) {
+	WriteImpl().UpsertField(Key,
+		[&](bson_iter_t *iter) {
+			if (!BSON_ITER_HOLDS_INT32(iter)) {
+				return false;
+			}
+			bson_iter_overwrite_int32(iter, Number);
+			return true;
+		},
+		[&](bson_t *Doc) { bson_append_int32(Doc, Key.GetUtf8(), Key.Len(), Number); });
+}
+
+void FBsonObject::SetInt64Field(const FString &FieldName, int64 Number) {
+	SetInt64Field(FTransientBsonKey(FieldName), Number);
+}
+
+void FBsonObject::SetInt64Field(const FBsonKey& Key, int64 Number) {
+	WriteImpl().UpsertField(Key,
+		[&](bson_iter_t *iter) {
+			if (!BSON_ITER_HOLDS_INT64(iter)) {
+				return false;
+			}
+			bson_iter_overwrite_int64(iter, Number);
+			return true;
+		},
+		[&](bson_t *Doc) { bson_append_int64(Doc, Key.GetUtf8(), Key.Len(), Number); });
+}
+
+void FBsonObject::SetDateTimeField(const FString &FieldName, const FDateTime &DateTime) {
+	SetDateTimeField(FTransientBsonKey(FieldName), DateTime);
+}
+
+void FBsonObject::SetDateTimeField(const FBsonKey& Key, const FDateTime &DateTime) {
+	int64 Milliseconds = FBsonValueDateTime::ToUnixMilliseconds(DateTime);
+	WriteImpl().UpsertField(Key,
+		[&](bson_iter_t *iter) {
+			if (!BSON_ITER_HOLDS_DATE_TIME(iter)) {
+				return false;
+			}
+			LibbsonImpl::OverwriteDateTime(iter, Milliseconds);
+			return true;
+		},
+		[&](bson_t *Doc) { bson_append_date_time(Doc, Key.GetUtf8(), Key.Len(), Milliseconds); });
+}
+
+void FBsonObject::SetObjectIdField(const FString &FieldName, const FBsonObjectId &Id) {
+	SetObjectIdField(FTransientBsonKey(FieldName), Id);
+}
+
+void FBsonObject::SetObjectIdField(const FBsonKey& Key, const FBsonObjectId &Id) {
+	bson_oid_t oid;
+	FMemory::Memcpy(oid.bytes, Id.Bytes, sizeof(oid.bytes));
+	WriteImpl().UpsertField(Key,
+		[&](bson_iter_t *iter) {
+			if (!BSON_ITER_HOLDS_OID(iter)) {
+				return false;
+			}
+			LibbsonImpl::OverwriteValueBytes(iter, oid.bytes, sizeof(oid.bytes));
+			return true;
+		},
+		[&](bson_t *Doc) { bson_append_oid(Doc, Key.GetUtf8(), Key.Len(), &oid); });
+}
+
+void FBsonObject::SetBinaryField(const FString &FieldName, TArrayView<const uint8> Binary, uint8 Subtype) {
+	SetBinaryField(FTransientBsonKey(FieldName), Binary, Subtype);
+}
+
+void FBsonObject::SetBinaryField(const FBsonKey& Key, TArrayView<const uint8> Binary, uint8 Subtype) {
+	WriteImpl().UpsertField(Key, LibbsonImpl::NoOverwrite,
+		[&](bson_t *Doc) { bson_append_binary(Doc, Key.GetUtf8(), Key.Len(), (bson_subtype_t)Subtype, Binary.GetData(), Binary.Num()); });
+}
+
+void FBsonObject::SetDecimal128Field(const FString &FieldName, const FString &Decimal) {
+	SetDecimal128Field(FTransientBsonKey(FieldName), Decimal);
+}
+
+void FBsonObject::SetDecimal128Field(const FBsonKey& Key, const FString &Decimal) {
+	bson_decimal128_t Value;
+	if (!bson_decimal128_from_string(TCHAR_TO_UTF8(*Decimal), &Value)) {
+		UE_LOG(LogBson, Error, TEXT("'%s' is not a valid Decimal128."), *Decimal);
+		return;
+	}
+	WriteImpl().UpsertField(Key,
+		[&](bson_iter_t *iter) {
+			if (!BSON_ITER_HOLDS_DECIMAL128(iter)) {
+				return false;
+			}
+			bson_iter_overwrite_decimal128(iter, &Value);
+			return true;
+		},
+		[&](bson_t *Doc) { bson_append_decimal128(Doc, Key.GetUtf8(), Key.Len(), &Value); });
+}
+
+void FBsonObject::SetNullField(const FString &FieldName) {
+	SetNullField(FTransientBsonKey(FieldName));
+}
+
+void FBsonObject::SetNullField(const FBsonKey& Key) {
+	WriteImpl().UpsertField(Key,
+		[](bson_iter_t *iter) { return BSON_ITER_HOLDS_NULL(iter); },
+		[&Key](bson_t *Doc) { bson_append_null(Doc, Key.GetUtf8(), Key.Len()); });
 }
 
 void FBsonObject::SetBoolField(const FString &FieldName, bool Bool) {
-	BSON_APPEND_BOOL(Impl->bsonDoc, TCHAR_TO_UTF8(*FieldName), Bool);
+	SetBoolField(FTransientBsonKey(FieldName), Bool);
+}
+
+void FBsonObject::SetBoolField(const FBsonKey& Key, bool Bool) {
+	WriteImpl().UpsertField(Key,
+		[&](bson_iter_t *iter) {
+			if (!BSON_ITER_HOLDS_BOOL(iter)) {
+				return false;
+			}
+			bson_iter_overwrite_bool(iter, Bool);
+			return true;
+		},
+		[&](bson_t *Doc) { bson_append_bool(Doc, Key.GetUtf8(), Key.Len(), Bool); });
 }
 
 void FBsonObject::SetStringField(const FString &FieldName, const FString &StringValue) {
-	BSON_APPEND_UTF8(Impl->bsonDoc, TCHAR_TO_UTF8(*FieldName), TCHAR_TO_UTF8(*StringValue));
+	SetStringField(FTransientBsonKey(FieldName), StringValue);
+}
+
+void FBsonObject::SetStringField(const FBsonKey& Key, const FString &StringValue) {
+	FTCHARToUTF8 Utf8Value(*StringValue);
+	WriteImpl().UpsertField(Key, LibbsonImpl::NoOverwrite,
+		[&](bson_t *Doc) { bson_append_utf8(Doc, Key.GetUtf8(), Key.Len(), Utf8Value.Get(), Utf8Value.Length()); });
 }
 
 void FBsonObject::SetArrayField(const FString &FieldName, const TArray< TSharedPtr<FBsonValue> > &Array) {
-	TSharedPtr<bson_t> tmpBson = MakeShareable(new bson_t);
-	bson_init(tmpBson.Get());
-	Impl->BsonFromFBsonValueArray(Array, tmpBson);
-	BSON_APPEND_ARRAY(Impl->bsonDoc, TCHAR_TO_UTF8(*FieldName), tmpBson.Get());
-	bson_destroy(tmpBson.Get());
+	SetArrayField(FTransientBsonKey(FieldName), Array);
+}
+
+void FBsonObject::SetArrayField(const FBsonKey& Key, const TArray< TSharedPtr<FBsonValue> > &Array) {
+	WriteImpl().UpsertField(Key, LibbsonImpl::NoOverwrite,
+		[&](bson_t *Doc) { LibbsonImpl::AppendFBsonValueArray(Doc, Key.GetUtf8(), Key.Len(), Array); });
+}
+
+void FBsonObject::SetArrayField(const FString &FieldName, TArrayView<const FBsonVariant> Values) {
+	SetArrayField(FTransientBsonKey(FieldName), Values);
+}
+
+void FBsonObject::SetArrayField(const FBsonKey& Key, TArrayView<const FBsonVariant> Values) {
+	WriteImpl().UpsertField(Key, LibbsonImpl::NoOverwrite,
+		[&](bson_t *Doc) { LibbsonImpl::AppendVariantArray(Doc, Key.GetUtf8(), Key.Len(), Values); });
+}
+
+void FBsonObject::SetNumberArrayField(const FString &FieldName, TArrayView<const double> Numbers) {
+	SetNumberArrayField(FTransientBsonKey(FieldName), Numbers);
+}
+
+void FBsonObject::SetNumberArrayField(const FBsonKey& Key, TArrayView<const double> Numbers) {
+	WriteImpl().UpsertField(Key, LibbsonImpl::NoOverwrite,
+		[&](bson_t *Doc) { LibbsonImpl::AppendNumberArray(Doc, Key.GetUtf8(), Key.Len(), Numbers); });
+}
+
+void FBsonObject::SetNumberArrayField(const FString &FieldName, TArrayView<const float> Numbers) {
+	SetNumberArrayField(FTransientBsonKey(FieldName), Numbers);
+}
+
+void FBsonObject::SetNumberArrayField(const FBsonKey& Key, TArrayView<const float> Numbers) {
+	WriteImpl().UpsertField(Key, LibbsonImpl::NoOverwrite,
+		[&](bson_t *Doc) { LibbsonImpl::AppendNumberArray(Doc, Key.GetUtf8(), Key.Len(), Numbers); });
+}
+
+void FBsonObject::SetNumberArrayField(const FString &FieldName, TArrayView<const int32> Numbers) {
+	SetNumberArrayField(FTransientBsonKey(FieldName), Numbers);
+}
+
+void FBsonObject::SetNumberArrayField(const FBsonKey& Key, TArrayView<const int32> Numbers) {
+	WriteImpl().UpsertField(Key, LibbsonImpl::NoOverwrite,
+		[&](bson_t *Doc) { LibbsonImpl::AppendNumberArray(Doc, Key.GetUtf8(), Key.Len(), Numbers); });
+}
+
+void FBsonObject::SetNumberArrayField(const FString &FieldName, TArrayView<const int64> Numbers) {
+	SetNumberArrayField(FTransientBsonKey(FieldName), Numbers);
+}
+
+void FBsonObject::SetNumberArrayField(const FBsonKey& Key, TArrayView<const int64> Numbers) {
+	WriteImpl().UpsertField(Key, LibbsonImpl::NoOverwrite,
+		[&](bson_t *Doc) { LibbsonImpl::AppendNumberArray(Doc, Key.GetUtf8(), Key.Len(), Numbers); });
+}
+
+void FBsonObject::SetPackedArrayField(const FString &FieldName, TArrayView<const float> Elements) {
+	SetPackedArrayField(FTransientBsonKey(FieldName), Elements);
+}
+
+void FBsonObject::SetPackedArrayField(const FBsonKey& Key, TArrayView<const float> Elements) {
+	WriteImpl().SetPackedArray(Key, LibbsonImpl::TPackedArrayElement<float>::Code, Elements.GetData(), sizeof(float), Elements.Num());
+}
+
+void FBsonObject::SetPackedArrayField(const FString &FieldName, TArrayView<const double> Elements) {
+	SetPackedArrayField(FTransientBsonKey(FieldName), Elements);
+}
+
+void FBsonObject::SetPackedArrayField(const FBsonKey& Key, TArrayView<const double> Elements) {
+	WriteImpl().SetPackedArray(Key, LibbsonImpl::TPackedArrayElement<double>::Code, Elements.GetData(), sizeof(double), Elements.Num());
+}
+
+void FBsonObject::SetPackedArrayField(const FString &FieldName, TArrayView<const uint8> Elements) {
+	SetPackedArrayField(FTransientBsonKey(FieldName), Elements);
+}
+
+void FBsonObject::SetPackedArrayField(const FBsonKey& Key, TArrayView<const uint8> Elements) {
+	WriteImpl().SetPackedArray(Key, LibbsonImpl::TPackedArrayElement<uint8>::Code, Elements.GetData(), sizeof(uint8), Elements.Num());
 }
 
 void FBsonObject::SetObjectField(const FString &FieldName, const TSharedPtr<FBsonObject> &Object) {
-	BSON_APPEND_DOCUMENT(Impl->bsonDoc, TCHAR_TO_UTF8(*FieldName), Object->Impl->bsonDoc);
+	SetObjectField(FTransientBsonKey(FieldName), Object);
+}
+
+void FBsonObject::SetObjectField(const FBsonKey& Key, const TSharedPtr<FBsonObject> &Object) {
+	WriteImpl().UpsertField(Key, LibbsonImpl::NoOverwrite,
+		[&](bson_t *Doc) { bson_append_document(Doc, Key.GetUtf8(), Key.Len(), Object->ReadImpl().bsonDoc); });
 }
 
 double FBsonObject::GetNumberField(const FString& FieldName) const
 {
-	return GetField(FieldName)->AsNumber();
+	return GetNumberField(FTransientBsonKey(FieldName));
+}
+
+double FBsonObject::GetNumberField(const FBsonKey& Key) const
+{
+	return GetField(Key)->AsNumber();
 }
 
 bool FBsonObject::TryGetNumberField(const FString& FieldName, double& OutNumber) const
 {
-	TSharedPtr<FBsonValue> Field = TryGetField(FieldName);
+	return TryGetNumberField(FTransientBsonKey(FieldName), OutNumber);
+}
+
+bool FBsonObject::TryGetNumberField(const FBsonKey& Key, double& OutNumber) const
+{
+	TSharedPtr<FBsonValue> Field = TryGetField(Key);
+	return Field.IsValid() && Field->TryGetNumber(OutNumber);
+}
+
+bool FBsonObject::TryGetNumberField(const FString& FieldName, int32& OutNumber) const
+{
+	return TryGetNumberField(FTransientBsonKey(FieldName), OutNumber);
+}
+
+bool FBsonObject::TryGetNumberField(const FBsonKey& Key, int32& OutNumber) const
+{
+	TSharedPtr<FBsonValue> Field = TryGetField(Key);
+	return Field.IsValid() && Field->TryGetNumber(OutNumber);
+}
+
+bool FBsonObject::TryGetNumberField(const FString& FieldName, int64& OutNumber) const
+{
+	return TryGetNumberField(FTransientBsonKey(FieldName), OutNumber);
+}
+
+bool FBsonObject::TryGetNumberField(const FBsonKey& Key, int64& OutNumber) const
+{
+	TSharedPtr<FBsonValue> Field = TryGetField(Key);
 	return Field.IsValid() && Field->TryGetNumber(OutNumber);
 }
 
+int64 FBsonObject::GetInt64Field(const FString& FieldName) const
+{
+	return GetInt64Field(FTransientBsonKey(FieldName));
+}
+
+int64 FBsonObject::GetInt64Field(const FBsonKey& Key) const
+{
+	return GetField(Key)->AsInt64();
+}
+
+FDateTime FBsonObject::GetDateTimeField(const FString& FieldName) const
+{
+	return GetDateTimeField(FTransientBsonKey(FieldName));
+}
+
+FDateTime FBsonObject::GetDateTimeField(const FBsonKey& Key) const
+{
+	return GetField(Key)->AsDateTime();
+}
+
+bool FBsonObject::TryGetDateTimeField(const FString& FieldName, FDateTime& OutDateTime) const
+{
+	return TryGetDateTimeField(FTransientBsonKey(FieldName), OutDateTime);
+}
+
+bool FBsonObject::TryGetDateTimeField(const FBsonKey& Key, FDateTime& OutDateTime) const
+{
+	TSharedPtr<FBsonValue> Field = TryGetField(Key);
+	return Field.IsValid() && Field->TryGetDateTime(OutDateTime);
+}
+
+FBsonObjectId FBsonObject::GetObjectIdField(const FString& FieldName) const
+{
+	return GetObjectIdField(FTransientBsonKey(FieldName));
+}
+
+FBsonObjectId FBsonObject::GetObjectIdField(const FBsonKey& Key) const
+{
+	return GetField(Key)->AsObjectId();
+}
+
+bool FBsonObject::TryGetObjectIdField(const FString& FieldName, FBsonObjectId& OutId) const
+{
+	return TryGetObjectIdField(FTransientBsonKey(FieldName), OutId);
+}
+
+bool FBsonObject::TryGetObjectIdField(const FBsonKey& Key, FBsonObjectId& OutId) const
+{
+	TSharedPtr<FBsonValue> Field = TryGetField(Key);
+	return Field.IsValid() && Field->TryGetObjectId(OutId);
+}
+
+bool FBsonObject::TryGetBinaryField(const FString& FieldName, TArray<uint8>& OutBinary) const
+{
+	return TryGetBinaryField(FTransientBsonKey(FieldName), OutBinary);
+}
+
+bool FBsonObject::TryGetBinaryField(const FBsonKey& Key, TArray<uint8>& OutBinary) const
+{
+	TSharedPtr<FBsonValue> Field = TryGetField(Key);
+	const TArray<uint8> *Binary;
+	if (Field.IsValid() && Field->TryGetBinary(Binary)) {
+		OutBinary = *Binary;
+		return true;
+	}
+	return false;
+}
+
 FString FBsonObject::GetStringField(const FString& FieldName) const
 {
-	return GetField(FieldName)->AsString();
+	return GetStringField(FTransientBsonKey(FieldName));
+}
+
+FString FBsonObject::GetStringField(const FBsonKey& Key) const
+{
+	return GetField(Key)->AsString();
 }
 
 bool FBsonObject::TryGetStringField(const FString& FieldName, FString& OutString) const
 {
-	TSharedPtr<FBsonValue> Field = TryGetField(FieldName);
+	return TryGetStringField(FTransientBsonKey(FieldName), OutString);
+}
+
+bool FBsonObject::TryGetStringField(const FBsonKey& Key, FString& OutString) const
+{
+	TSharedPtr<FBsonValue> Field = TryGetField(Key);
 	return Field.IsValid() && Field->TryGetString(OutString);
 }
 
 bool FBsonObject::TryGetStringArrayField(const FString& FieldName, TArray<FString>& OutArray) const
 {
-	TSharedPtr<FBsonValue> Field = TryGetField(FieldName);
+	return TryGetStringArrayField(FTransientBsonKey(FieldName), OutArray);
+}
+
+bool FBsonObject::TryGetStringArrayField(const FBsonKey& Key, TArray<FString>& OutArray) const
+{
+	TSharedPtr<FBsonValue> Field = TryGetField(Key);
 
 	if (!Field.IsValid())
 	{
@@ -390,25 +649,125 @@ bool FBsonObject::TryGetStringArrayField(const FString& FieldName, TArray<FStrin
 	return true;
 }
 
+bool FBsonObject::TryGetArrayField(const FString& FieldName, TArray<FBsonVariant>& OutArray) const
+{
+	return TryGetArrayField(FTransientBsonKey(FieldName), OutArray);
+}
+
+bool FBsonObject::TryGetArrayField(const FBsonKey& Key, TArray<FBsonVariant>& OutArray) const
+{
+	return ReadImpl().GetVariantArray(Key, OutArray);
+}
+
+bool FBsonObject::TryGetNumberArrayField(const FString& FieldName, TArray<double>& OutArray) const
+{
+	return TryGetNumberArrayField(FTransientBsonKey(FieldName), OutArray);
+}
+
+bool FBsonObject::TryGetNumberArrayField(const FBsonKey& Key, TArray<double>& OutArray) const
+{
+	return ReadImpl().GetNumberArray(Key, OutArray);
+}
+
+bool FBsonObject::TryGetNumberArrayField(const FString& FieldName, TArray<float>& OutArray) const
+{
+	return TryGetNumberArrayField(FTransientBsonKey(FieldName), OutArray);
+}
+
+bool FBsonObject::TryGetNumberArrayField(const FBsonKey& Key, TArray<float>& OutArray) const
+{
+	return ReadImpl().GetNumberArray(Key, OutArray);
+}
+
+bool FBsonObject::TryGetNumberArrayField(const FString& FieldName, TArray<int32>& OutArray) const
+{
+	return TryGetNumberArrayField(FTransientBsonKey(FieldName), OutArray);
+}
+
+bool FBsonObject::TryGetNumberArrayField(const FBsonKey& Key, TArray<int32>& OutArray) const
+{
+	return ReadImpl().GetNumberArray(Key, OutArray);
+}
+
+bool FBsonObject::TryGetNumberArrayField(const FString& FieldName, TArray<int64>& OutArray) const
+{
+	return TryGetNumberArrayField(FTransientBsonKey(FieldName), OutArray);
+}
+
+bool FBsonObject::TryGetNumberArrayField(const FBsonKey& Key, TArray<int64>& OutArray) const
+{
+	return ReadImpl().GetNumberArray(Key, OutArray);
+}
+
+bool FBsonObject::TryGetPackedArrayView(const FString& FieldName, TArrayView<const float>& OutView) const
+{
+	return TryGetPackedArrayView(FTransientBsonKey(FieldName), OutView);
+}
+
+bool FBsonObject::TryGetPackedArrayView(const FBsonKey& Key, TArrayView<const float>& OutView) const
+{
+	return ReadImpl().GetPackedArrayView(Key, OutView);
+}
+
+bool FBsonObject::TryGetPackedArrayView(const FString& FieldName, TArrayView<const double>& OutView) const
+{
+	return TryGetPackedArrayView(FTransientBsonKey(FieldName), OutView);
+}
+
+bool FBsonObject::TryGetPackedArrayView(const FBsonKey& Key, TArrayView<const double>& OutView) const
+{
+	return ReadImpl().GetPackedArrayView(Key, OutView);
+}
+
+bool FBsonObject::TryGetPackedArrayView(const FString& FieldName, TArrayView<const uint8>& OutView) const
+{
+	return TryGetPackedArrayView(FTransientBsonKey(FieldName), OutView);
+}
+
+bool FBsonObject::TryGetPackedArrayView(const FBsonKey& Key, TArrayView<const uint8>& OutView) const
+{
+	return ReadImpl().GetPackedArrayView(Key, OutView);
+}
+
 bool FBsonObject::GetBoolField(const FString& FieldName) const
 {
-	return GetField(FieldName)->AsBool();
+	return GetBoolField(FTransientBsonKey(FieldName));
+}
+
+bool FBsonObject::GetBoolField(const FBsonKey& Key) const
+{
+	return GetField(Key)->AsBool();
 }
 
 bool FBsonObject::TryGetBoolField(const FString& FieldName, bool& OutBool) const
 {
-	TSharedPtr<FBsonValue> Field = TryGetField(FieldName);
+	return TryGetBoolField(FTransientBsonKey(FieldName), OutBool);
+}
+
+bool FBsonObject::TryGetBoolField(const FBsonKey& Key, bool& OutBool) const
+{
+	TSharedPtr<FBsonValue> Field = TryGetField(Key);
 	return Field.IsValid() && Field->TryGetBool(OutBool);
 }
 
 const TArray<TSharedPtr<FBsonValue>> FBsonObject::GetArrayField(const FString& FieldName) const
 {
-	return GetField(FieldName)->AsArray();
+	return GetArrayField(FTransientBsonKey(FieldName));
+}
+
+const TArray<TSharedPtr<FBsonValue>> FBsonObject::GetArrayField(const FBsonKey& Key) const
+{
+	return GetField(Key)->AsArray();
 }
 
 bool FBsonObject::TryGetArrayField(const FString& FieldName, TArray<TSharedPtr<FBsonValue>>& OutArray) const
 {
-	TSharedPtr<FBsonValue> Field = TryGetField(FieldName);
+	return TryGetArrayField(FTransientBsonKey(FieldName), OutArray);
+}
+
+bool FBsonObject::TryGetArrayField(const FBsonKey& Key, TArray<TSharedPtr<FBsonValue>>& OutArray) const
+{
+	TSharedPtr<FBsonValue> Field = TryGetField(Key);
 	const TArray<TSharedPtr<FBsonValue>> *copyArray;
 	if (Field.IsValid() && Field->TryGetArray(copyArray)) {
 		OutArray = *copyArray;
@@ -418,17 +777,46 @@ bool FBsonObject::TryGetArrayField(const FString& FieldName, TArray<TSharedPtr<F
 }
 
 const TSharedPtr<FBsonObject> FBsonObject::GetObjectField(const FString& FieldName) const {
-	return GetField(FieldName)->AsObject();
+	return GetObjectField(FTransientBsonKey(FieldName));
+}
+
+const TSharedPtr<FBsonObject> FBsonObject::GetObjectField(const FBsonKey& Key) const {
+	return GetField(Key)->AsObject();
 }
 
 bool FBsonObject::RemoveField(const FString& FieldName) {
-	if (HasField(FieldName)) {
-		TSharedPtr<bson_t> newDoc{ MakeShareable(new bson_t) };
-		bson_init(newDoc.Get());
-		bson_copy_to_excluding_noinit(Impl->bsonDoc, newDoc.Get(), TCHAR_TO_UTF8(*FieldName), NULL);
-		bson_copy_to(newDoc.Get(), Impl->bsonDoc);
-		bson_destroy(newDoc.Get());
-		return true;
+	return RemoveField(FTransientBsonKey(FieldName));
+}
+
+bool FBsonObject::RemoveField(const FBsonKey& Key) {
+	return WriteImpl().RemoveFieldsWhere([&Key](const bson_iter_t *iter) {
+		return LibbsonImpl::IterKeyEquals(iter, Key.GetUtf8(), Key.Len());
+	}) > 0;
+}
+
+int32 FBsonObject::RemoveFields(TArrayView<const FString> FieldNames) {
+	// convert the names into one local buffer and match them through keys pointing into it,
+	// FBsonFieldSet::Add(const FString&) would intern every name for good
+	TArray<ANSICHAR> Utf8Names;
+	TArray<int32> Lengths;
+	Lengths.Reserve(FieldNames.Num());
+	for (const FString& FieldName : FieldNames) {
+		FTCHARToUTF8 Utf8Name(*FieldName);
+		Utf8Names.Append(Utf8Name.Get(), Utf8Name.Length());
+		Lengths.Add(Utf8Name.Length());
 	}
-	return false;
-}
\ No newline at end of file
+
+	FBsonFieldSet Fields;
+	const ANSICHAR* Utf8Name = Utf8Names.GetData();
+	for (int32 Length : Lengths) {
+		Fields.Add(FBsonKey(Utf8Name, Length));
+		Utf8Name += Length;
+	}
+	return RemoveFields(Fields);
+}
+
+int32 FBsonObject::RemoveFields(const FBsonFieldSet& Fields) {
+	return WriteImpl().RemoveFieldsWhere([&Fields](const bson_iter_t *iter) {
+		return Fields.Find(FBsonKey(bson_iter_key(iter), iter->d1 - iter->key - 1)) != INDEX_NONE;
+	});
+}
@@ -0,0 +1,657 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BsonObjectConverter.h"
+#include "BsonObjectImpl.h"
+#include "UObject/Class.h"
+#include "UObject/UnrealType.h"
+#include "JsonObjectConverter.h"
+
+
+/**
+* How the value of a property is read and written, decided once when the plan is built.
+*/
+enum class EBsonPropertyKind : uint8
+{
+	Bool,
+	Int8,
+	Int16,
+	Int32,
+	Int64,
+	UInt8,
+	UInt16,
+	UInt32,
+	UInt64,
+	Float,
+	Double,
+	Enum,
+	String,
+	Name,
+	Text,
+	DateTime,
+	Struct,
+	Array,
+	/** Anything else, converted with ExportTextItem() and ImportText(). */
+	ExportedText
+};
+
+
+/**
+* A single property of a UStruct, or the element type of an array property.
+*/
+struct FBsonPropertyPlan
+{
+	const UProperty* Property;
+
+	/** The standardized property name, interned. Unused for array elements. */
+	FBsonKey Key;
+
+	/** Offset of the property within the struct. */
+	int32 Offset;
+
+	EBsonPropertyKind Kind;
+
+	/** The enum of an Enum property. */
+	const UEnum* Enum;
+
+	/** The property holding the value of an Enum property. */
+	const UNumericProperty* Underlying;
+
+	/** The plan of the struct of a Struct property, kept alive when the cache drops or replaces it. */
+	FBsonStructPlanPtr StructPlan;
+
+	/** The element of an Array property. */
+	TUniquePtr<FBsonPropertyPlan> Inner;
+
+	FBsonPropertyPlan(const UProperty* InProperty, const FBsonKey& InKey)
+		: Property(InProperty), Key(InKey), Offset(InProperty->GetOffset_ForInternal()), Kind(EBsonPropertyKind::ExportedText)
+		, Enum(nullptr), Underlying(nullptr) {}
+};
+
+
+/**
+* All converted properties of a UStruct, in declaration order.
+*/
+struct FBsonStructPlan
+{
+	/** The struct the plan was built for, to detect plans of destroyed structs. */
+	TWeakObjectPtr<const UStruct> Struct;
+
+	TArray<FBsonPropertyPlan> Properties;
+
+	/** Indices into Properties, by the hash of their keys, for fields out of declaration order. */
+	TMultiMap<uint32, int32> PropertiesByHash;
+};
+
+
+namespace
+{
+	struct FBsonStructPlanKey
+	{
+		const UStruct* Struct;
+		int64 CheckFlags;
+		int64 SkipFlags;
+
+		bool operator==(const FBsonStructPlanKey& Other) const
+		{
+			return Struct == Other.Struct && CheckFlags == Other.CheckFlags && SkipFlags == Other.SkipFlags;
+		}
+
+		friend uint32 GetTypeHash(const FBsonStructPlanKey& Key)
+		{
+			return HashCombine(GetTypeHash(Key.Struct), HashCombine(GetTypeHash((uint64)Key.CheckFlags), GetTypeHash((uint64)Key.SkipFlags)));
+		}
+	};
+
+	FCriticalSection PlanCacheLock;
+	TMap<FBsonStructPlanKey, TSharedPtr<FBsonStructPlan, ESPMode::ThreadSafe>> PlanCache;
+
+	TSharedRef<FBsonStructPlan, ESPMode::ThreadSafe> FindOrBuildPlan(const UStruct* StructDefinition, int64 CheckFlags, int64 SkipFlags);
+
+	/**
+	* Decides how the values of a property are converted, recursing into array elements and structs.
+	*/
+	void BuildPropertyPlan(FBsonPropertyPlan& Plan, int64 CheckFlags, int64 SkipFlags)
+	{
+		const UProperty* Property = Plan.Property;
+
+		if (Cast<const UBoolProperty>(Property))
+		{
+			Plan.Kind = EBsonPropertyKind::Bool;
+		}
+		else if (const UEnumProperty* EnumProperty = Cast<const UEnumProperty>(Property))
+		{
+			Plan.Kind = EBsonPropertyKind::Enum;
+			Plan.Enum = EnumProperty->GetEnum();
+			Plan.Underlying = EnumProperty->GetUnderlyingProperty();
+		}
+		else if (const UNumericProperty* NumericProperty = Cast<const UNumericProperty>(Property))
+		{
+			if (NumericProperty->IsEnum())
+			{
+				Plan.Kind = EBsonPropertyKind::Enum;
+				Plan.Enum = NumericProperty->GetIntPropertyEnum();
+				Plan.Underlying = NumericProperty;
+			}
+			else if (Cast<const UFloatProperty>(Property))
+			{
+				Plan.Kind = EBsonPropertyKind::Float;
+			}
+			else if (Cast<const UDoubleProperty>(Property))
+			{
+				Plan.Kind = EBsonPropertyKind::Double;
+			}
+			else if (Cast<const UInt8Property>(Property))
+			{
+				Plan.Kind = EBsonPropertyKind::Int8;
+			}
+			else if (Cast<const UInt16Property>(Property))
+			{
+				Plan.Kind = EBsonPropertyKind::Int16;
+			}
+			else if (Cast<const UIntProperty>(Property))
+			{
+				Plan.Kind = EBsonPropertyKind::Int32;
+			}
+			else if (Cast<const UInt64Property>(Property))
+			{
+				Plan.Kind = EBsonPropertyKind::Int64;
+			}
+			else if (Cast<const UByteProperty>(Property))
+			{
+				Plan.Kind = EBsonPropertyKind::UInt8;
+			}
+			else if (Cast<const UUInt16Property>(Property))
+			{
+				Plan.Kind = EBsonPropertyKind::UInt16;
+			}
+			else if (Cast<const UUInt32Property>(Property))
+			{
+				Plan.Kind = EBsonPropertyKind::UInt32;
+			}
+			else if (Cast<const UUInt64Property>(Property))
+			{
+				Plan.Kind = EBsonPropertyKind::UInt64;
+			}
+		}
+		else if (Cast<const UStrProperty>(Property))
+		{
+			Plan.Kind = EBsonPropertyKind::String;
+		}
+		else if (Cast<const UNameProperty>(Property))
+		{
+			Plan.Kind = EBsonPropertyKind::Name;
+		}
+		else if (Cast<const UTextProperty>(Property))
+		{
+			Plan.Kind = EBsonPropertyKind::Text;
+		}
+		else if (const UStructProperty* StructProperty = Cast<const UStructProperty>(Property))
+		{
+			if (StructProperty->Struct == TBaseStructure<FDateTime>::Get())
+			{
+				Plan.Kind = EBsonPropertyKind::DateTime;
+			}
+			else
+			{
+				Plan.Kind = EBsonPropertyKind::Struct;
+				Plan.StructPlan = FindOrBuildPlan(StructProperty->Struct, CheckFlags, SkipFlags);
+			}
+		}
+		else if (const UArrayProperty* ArrayProperty = Cast<const UArrayProperty>(Property))
+		{
+			Plan.Kind = EBsonPropertyKind::Array;
+			Plan.Inner = MakeUnique<FBsonPropertyPlan>(ArrayProperty->Inner, FBsonKey(""));
+			BuildPropertyPlan(*Plan.Inner, CheckFlags, SkipFlags);
+		}
+	}
+
+	/**
+	* Looks up a plan or builds it, the caller holds PlanCacheLock.
+	* The plan is added before its properties, so structs referring to themselves through arrays find it.
+	* Such plans reference each other and are never freed.
+	*/
+	TSharedRef<FBsonStructPlan, ESPMode::ThreadSafe> FindOrBuildPlan(const UStruct* StructDefinition, int64 CheckFlags, int64 SkipFlags)
+	{
+		FBsonStructPlanKey Key = { StructDefinition, CheckFlags, SkipFlags };
+
+		TSharedPtr<FBsonStructPlan, ESPMode::ThreadSafe>* Existing = PlanCache.Find(Key);
+		if (Existing && (*Existing)->Struct.Get() == StructDefinition)
+		{
+			return Existing->ToSharedRef();
+		}
+
+		// a new struct may have been allocated where a destroyed one was, the stale plan stays alive
+		// for callers still converting with it and for the plans referring to it
+		TSharedRef<FBsonStructPlan, ESPMode::ThreadSafe> Plan = MakeShared<FBsonStructPlan, ESPMode::ThreadSafe>();
+		PlanCache.Add(Key, Plan);
+		FBsonStructPlan& NewPlan = *Plan;
+		NewPlan.Struct = StructDefinition;
+
+		for (TFieldIterator<UProperty> It(StructDefinition); It; ++It)
+		{
+			const UProperty* Property = *It;
+
+			if (CheckFlags != 0 && !Property->HasAnyPropertyFlags(CheckFlags))
+			{
+				continue;
+			}
+			if (Property->HasAnyPropertyFlags(SkipFlags))
+			{
+				continue;
+			}
+
+			FBsonKey PropertyKey(FJsonObjectConverter::StandardizeCase(Property->GetName()));
+			int32 Index = NewPlan.Properties.Emplace(Property, PropertyKey);
+			NewPlan.PropertiesByHash.Add(PropertyKey.GetHash(), Index);
+		}
+
+		// separately, as nested plans may be added to the cache in between
+		for (FBsonPropertyPlan& Property : NewPlan.Properties)
+		{
+			BuildPropertyPlan(Property, CheckFlags, SkipFlags);
+		}
+
+		return Plan;
+	}
+}
+
+
+FBsonStructPlanRef FBsonObjectConverter::GetPlan(const UStruct* StructDefinition, int64 CheckFlags, int64 SkipFlags)
+{
+	FScopeLock Lock(&PlanCacheLock);
+	return FindOrBuildPlan(StructDefinition, CheckFlags, SkipFlags);
+}
+
+
+void FBsonObjectConverter::ResetPlanCache()
+{
+	FScopeLock Lock(&PlanCacheLock);
+	PlanCache.Empty();
+}
+
+
+bool FBsonObjectConverter::UStructToBsonObject(const UStruct* StructDefinition, const void* Struct, FBsonObject& OutBsonObject, int64 CheckFlags, int64 SkipFlags)
+{
+	OutBsonObject.Reset();
+	if (!StructDefinition || !Struct)
+	{
+		return false;
+	}
+
+	FBsonStructPlanRef Plan = GetPlan(StructDefinition, CheckFlags, SkipFlags);
+	OutBsonObject.WriteImpl().PrepareWrite();
+	if (!EncodeStruct(*Plan, Struct, OutBsonObject.WriteImpl().bsonDoc))
+	{
+		UE_LOG(LogBson, Error, TEXT("UStructToBsonObject - %s does not fit into a Bson document."), *StructDefinition->GetName());
+		OutBsonObject.Reset();
+		return false;
+	}
+	return true;
+}
+
+
+bool FBsonObjectConverter::BsonObjectToUStruct(const FBsonObject& BsonObject, const UStruct* StructDefinition, void* OutStruct, int64 CheckFlags, int64 SkipFlags)
+{
+	if (!StructDefinition || !OutStruct)
+	{
+		return false;
+	}
+
+	FBsonStructPlanRef Plan = GetPlan(StructDefinition, CheckFlags, SkipFlags);
+	return DecodeStruct(*Plan, BsonObject.GetDataPointer(), BsonObject.GetDataLength(), OutStruct);
+}
+
+
+bool FBsonObjectConverter::EncodeStruct(const FBsonStructPlan& Plan, const void* Struct, bson_t* Document)
+{
+	for (const FBsonPropertyPlan& Property : Plan.Properties)
+	{
+		if (!EncodeProperty(Property, Struct, Document))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool FBsonObjectConverter::EncodeProperty(const FBsonPropertyPlan& Property, const void* Struct, bson_t* Document)
+{
+	const uint8* Value = (const uint8*)Struct + Property.Offset;
+	const int32 ArrayDim = Property.Property->ArrayDim;
+
+	if (ArrayDim == 1)
+	{
+		return EncodeValue(Property, Value, Document, Property.Key.GetUtf8(), Property.Key.Len());
+	}
+
+	// static arrays
+	bson_t Child;
+	if (!bson_append_array_begin(Document, Property.Key.GetUtf8(), Property.Key.Len(), &Child))
+	{
+		return false;
+	}
+	bool bSuccess = true;
+	for (int32 Index = 0; Index < ArrayDim && bSuccess; Index++)
+	{
+		FBsonArrayIndexKey IndexKey(Index);
+		bSuccess = EncodeValue(Property, Value + Index * Property.Property->ElementSize, &Child, IndexKey.Key, IndexKey.Length);
+	}
+	return bson_append_array_end(Document, &Child) && bSuccess;
+}
+
+
+bool FBsonObjectConverter::EncodeValue(const FBsonPropertyPlan& Property, const void* Value, bson_t* Parent, const ANSICHAR* Key, int32 KeyLength)
+{
+	switch (Property.Kind)
+	{
+	case EBsonPropertyKind::Bool:
+		return bson_append_bool(Parent, Key, KeyLength, static_cast<const UBoolProperty*>(Property.Property)->GetPropertyValue(Value));
+	case EBsonPropertyKind::Int8:
+		return bson_append_int32(Parent, Key, KeyLength, *(const int8*)Value);
+	case EBsonPropertyKind::Int16:
+		return bson_append_int32(Parent, Key, KeyLength, *(const int16*)Value);
+	case EBsonPropertyKind::Int32:
+		return bson_append_int32(Parent, Key, KeyLength, *(const int32*)Value);
+	case EBsonPropertyKind::Int64:
+		return bson_append_int64(Parent, Key, KeyLength, *(const int64*)Value);
+	case EBsonPropertyKind::UInt8:
+		return bson_append_int32(Parent, Key, KeyLength, *(const uint8*)Value);
+	case EBsonPropertyKind::UInt16:
+		return bson_append_int32(Parent, Key, KeyLength, *(const uint16*)Value);
+	case EBsonPropertyKind::UInt32:
+		return bson_append_int64(Parent, Key, KeyLength, *(const uint32*)Value);
+	case EBsonPropertyKind::UInt64:
+		// Bson has no unsigned 64 bit integer, the bits are kept
+		return bson_append_int64(Parent, Key, KeyLength, (int64)*(const uint64*)Value);
+	case EBsonPropertyKind::Float:
+		return bson_append_double(Parent, Key, KeyLength, *(const float*)Value);
+	case EBsonPropertyKind::Double:
+		return bson_append_double(Parent, Key, KeyLength, *(const double*)Value);
+	case EBsonPropertyKind::Enum:
+	{
+		FTCHARToUTF8 Name(*Property.Enum->GetNameStringByValue(Property.Underlying->GetSignedIntPropertyValue(Value)));
+		return bson_append_utf8(Parent, Key, KeyLength, Name.Get(), Name.Length());
+	}
+	case EBsonPropertyKind::String:
+	{
+		FTCHARToUTF8 String(**(const FString*)Value);
+		return bson_append_utf8(Parent, Key, KeyLength, String.Get(), String.Length());
+	}
+	case EBsonPropertyKind::Name:
+	{
+		FTCHARToUTF8 String(*((const FName*)Value)->ToString());
+		return bson_append_utf8(Parent, Key, KeyLength, String.Get(), String.Length());
+	}
+	case EBsonPropertyKind::Text:
+	{
+		FTCHARToUTF8 String(*((const FText*)Value)->ToString());
+		return bson_append_utf8(Parent, Key, KeyLength, String.Get(), String.Length());
+	}
+	case EBsonPropertyKind::DateTime:
+		return bson_append_date_time(Parent, Key, KeyLength, FBsonValueDateTime::ToUnixMilliseconds(*(const FDateTime*)Value));
+	case EBsonPropertyKind::Struct:
+	{
+		bson_t Child;
+		if (!bson_append_document_begin(Parent, Key, KeyLength, &Child))
+		{
+			return false;
+		}
+		const bool bSuccess = EncodeStruct(*Property.StructPlan, Value, &Child);
+		return bson_append_document_end(Parent, &Child) && bSuccess;
+	}
+	case EBsonPropertyKind::Array:
+	{
+		FScriptArrayHelper Helper(static_cast<const UArrayProperty*>(Property.Property), Value);
+		bson_t Child;
+		if (!bson_append_array_begin(Parent, Key, KeyLength, &Child))
+		{
+			return false;
+		}
+		bool bSuccess = true;
+		for (int32 Index = 0; Index < Helper.Num() && bSuccess; Index++)
+		{
+			FBsonArrayIndexKey IndexKey(Index);
+			bSuccess = EncodeValue(*Property.Inner, Helper.GetRawPtr(Index), &Child, IndexKey.Key, IndexKey.Length);
+		}
+		return bson_append_array_end(Parent, &Child) && bSuccess;
+	}
+	case EBsonPropertyKind::ExportedText:
+	{
+		FString Exported;
+		Property.Property->ExportTextItem(Exported, Value, nullptr, nullptr, PPF_None);
+		FTCHARToUTF8 String(*Exported);
+		return bson_append_utf8(Parent, Key, KeyLength, String.Get(), String.Length());
+	}
+	}
+	return false;
+}
+
+
+bool FBsonObjectConverter::DecodeStruct(const FBsonStructPlan& Plan, const uint8* Data, uint32 Length, void* OutStruct)
+{
+	bson_t Document;
+	bson_iter_t iter;
+	if (!bson_init_static(&Document, Data, Length) || !bson_iter_init(&iter, &Document))
+	{
+		return false;
+	}
+
+	// documents written from the same plan have their fields in declaration order
+	int32 Expected = 0;
+
+	while (bson_iter_next(&iter))
+	{
+		const ANSICHAR* Key = bson_iter_key(&iter);
+		int32 KeyLength = iter.d1 - iter.key - 1;
+		int32 Found = INDEX_NONE;
+
+		if (Plan.Properties.IsValidIndex(Expected)
+			&& FBsonObject::LibbsonImpl::IterKeyEquals(&iter, Plan.Properties[Expected].Key.GetUtf8(), Plan.Properties[Expected].Key.Len()))
+		{
+			Found = Expected;
+		}
+		else
+		{
+			for (auto It = Plan.PropertiesByHash.CreateConstKeyIterator(FBsonKey::HashUtf8(Key, KeyLength)); It; ++It)
+			{
+				const FBsonKey& Candidate = Plan.Properties[It.Value()].Key;
+				if (FBsonObject::LibbsonImpl::IterKeyEquals(&iter, Candidate.GetUtf8(), Candidate.Len()))
+				{
+					Found = It.Value();
+					break;
+				}
+			}
+		}
+
+		if (Found == INDEX_NONE)
+		{
+			continue;
+		}
+		Expected = Found + 1;
+
+		const FBsonPropertyPlan& Property = Plan.Properties[Found];
+		if (!DecodeProperty(Property, FBsonObject::LibbsonImpl::ViewFromIter(&iter), OutStruct))
+		{
+			UE_LOG(LogBson, Warning, TEXT("BsonObjectToUStruct - Unable to parse %s."), *Property.Key.ToString());
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+bool FBsonObjectConverter::DecodeProperty(const FBsonPropertyPlan& Property, const FBsonValueView& View, void* OutStruct)
+{
+	uint8* Value = (uint8*)OutStruct + Property.Offset;
+	const int32 ArrayDim = Property.Property->ArrayDim;
+
+	if (ArrayDim == 1)
+	{
+		return DecodeValue(Property, View, Value);
+	}
+
+	// static arrays, surplus elements are ignored
+	if (View.GetBsonType() != BSON_TYPE_ARRAY)
+	{
+		return false;
+	}
+	TArrayView<const uint8> Bytes = View.AsDocumentView();
+	bson_t Array;
+	bson_iter_t iter;
+	if (!bson_init_static(&Array, Bytes.GetData(), Bytes.Num()) || !bson_iter_init(&iter, &Array))
+	{
+		return false;
+	}
+
+	for (int32 Index = 0; Index < ArrayDim && bson_iter_next(&iter); Index++)
+	{
+		if (!DecodeValue(Property, FBsonObject::LibbsonImpl::ViewFromIter(&iter), Value + Index * Property.Property->ElementSize))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool FBsonObjectConverter::DecodeValue(const FBsonPropertyPlan& Property, const FBsonValueView& View, void* OutValue)
+{
+	// keep the current value, same as a missing field
+	if (View.IsNull())
+	{
+		return true;
+	}
+
+	int64 Integer;
+	double Double;
+
+	switch (Property.Kind)
+	{
+	case EBsonPropertyKind::Bool:
+	{
+		bool Bool;
+		if (!View.TryGetBool(Bool))
+		{
+			return false;
+		}
+		static_cast<const UBoolProperty*>(Property.Property)->SetPropertyValue(OutValue, Bool);
+		return true;
+	}
+	case EBsonPropertyKind::Int8:
+	case EBsonPropertyKind::Int16:
+	case EBsonPropertyKind::Int32:
+	case EBsonPropertyKind::Int64:
+	case EBsonPropertyKind::UInt8:
+	case EBsonPropertyKind::UInt16:
+	case EBsonPropertyKind::UInt32:
+	case EBsonPropertyKind::UInt64:
+		if (!View.TryGetNumber(Integer))
+		{
+			return false;
+		}
+		static_cast<const UNumericProperty*>(Property.Property)->SetIntPropertyValue(OutValue, Integer);
+		return true;
+	case EBsonPropertyKind::Float:
+		if (!View.TryGetNumber(Double))
+		{
+			return false;
+		}
+		*(float*)OutValue = (float)Double;
+		return true;
+	case EBsonPropertyKind::Double:
+		if (!View.TryGetNumber(Double))
+		{
+			return false;
+		}
+		*(double*)OutValue = Double;
+		return true;
+	case EBsonPropertyKind::Enum:
+		if (View.GetBsonType() == BSON_TYPE_UTF8)
+		{
+			Integer = Property.Enum->GetValueByNameString(View.AsString());
+			if (Integer == INDEX_NONE)
+			{
+				return false;
+			}
+		}
+		else if (!View.TryGetNumber(Integer))
+		{
+			return false;
+		}
+		Property.Underlying->SetIntPropertyValue(OutValue, Integer);
+		return true;
+	case EBsonPropertyKind::String:
+		if (View.GetBsonType() != BSON_TYPE_UTF8)
+		{
+			return false;
+		}
+		*(FString*)OutValue = View.AsString();
+		return true;
+	case EBsonPropertyKind::Name:
+		if (View.GetBsonType() != BSON_TYPE_UTF8)
+		{
+			return false;
+		}
+		*(FName*)OutValue = FName(*View.AsString());
+		return true;
+	case EBsonPropertyKind::Text:
+		if (View.GetBsonType() != BSON_TYPE_UTF8)
+		{
+			return false;
+		}
+		*(FText*)OutValue = FText::FromString(View.AsString());
+		return true;
+	case EBsonPropertyKind::DateTime:
+		if (View.GetBsonType() != BSON_TYPE_DATE_TIME || !View.TryGetNumber(Integer))
+		{
+			return false;
+		}
+		*(FDateTime*)OutValue = FBsonValueDateTime::FromUnixMilliseconds(Integer);
+		return true;
+	case EBsonPropertyKind::Struct:
+	{
+		if (View.GetBsonType() != BSON_TYPE_DOCUMENT)
+		{
+			return false;
+		}
+		TArrayView<const uint8> Bytes = View.AsDocumentView();
+		return DecodeStruct(*Property.StructPlan, Bytes.GetData(), Bytes.Num(), OutValue);
+	}
+	case EBsonPropertyKind::Array:
+	{
+		if (View.GetBsonType() != BSON_TYPE_ARRAY)
+		{
+			return false;
+		}
+		TArrayView<const uint8> Bytes = View.AsDocumentView();
+		bson_t Array;
+		bson_iter_t iter;
+		if (!bson_init_static(&Array, Bytes.GetData(), Bytes.Num()) || !bson_iter_init(&iter, &Array))
+		{
+			return false;
+		}
+
+		FScriptArrayHelper Helper(static_cast<const UArrayProperty*>(Property.Property), OutValue);
+		Helper.EmptyValues();
+		while (bson_iter_next(&iter))
+		{
+			int32 Index = Helper.AddValue();
+			if (!DecodeValue(*Property.Inner, FBsonObject::LibbsonImpl::ViewFromIter(&iter), Helper.GetRawPtr(Index)))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	case EBsonPropertyKind::ExportedText:
+		if (View.GetBsonType() != BSON_TYPE_UTF8)
+		{
+			return false;
+		}
+		return Property.Property->ImportText(*View.AsString(), OutValue, PPF_None, nullptr) != nullptr;
+	}
+
+	return false;
+}
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BsonObjectId.h"
+#include <bson.h>
+
+
+FBsonObjectId FBsonObjectId::Generate()
+{
+	bson_oid_t oid;
+	bson_oid_init(&oid, nullptr);
+	return FBsonObjectId(oid.bytes);
+}
+
+bool FBsonObjectId::FromString(const FString& String, FBsonObjectId& OutId)
+{
+	FTCHARToUTF8 Utf8(*String);
+	if (!bson_oid_is_valid(Utf8.Get(), Utf8.Length()))
+	{
+		return false;
+	}
+
+	bson_oid_t oid;
+	bson_oid_init_from_string(&oid, Utf8.Get());
+	OutId = FBsonObjectId(oid.bytes);
+	return true;
+}
+
+FString FBsonObjectId::ToString() const
+{
+	bson_oid_t oid;
+	char String[25];
+	FMemory::Memcpy(oid.bytes, Bytes, sizeof(Bytes));
+	bson_oid_to_string(&oid, String);
+	return FString(String);
+}
@@ -0,0 +1,1471 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BsonObject.h"
+#include "UE4Bson.h"
+#include "BsonMemory.h"
+#include "BsonScopedArena.h"
+#include "Templates/Atomic.h"
+#include <bson.h>
+
+
+/**
+* \brief An FBsonKey converted from an FString field name on the fly, without interning it.
+*/
+struct FTransientBsonKey : private FTCHARToUTF8, public FBsonKey {
+
+	explicit FTransientBsonKey(const FString &FieldName)
+		: FTCHARToUTF8(*FieldName), FBsonKey(FTCHARToUTF8::Get(), FTCHARToUTF8::Length()) {}
+};
+
+
+/**
+* \brief The decimal key of an array element.
+*
+* Indices below 1000 are taken from libbson's table of precomputed index strings,
+* larger ones are formatted into the local buffer without going through FString.
+*/
+struct FBsonArrayIndexKey {
+
+	const char *Key;
+	int32 Length;
+
+	explicit FBsonArrayIndexKey(uint32 Index) {
+		Length = (int32)bson_uint32_to_string(Index, &Key, Buffer, sizeof(Buffer));
+	}
+
+	FBsonKey ToKey() const {
+		return FBsonKey(Key, Length);
+	}
+
+private:
+
+	char Buffer[16];
+
+	// Key may point into Buffer
+	FBsonArrayIndexKey(const FBsonArrayIndexKey&) = delete;
+	FBsonArrayIndexKey& operator=(const FBsonArrayIndexKey&) = delete;
+};
+
+
+/**
+* \brief A bson_t that is shared between an FBsonObject and all the subdocuments aliasing its bytes.
+*/
+struct FBsonSharedDocument {
+
+	/** The owned document, nullptr if the bytes are an adopted Buffer instead. */
+	bson_t *Doc;
+
+	/** The bson_t Doc points to. */
+	bson_t Storage;
+
+	/** Bytes adopted from the caller, read through a static bson_t. */
+	TArray<uint8> Buffer;
+
+	/**
+	* Takes over the document of a writable bson_t, leaving Source invalid.
+	* A heap buffer changes hands without being copied, so pointers into it stay valid.
+	*/
+	explicit FBsonSharedDocument(bson_t *Source) : Doc(&Storage) {
+		bson_steal(&Storage, Source);
+	}
+
+	/** Takes ownership of the bytes of a serialized document. */
+	explicit FBsonSharedDocument(TArray<uint8> &&InBuffer) : Doc(nullptr), Buffer(MoveTemp(InBuffer)) {}
+
+	~FBsonSharedDocument() {
+		if (Doc) {
+			bson_destroy(Doc);
+		}
+	}
+};
+
+typedef TSharedPtr<FBsonSharedDocument, ESPMode::ThreadSafe> FBsonSharedDocumentPtr;
+
+
+struct FBsonObject::LibbsonImpl {
+	
+	/** The document to read from, either LocalDoc or SharedDoc->Doc. */
+	bson_t *bsonDoc;
+
+	/**
+	* Keeps the bytes alive that bsonDoc reads, unless they are in LocalDoc.
+	* If it isn't unique, other objects alias these bytes.
+	*/
+	FBsonSharedDocumentPtr SharedDoc;
+
+	/**
+	* Either the exclusively owned, writable document, using libbson's inline storage while it is small,
+	* or a read-only document placed on bytes owned by SharedDoc (a subdocument) or by the caller (borrowed).
+	* Keeping it inside the implementation saves the allocations of a separate bson_t and shared owner.
+	*/
+	bson_t LocalDoc;
+
+	/** Whether LocalDoc is placed on bytes it doesn't own, libbson keeps that flag private. */
+	bool bLocalDocReadOnly = false;
+
+	/** The largest length the document had when it was Reset(). */
+	uint32 PeakLength = 0;
+
+	/** Size of libbson's inline storage, longer documents always live in a heap buffer. */
+	static const uint32 InlineDocumentLength = 120;
+
+	/**
+	* Number of linear lookups on an unchanged document before the field index gets built.
+	*
+	* Building the index is a single pass over the document, about the cost of two linear lookups of an
+	* average field, and every indexed lookup after that is a hash probe. A document read only once per field
+	* name (e.g. passed through) never builds it, one read twice or more builds it on the second lookup.
+	* The Bson.Benchmark.FieldIndex automation test shows the crossover for documents of different sizes.
+	*/
+	static const int32 FieldIndexLookupThreshold = 1;
+
+	/** Documents smaller than this (libbson's inline storage) are always scanned linearly. */
+	static const uint32 FieldIndexMinDocumentLength = 120;
+
+	/** Byte offsets of the first occurrence of every top-level key, bucketed by the hash of the key. */
+	typedef TMultiMap<uint32, uint32> FFieldIndex;
+
+	/**
+	* The index of the current contents of bsonDoc, nullptr until it is built.
+	*
+	* Const lookups may run on several threads at the same time, so the index is built completely before it is
+	* published with a compare-exchange, and a thread losing the race deletes its own. Writes, which must not
+	* run concurrently with anything else, modify or drop it directly.
+	*/
+	mutable TAtomic<FFieldIndex*> FieldIndex;
+
+	/** Lookups on an indexable document done since the last write without the help of the index. */
+	mutable TAtomic<int32> UnindexedLookups;
+
+	/** The arena of the thread when this was created, the only one the document may allocate from. */
+	FBsonScopedArena *Arena = FBsonScopedArena::GetCurrent();
+
+	LibbsonImpl() : FieldIndex(nullptr), UnindexedLookups(0) {
+		bson_init(&LocalDoc);
+		bsonDoc = &LocalDoc;
+	}
+
+	/**
+	* Creates an empty document with room for the given number of bytes.
+	*/
+	explicit LibbsonImpl(uint32 ReserveBytes) : LibbsonImpl() {
+		// grows the heap buffer to 5 + ReserveBytes, the empty document stays as it is
+		if (ReserveBytes > InlineDocumentLength && bson_reserve_buffer(&LocalDoc, ReserveBytes)) {
+			Truncate(5);
+		}
+	}
+
+	LibbsonImpl(const uint8_t* Data, size_t Length) : LibbsonImpl() {
+		CopyToLocal(Data, Length);
+	}
+
+	LibbsonImpl(FString Data) : LibbsonImpl() {
+		bson_error_t t;
+		bson_t *parsedDoc = bson_new_from_json((const uint8_t*)TCHAR_TO_ANSI(*Data), -1, &t);
+		if (!parsedDoc) {
+			UE_LOG(LogBson, Error, TEXT("Error while converting from JSON: %s\nDocument has been initialized empty."), t.message);
+			return;
+		}
+		SetOwnedDoc(parsedDoc);
+	}
+
+	/**
+	* Creates a read-only subdocument that aliases a part of another document's bytes.
+	*
+	* @param Owner the shared document Data points into, invalid for bytes borrowed from the caller.
+	* @param Data the start of the embedded document.
+	* @param Length the length of the embedded document.
+	*/
+	LibbsonImpl(const FBsonSharedDocumentPtr &Owner, const uint8_t* Data, uint32 Length) : SharedDoc(Owner), FieldIndex(nullptr), UnindexedLookups(0) {
+		bsonDoc = &LocalDoc;
+		bLocalDocReadOnly = true;
+		if (!bson_init_static(&LocalDoc, Data, Length)) {
+			UE_LOG(LogBson, Error, TEXT("Aliased data is not a valid Bson document.\nDocument has been initialized empty."));
+			bson_init(&LocalDoc);
+			bLocalDocReadOnly = false;
+			SharedDoc.Reset();
+		}
+	}
+
+	/**
+	* Creates a read-only document on adopted bytes.
+	*/
+	LibbsonImpl(TArray<uint8> &&Buffer) : SharedDoc(MakeShareable(new FBsonSharedDocument(MoveTemp(Buffer)))), FieldIndex(nullptr), UnindexedLookups(0) {
+		bsonDoc = &LocalDoc;
+		bLocalDocReadOnly = true;
+		if (!bson_init_static(&LocalDoc, SharedDoc->Buffer.GetData(), SharedDoc->Buffer.Num())) {
+			UE_LOG(LogBson, Error, TEXT("Adopted data is not a valid Bson document.\nDocument has been initialized empty."));
+			bson_init(&LocalDoc);
+			bLocalDocReadOnly = false;
+			SharedDoc.Reset();
+		}
+	}
+
+	~LibbsonImpl() {
+		// a no-op for read-only documents
+		bson_destroy(&LocalDoc);
+		delete FieldIndex.Load();
+	}
+
+	/** @return true if bsonDoc may be written to without affecting other objects. */
+	bool IsWritable() const {
+		if (bsonDoc == &LocalDoc) {
+			return !bLocalDocReadOnly;
+		}
+		return SharedDoc.IsUnique();
+	}
+
+	/**
+	* Creates another implementation reading a part of this one's bytes (or all of them).
+	*
+	* Bytes that are owned by SharedDoc or borrowed are aliased, copy-on-write for both. A writable LocalDoc
+	* is copied: handing its buffer over to a SharedDoc here would change this object from a const, possibly
+	* concurrent call. Writes move large documents to a SharedDoc instead, see MakeUnique(), so only inline
+	* documents and ones that outgrew the inline storage with their last write are copied.
+	*
+	* @param Data the start of the document within bsonDoc's bytes.
+	* @param Length the length of the document.
+	*/
+	LibbsonImpl *AliasOrCopy(const uint8_t* Data, uint32 Length) const {
+		if (bsonDoc == &LocalDoc && !bLocalDocReadOnly) {
+			return new LibbsonImpl(Data, Length);
+		}
+		return new LibbsonImpl(SharedDoc, Data, Length);
+	}
+
+	/**
+	* Creates another implementation reading the same bytes, see AliasOrCopy().
+	*
+	* A document on bytes borrowed from the caller is copied, so copies can be kept after the borrowed
+	* bytes are gone, e.g. the documents handed out by the file readers.
+	*/
+	LibbsonImpl *Share() const {
+		if (bsonDoc == &LocalDoc && !SharedDoc.IsValid()) {
+			return new LibbsonImpl(bson_get_data(bsonDoc), bsonDoc->len);
+		}
+		return AliasOrCopy(bson_get_data(bsonDoc), bsonDoc->len);
+	}
+
+	/**
+	* Hands the heap buffer of the writable LocalDoc over to a new SharedDoc, so it can be aliased.
+	* The field index stays valid, the bytes are not moved.
+	*/
+	void MoveLocalToShared() {
+		SharedDoc = MakeShareable(new FBsonSharedDocument(&LocalDoc));
+		bsonDoc = SharedDoc->Doc;
+		bson_init(&LocalDoc);
+	}
+
+	/**
+	* Makes a new, empty LocalDoc the exclusively owned document.
+	*/
+	void InitLocal() {
+		bson_destroy(&LocalDoc);
+		bson_init(&LocalDoc);
+		bLocalDocReadOnly = false;
+		bsonDoc = &LocalDoc;
+		SharedDoc.Reset();
+		InvalidateFieldIndex();
+	}
+
+	/**
+	* Empties the document, keeping its buffer if it is exclusively owned.
+	*/
+	void Reset() {
+		PeakLength = FMath::Max<uint32>(PeakLength, bsonDoc->len);
+		if (IsWritable()) {
+			bson_reinit(bsonDoc);
+			InvalidateFieldIndex();
+		}
+		else {
+			InitLocal();
+		}
+	}
+
+	/**
+	* Makes LocalDoc an exclusively owned copy of a serialized document.
+	*
+	* @param Data the document to copy, may point into the bytes bsonDoc currently reads.
+	* @param Length the length of Data.
+	*/
+	void CopyToLocal(const uint8_t* Data, uint32 Length) {
+		// keeps Data alive while copying
+		FBsonSharedDocumentPtr Owner = MoveTemp(SharedDoc);
+		bson_t Validate;
+		InitLocal();
+
+		if (!bson_init_static(&Validate, Data, Length)) {
+			UE_LOG(LogBson, Error, TEXT("Data is not a valid Bson document.\nDocument has been initialized empty."));
+			return;
+		}
+		uint8_t *Dest = bson_reserve_buffer(&LocalDoc, Length);
+		if (!Dest) {
+			UE_LOG(LogBson, Error, TEXT("Could not allocate %u bytes for a Bson document.\nDocument has been initialized empty."), Length);
+			return;
+		}
+		FMemory::Memcpy(Dest, Data, Length);
+	}
+
+	/**
+	* Makes a bson_t created with one of the bson_new* functions the exclusively owned document.
+	*/
+	void SetOwnedDoc(bson_t *ownedDoc) {
+		bson_destroy(&LocalDoc);
+		bson_steal(&LocalDoc, ownedDoc);
+		bLocalDocReadOnly = false;
+		bsonDoc = &LocalDoc;
+		SharedDoc.Reset();
+		InvalidateFieldIndex();
+	}
+
+	/**
+	* Makes LocalDoc a read-only document on bytes borrowed from the caller, see FBsonObject::Borrow().
+	*
+	* @return false if Data isn't a valid document, which leaves an empty one.
+	*/
+	bool SetBorrowedDoc(const uint8_t* Data, uint32 Length) {
+		InitLocal();
+		if (!bson_init_static(&LocalDoc, Data, Length)) {
+			bson_init(&LocalDoc);
+			return false;
+		}
+		bLocalDocReadOnly = true;
+		return true;
+	}
+
+	/**
+	* Hands the buffer of the document over to the caller and leaves an empty document behind.
+	*
+	* @param OutLength the length of the document.
+	* @return the buffer, to be freed with bson_free().
+	*/
+	uint8_t *ReleaseBuffer(uint32_t *OutLength) {
+		// stealing an inline document allocates as well
+		FBsonMemory::FScopedArenaOverride Override(Arena);
+		if (!IsWritable()) {
+			CopyToLocal(bson_get_data(bsonDoc), bsonDoc->len);
+		}
+		uint8_t *Buffer;
+		if (bsonDoc == &LocalDoc) {
+			Buffer = bson_destroy_with_steal(&LocalDoc, true, OutLength);
+		}
+		else {
+			Buffer = bson_destroy_with_steal(SharedDoc->Doc, true, OutLength);
+			SharedDoc->Doc = nullptr;
+			SharedDoc.Reset();
+		}
+		bson_init(&LocalDoc);
+		bsonDoc = &LocalDoc;
+		InvalidateFieldIndex();
+		return Buffer;
+	}
+
+	/**
+	* Has to be called before every modification of bsonDoc.
+	*
+	* Copies the document if its bytes are shared with subdocuments (copy-on-write),
+	* so that neither this object's writes nor the aliasing objects are affected by each other.
+	*/
+	void PrepareWrite() {
+		MakeUnique();
+		InvalidateFieldIndex();
+	}
+
+	/**
+	* Copies the document if its bytes are shared with subdocuments, without touching a valid field index.
+	* Only for writes that keep FieldIndex up to date themselves, see UpsertField().
+	*
+	* A writable LocalDoc larger than the inline storage is moved to a SharedDoc, so that copies and
+	* subdocuments taken later can alias its heap buffer instead of copying it, see AliasOrCopy().
+	*
+	* Inside an FBsonScopedArena the document was not created in, the copy is allocated where the document
+	* belongs, and a document still in the inline storage is moved to such a heap buffer right away: libbson
+	* would otherwise do that with a plain malloc from the arena while appending.
+	*/
+	void MakeUnique() {
+		if (FBsonScopedArena::GetCurrent() == Arena) {
+			MakeUniqueInOwnArena();
+			return;
+		}
+
+		FBsonMemory::FScopedArenaOverride Override(Arena);
+		MakeUniqueInOwnArena();
+		if (bsonDoc == &LocalDoc && LocalDoc.len <= InlineDocumentLength) {
+			uint32 Length = LocalDoc.len;
+			if (bson_reserve_buffer(&LocalDoc, InlineDocumentLength)) {
+				LocalDoc.len = Length;
+			}
+		}
+	}
+
+	/** See MakeUnique(), with libbson allocating from the document's own arena. */
+	void MakeUniqueInOwnArena() {
+		if (!IsWritable()) {
+			CopyToLocal(bson_get_data(bsonDoc), bsonDoc->len);
+		}
+		if (bsonDoc == &LocalDoc && LocalDoc.len > InlineDocumentLength) {
+			MoveLocalToShared();
+		}
+	}
+
+	/**
+	* Sets a top-level field, replacing the first field with the same key instead of appending a duplicate.
+	*
+	* If the field exists and Overwrite manages to update its value in place, nothing else is touched.
+	* Otherwise the field is cut out, the new value is appended in its place and the fields behind it are
+	* appended again, so the order of the fields is kept. New fields are simply appended.
+	*
+	* @param Key the key of the field.
+	* @param Overwrite callable taking a bson_iter_t* placed on the existing field, returning true if it could overwrite it in place.
+	* @param Append callable taking the bson_t* to append the new field to, with Key.
+	*/
+	template<typename OverwriteType, typename AppendType>
+	void UpsertField(const FBsonKey &Key, OverwriteType Overwrite, AppendType Append) {
+		MakeUnique();
+
+		bson_iter_t iter;
+		if (!FindField(Key, &iter)) {
+			uint32 Offset = bsonDoc->len - 1;
+			Append(bsonDoc);
+			// appending doesn't move any other field
+			FFieldIndex *Index = FieldIndex.Load();
+			if (Index && bsonDoc->len - 1 > Offset) {
+				Index->Add(Key.GetHash(), Offset);
+			}
+			return;
+		}
+
+		if (Overwrite(&iter)) {
+			return;
+		}
+
+		uint32 Start = iter.off;
+		uint32 End = iter.next_off;
+		TArray<uint8, TInlineAllocator<256>> Tail;
+		Tail.Append(bson_get_data(bsonDoc) + End, bsonDoc->len - 1 - End);
+
+		InvalidateFieldIndex();
+		Truncate(Start + 1);
+		Append(bsonDoc);
+		if (Tail.Num() > 0) {
+			uint8_t *Dest = AppendRawBytes(Tail.Num());
+			if (!Dest) {
+				UE_LOG(LogBson, Error, TEXT("Fields behind a replaced field do not fit into the document and were dropped."));
+				return;
+			}
+			FMemory::Memcpy(Dest, Tail.GetData(), Tail.Num());
+		}
+	}
+
+	/**
+	* Removes all top-level fields matching a predicate in a single pass, without leaving the buffer.
+	*
+	* The kept fields are moved down over the removed ones run by run and the length is fixed up,
+	* so removing a single field costs one memmove of the fields behind it.
+	*
+	* @param ShouldRemove callable taking a const bson_iter_t* placed on a field, returning true if it has to be removed.
+	* @return the number of removed fields.
+	*/
+	template<typename PredicateType>
+	int32 RemoveFieldsWhere(PredicateType ShouldRemove) {
+		bson_iter_t iter;
+		if (!bson_iter_init(&iter, bsonDoc)) {
+			return 0;
+		}
+
+		// find the first field to remove before copying anything
+		bool bFound = false;
+		while (!bFound && bson_iter_next(&iter)) {
+			bFound = ShouldRemove(&iter);
+		}
+		if (!bFound) {
+			return 0;
+		}
+
+		if (!IsWritable()) {
+			uint32 Offset = iter.off;
+			MakeUnique();
+			InitIterAtOffset(&iter, Offset);
+		}
+		InvalidateFieldIndex();
+
+		uint8_t *Data = const_cast<uint8_t*>(bson_get_data(bsonDoc));
+		uint32 Write = iter.off;
+		uint32 RunStart = iter.next_off;
+		int32 NumRemoved = 1;
+
+		while (bson_iter_next(&iter)) {
+			if (ShouldRemove(&iter)) {
+				uint32 RunLength = iter.off - RunStart;
+				FMemory::Memmove(Data + Write, Data + RunStart, RunLength);
+				Write += RunLength;
+				RunStart = iter.next_off;
+				NumRemoved++;
+			}
+		}
+
+		uint32 RunLength = bsonDoc->len - 1 - RunStart;
+		FMemory::Memmove(Data + Write, Data + RunStart, RunLength);
+		Truncate(Write + RunLength + 1);
+
+		return NumRemoved;
+	}
+
+	/** Overwrite callable for UpsertField() that never overwrites in place. */
+	static bool NoOverwrite(bson_iter_t *iter) {
+		return false;
+	}
+
+	/**
+	* Overwrites the value of a fixed width field in place.
+	*
+	* @param iter an iterator on the mutable bsonDoc placed on the field.
+	* @param Bytes the little endian bytes of the new value.
+	* @param Length the number of bytes, has to be the size of the field's value.
+	*/
+	static void OverwriteValueBytes(bson_iter_t *iter, const void *Bytes, uint32 Length) {
+		FMemory::Memcpy(const_cast<uint8_t*>(iter->raw) + iter->d1, Bytes, Length);
+	}
+
+	/** libbson has no bson_iter_overwrite_date_time. */
+	static void OverwriteDateTime(bson_iter_t *iter, int64 Milliseconds) {
+		uint64 MillisecondsLE = BSON_UINT64_TO_LE((uint64)Milliseconds);
+		OverwriteValueBytes(iter, &MillisecondsLE, sizeof(MillisecondsLE));
+	}
+
+	/**
+	* Overwrites a field with an FBsonValue in place if both have the same fixed width type.
+	*
+	* @param iter an iterator on the mutable bsonDoc placed on the field.
+	* @param Value the new value.
+	* @return true if the field was overwritten.
+	*/
+	bool OverwriteFBsonValue(bson_iter_t *iter, const FBsonValue &Value) {
+		if (bson_iter_type(iter) != FindEquivalentFieldType(Value.Type)) {
+			return false;
+		}
+
+		switch (Value.Type) {
+		case EBson::Number:
+			bson_iter_overwrite_double(iter, Value.AsNumber());
+			return true;
+		case EBson::Boolean:
+			bson_iter_overwrite_bool(iter, Value.AsBool());
+			return true;
+		case EBson::Int32:
+			bson_iter_overwrite_int32(iter, (int32)Value.AsInt64());
+			return true;
+		case EBson::Int64:
+			bson_iter_overwrite_int64(iter, Value.AsInt64());
+			return true;
+		case EBson::DateTime:
+			OverwriteDateTime(iter, Value.AsInt64());
+			return true;
+		case EBson::ObjectId:
+			OverwriteValueBytes(iter, Value.AsObjectId().Bytes, 12);
+			return true;
+		case EBson::Decimal128:
+		{
+			bson_decimal128_t Decimal;
+			Decimal.low = static_cast<const FBsonValueDecimal128&>(Value).GetLow();
+			Decimal.high = static_cast<const FBsonValueDecimal128&>(Value).GetHigh();
+			bson_iter_overwrite_decimal128(iter, &Decimal);
+			return true;
+		}
+		case EBson::Null:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	/**
+	* Creates an FBsonObject aliasing (or, if small, copying) the embedded document an iterator is placed on.
+	*
+	* @param iter an iterator on bsonDoc placed on a BSON_TYPE_DOCUMENT.
+	* @return the read-only (copy-on-write) subdocument.
+	*/
+	TSharedPtr<FBsonObject> SubdocumentFromIter(const bson_iter_t *iter) const {
+		uint32_t length = 0;
+		const uint8_t *data = nullptr;
+		bson_iter_document(iter, &length, &data);
+		return MakeShareable(new FBsonObject(AliasOrCopy(data, length)));
+	}
+
+	/**
+	* Drops the field index, all indexed offsets become stale by a modification of bsonDoc.
+	*/
+	void InvalidateFieldIndex() {
+		UnindexedLookups = 0;
+		delete FieldIndex.Exchange(nullptr);
+	}
+
+	/**
+	* Places an iterator on the element starting at the given byte offset of bsonDoc.
+	*
+	* @param iter the iterator to initialize.
+	* @param Offset the offset of the element's type byte, as found in bson_iter_t::off.
+	* @return true if there is a valid element at Offset.
+	*/
+	bool InitIterAtOffset(bson_iter_t *iter, uint32 Offset) const {
+		if (!bson_iter_init(iter, bsonDoc)) {
+			return false;
+		}
+		iter->next_off = Offset;
+		return bson_iter_next(iter);
+	}
+
+	/**
+	* Checks whether the key of the element an iterator is placed on equals a given key.
+	*/
+	static bool IterKeyEquals(const bson_iter_t *iter, const char *Key, int32 KeyLength) {
+		// the value always starts right behind the zero terminating the key
+		return (int32)(iter->d1 - iter->key - 1) == KeyLength
+			&& FMemory::Memcmp(iter->raw + iter->key, Key, KeyLength) == 0;
+	}
+
+	/**
+	* Builds an index of the current contents of bsonDoc in a single pass and publishes it as FieldIndex.
+	*
+	* @return the published index, which is another thread's if that one was faster.
+	*/
+	const FFieldIndex *BuildFieldIndex() const {
+		FFieldIndex *NewIndex = new FFieldIndex;
+		bson_iter_t iter;
+		bson_iter_t existing;
+		if (bson_iter_init(&iter, bsonDoc)) {
+			while (bson_iter_next(&iter)) {
+				const char *Key = bson_iter_key(&iter);
+				int32 KeyLength = iter.d1 - iter.key - 1;
+				uint32 Hash = FBsonKey::HashUtf8(Key, KeyLength);
+
+				// only the first occurrence of a key is reachable, same as with bson_iter_find
+				bool bDuplicate = false;
+				for (auto It = NewIndex->CreateConstKeyIterator(Hash); It && !bDuplicate; ++It) {
+					bDuplicate = InitIterAtOffset(&existing, It.Value()) && IterKeyEquals(&existing, Key, KeyLength);
+				}
+				if (!bDuplicate) {
+					NewIndex->Add(Hash, iter.off);
+				}
+			}
+		}
+
+		FFieldIndex *Published = nullptr;
+		if (!FieldIndex.CompareExchange(Published, NewIndex)) {
+			delete NewIndex;
+			return Published;
+		}
+		return NewIndex;
+	}
+
+	/**
+	* Finds the first top-level field with the given key.
+	*
+	* Repeated lookups on an unchanged document are served from a lazily built index
+	* instead of scanning the whole document every time.
+	*
+	* @param Key the key to find.
+	* @param iter the iterator to place on the found field.
+	* @return true if the field was found.
+	*/
+	bool FindField(const FBsonKey &Key, bson_iter_t *iter) const {
+		const FFieldIndex *Index = FieldIndex.Load();
+		if (!Index) {
+			if (bsonDoc->len < FieldIndexMinDocumentLength || ++UnindexedLookups <= FieldIndexLookupThreshold) {
+				if (bson_iter_init(iter, bsonDoc)) {
+					while (bson_iter_next(iter)) {
+						if (IterKeyEquals(iter, Key.GetUtf8(), Key.Len())) {
+							return true;
+						}
+					}
+				}
+				return false;
+			}
+			Index = BuildFieldIndex();
+		}
+
+		for (auto It = Index->CreateConstKeyIterator(Key.GetHash()); It; ++It) {
+			if (InitIterAtOffset(iter, It.Value()) && IterKeyEquals(iter, Key.GetUtf8(), Key.Len())) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	* Appends an FBsonValue to a document, choosing the Bson type from the value's type.
+	*
+	* @param Parent the document to append the value to.
+	* @param Key the key of the value.
+	* @param KeyLength the length of Key.
+	* @param Value the value to append.
+	*/
+	static void AppendFBsonValue(bson_t *Parent, const char *Key, int32 KeyLength, const FBsonValue &Value) {
+		switch (Value.Type) {
+		case EBson::Array:
+			AppendFBsonValueArray(Parent, Key, KeyLength, Value.AsArray());
+			break;
+		case EBson::Boolean:
+			bson_append_bool(Parent, Key, KeyLength, Value.AsBool());
+			break;
+		case EBson::Number:
+			bson_append_double(Parent, Key, KeyLength, Value.AsNumber());
+			break;
+		case EBson::Object:
+			bson_append_document(Parent, Key, KeyLength, Value.AsObject()->ReadImpl().bsonDoc);
+			break;
+		case EBson::String:
+		{
+			FTCHARToUTF8 Utf8Value(*Value.AsString());
+			bson_append_utf8(Parent, Key, KeyLength, Utf8Value.Get(), Utf8Value.Length());
+			break;
+		}
+		case EBson::Null:
+			bson_append_null(Parent, Key, KeyLength);
+			break;
+		case EBson::Int32:
+			bson_append_int32(Parent, Key, KeyLength, (int32)Value.AsInt64());
+			break;
+		case EBson::Int64:
+			bson_append_int64(Parent, Key, KeyLength, Value.AsInt64());
+			break;
+		case EBson::DateTime:
+			bson_append_date_time(Parent, Key, KeyLength, Value.AsInt64());
+			break;
+		case EBson::ObjectId:
+		{
+			bson_oid_t oid;
+			FMemory::Memcpy(oid.bytes, Value.AsObjectId().Bytes, sizeof(oid.bytes));
+			bson_append_oid(Parent, Key, KeyLength, &oid);
+			break;
+		}
+		case EBson::Binary:
+		{
+			const TArray<uint8> &Binary = Value.AsBinary();
+			bson_append_binary(Parent, Key, KeyLength, (bson_subtype_t)static_cast<const FBsonValueBinary&>(Value).GetSubtype(), Binary.GetData(), Binary.Num());
+			break;
+		}
+		case EBson::Decimal128:
+		{
+			bson_decimal128_t Decimal;
+			Decimal.low = static_cast<const FBsonValueDecimal128&>(Value).GetLow();
+			Decimal.high = static_cast<const FBsonValueDecimal128&>(Value).GetHigh();
+			bson_append_decimal128(Parent, Key, KeyLength, &Decimal);
+			break;
+		}
+		case EBson::None:
+			UE_LOG(LogBson, Error, TEXT("Can not set field to a value without type, the field has been skipped."));
+			break;
+		default:
+			UE_LOG(LogBson, Warning, TEXT("Can not set field of unknown type."))
+		}
+	}
+
+	/**
+	* Appends all the FBsonValues inside a given TArray to a document as an array.
+	*
+	* The array and all nested arrays are written in place, without temporary documents.
+	*
+	* @param Parent the document to append the array to.
+	* @param Key the key of the array.
+	* @param KeyLength the length of Key.
+	* @param InArray the TArray of TSharedPtr<FBsonValue> to convert.
+	*/
+	static void AppendFBsonValueArray(bson_t *Parent, const char *Key, int32 KeyLength, const TArray<TSharedPtr<FBsonValue> > &InArray) {
+		bson_t Child;
+		bson_append_array_begin(Parent, Key, KeyLength, &Child);
+
+		uint32 ArrayIndex = 0;
+		for (const TSharedPtr<FBsonValue> &Value : InArray) {
+			FBsonArrayIndexKey IndexKey(ArrayIndex);
+			AppendFBsonValue(&Child, IndexKey.Key, IndexKey.Length, *Value);
+			ArrayIndex++;
+		}
+
+		bson_append_array_end(Parent, &Child);
+	}
+
+	/**
+	* Appends an FBsonVariant to a document, copying its encoded value.
+	*
+	* @param Parent the document to append the value to.
+	* @param Key the key of the value.
+	* @param KeyLength the length of Key.
+	* @param Value the value to append, EBson::None is written as null.
+	*/
+	static void AppendVariant(bson_t *Parent, const char *Key, int32 KeyLength, const FBsonVariant &Value) {
+		FBsonValueView View = Value.GetView();
+
+		switch (Value.GetBsonType()) {
+		case BSON_TYPE_DOCUMENT:
+		case BSON_TYPE_ARRAY:
+		{
+			TArrayView<const uint8> Bytes = View.AsDocumentView();
+			bson_t Child;
+			if (!bson_init_static(&Child, Bytes.GetData(), Bytes.Num())) {
+				bson_append_null(Parent, Key, KeyLength);
+			}
+			else if (Value.GetBsonType() == BSON_TYPE_ARRAY) {
+				bson_append_array(Parent, Key, KeyLength, &Child);
+			}
+			else {
+				bson_append_document(Parent, Key, KeyLength, &Child);
+			}
+			break;
+		}
+		case BSON_TYPE_UTF8:
+		{
+			TArrayView<const ANSICHAR> Utf8 = View.AsUtf8View();
+			bson_append_utf8(Parent, Key, KeyLength, Utf8.GetData(), Utf8.Num());
+			break;
+		}
+		case BSON_TYPE_BINARY:
+		{
+			TArrayView<const uint8> Binary = View.AsBinaryView();
+			bson_append_binary(Parent, Key, KeyLength, (bson_subtype_t)View.GetBinarySubtype(), Binary.GetData(), Binary.Num());
+			break;
+		}
+		case BSON_TYPE_DOUBLE:
+			bson_append_double(Parent, Key, KeyLength, View.AsDouble());
+			break;
+		case BSON_TYPE_INT32:
+			bson_append_int32(Parent, Key, KeyLength, View.AsInt32());
+			break;
+		case BSON_TYPE_INT64:
+			bson_append_int64(Parent, Key, KeyLength, View.AsInt64());
+			break;
+		case BSON_TYPE_DATE_TIME:
+			bson_append_date_time(Parent, Key, KeyLength, View.AsInt64());
+			break;
+		case BSON_TYPE_BOOL:
+			bson_append_bool(Parent, Key, KeyLength, View.AsBool());
+			break;
+		case BSON_TYPE_OID:
+		{
+			FBsonObjectId Id;
+			bson_oid_t oid;
+			Value.TryGetObjectId(Id);
+			FMemory::Memcpy(oid.bytes, Id.Bytes, sizeof(oid.bytes));
+			bson_append_oid(Parent, Key, KeyLength, &oid);
+			break;
+		}
+		case BSON_TYPE_DECIMAL128:
+		{
+			uint64 Low = 0;
+			uint64 High = 0;
+			Value.TryGetDecimal128(Low, High);
+			bson_decimal128_t Decimal;
+			Decimal.low = Low;
+			Decimal.high = High;
+			bson_append_decimal128(Parent, Key, KeyLength, &Decimal);
+			break;
+		}
+		default:
+			bson_append_null(Parent, Key, KeyLength);
+		}
+	}
+
+	/**
+	* Appends FBsonVariants to a document as an array.
+	*
+	* @param Parent the document to append the array to.
+	* @param Key the key of the array.
+	* @param KeyLength the length of Key.
+	* @param Values the elements of the array.
+	*/
+	static void AppendVariantArray(bson_t *Parent, const char *Key, int32 KeyLength, TArrayView<const FBsonVariant> Values) {
+		bson_t Child;
+		bson_append_array_begin(Parent, Key, KeyLength, &Child);
+		for (int32 Index = 0; Index < Values.Num(); Index++) {
+			FBsonArrayIndexKey IndexKey(Index);
+			AppendVariant(&Child, IndexKey.Key, IndexKey.Length, Values[Index]);
+		}
+		bson_append_array_end(Parent, &Child);
+	}
+
+	/**
+	* Copies all remaining values of an iterator into FBsonVariants.
+	*
+	* @param iter an iterator placed before the first value to copy.
+	* @param OutArray the array to add the values to.
+	*/
+	static void VariantsFromIter(bson_iter_t *iter, TArray<FBsonVariant> &OutArray) {
+		while (bson_iter_next(iter)) {
+			OutArray.Add(FBsonVariant::FromView(ViewFromIter(iter)));
+		}
+	}
+
+	/**
+	* Decodes all elements of an array field into FBsonVariants.
+	*
+	* @param Key the key of the array field.
+	* @param OutArray the array to reset and fill.
+	* @return false if the field doesn't exist or isn't an array.
+	*/
+	bool GetVariantArray(const FBsonKey &Key, TArray<FBsonVariant> &OutArray) const {
+		OutArray.Reset();
+
+		bson_iter_t iter;
+		bson_iter_t child;
+		if (!FindField(Key, &iter) || !BSON_ITER_HOLDS_ARRAY(&iter) || !bson_iter_recurse(&iter, &child)) {
+			return false;
+		}
+
+		VariantsFromIter(&child, OutArray);
+		return true;
+	}
+
+	static void AppendNumber(bson_t *Parent, const char *Key, int32 KeyLength, double Number) {
+		bson_append_double(Parent, Key, KeyLength, Number);
+	}
+
+	static void AppendNumber(bson_t *Parent, const char *Key, int32 KeyLength, float Number) {
+		bson_append_double(Parent, Key, KeyLength, Number);
+	}
+
+	static void AppendNumber(bson_t *Parent, const char *Key, int32 KeyLength, int32 Number) {
+		bson_append_int32(Parent, Key, KeyLength, Number);
+	}
+
+	static void AppendNumber(bson_t *Parent, const char *Key, int32 KeyLength, int64 Number) {
+		bson_append_int64(Parent, Key, KeyLength, Number);
+	}
+
+	/**
+	* Appends a contiguous block of numbers to a document as an array.
+	*
+	* @param Parent the document to append the array to.
+	* @param Key the key of the array.
+	* @param KeyLength the length of Key.
+	* @param Numbers the elements of the array.
+	*/
+	template<typename NumberType>
+	static void AppendNumberArray(bson_t *Parent, const char *Key, int32 KeyLength, TArrayView<const NumberType> Numbers) {
+		bson_t Child;
+		bson_append_array_begin(Parent, Key, KeyLength, &Child);
+		for (int32 Index = 0; Index < Numbers.Num(); Index++) {
+			FBsonArrayIndexKey IndexKey(Index);
+			AppendNumber(&Child, IndexKey.Key, IndexKey.Length, Numbers[Index]);
+		}
+		bson_append_array_end(Parent, &Child);
+	}
+
+	static bool ConvertNumber(const FBsonValueView &View, float &OutNumber) {
+		double Number;
+		if (View.TryGetNumber(Number)) {
+			OutNumber = (float)Number;
+			return true;
+		}
+		return false;
+	}
+
+	template<typename NumberType>
+	static bool ConvertNumber(const FBsonValueView &View, NumberType &OutNumber) {
+		return View.TryGetNumber(OutNumber);
+	}
+
+	/**
+	* Decodes all elements of an array field into a TArray of numbers.
+	*
+	* @param Key the key of the array field.
+	* @param OutArray the array to reset and fill.
+	* Packed arrays of the same element type are copied as a whole.
+	*
+	* @return false if the field doesn't exist, isn't an array or holds an element that isn't a number.
+	*/
+	template<typename NumberType>
+	bool GetNumberArray(const FBsonKey &Key, TArray<NumberType> &OutArray) const {
+		OutArray.Reset();
+
+		bson_iter_t iter;
+		bson_iter_t child;
+		if (!FindField(Key, &iter)) {
+			return false;
+		}
+
+		const uint8_t *Elements;
+		int32 Num;
+		if (TPackedArrayElement<NumberType>::Code != 0
+			&& PackedArrayFromIter(&iter, TPackedArrayElement<NumberType>::Code, sizeof(NumberType), Elements, Num)) {
+			OutArray.SetNumUninitialized(Num);
+			FMemory::Memcpy(OutArray.GetData(), Elements, Num * sizeof(NumberType));
+			return true;
+		}
+
+		if (!BSON_ITER_HOLDS_ARRAY(&iter) || !bson_iter_recurse(&iter, &child)) {
+			return false;
+		}
+
+		NumberType Number;
+		while (bson_iter_next(&child)) {
+			if (!ConvertNumber(ViewFromIter(&child), Number)) {
+				OutArray.Reset();
+				return false;
+			}
+			OutArray.Add(Number);
+		}
+		return true;
+	}
+
+	/** User defined binary subtype marking a packed array written by SetPackedArrayField(). */
+	static const uint8 PackedArraySubtype = BSON_SUBTYPE_USER | 0x10;
+
+	/** Size of the header of a packed array without padding: element type and header length. */
+	static const uint32 PackedArrayHeaderLength = 2;
+
+	/**
+	* Cuts the writable bsonDoc off at the given length, which has to be the end of an element plus the terminating zero.
+	*
+	* Doesn't go through bson_reserve_buffer(), which always needs room for the current length plus the
+	* requested one and could reallocate or move an inline document to the heap. The len member sits at
+	* the same place in libbson's inline and heap layouts, so it is set directly and the buffer stays as it is.
+	*
+	* @param Length the new length of the document.
+	*/
+	void Truncate(uint32 Length) {
+		check(Length >= 5 && Length <= bsonDoc->len);
+		uint8_t *Data = const_cast<uint8_t*>(bson_get_data(bsonDoc));
+		check(Data);
+		bsonDoc->len = Length;
+		uint32 LengthLE = BSON_UINT32_TO_LE(Length);
+		FMemory::Memcpy(Data, &LengthLE, sizeof(LengthLE));
+		Data[Length - 1] = 0;
+	}
+
+	/**
+	* Grows bsonDoc by the given number of bytes in place and returns where they have to be written.
+	*
+	* Used for elements that can't be passed to a bson_append_* function in one piece. The caller has
+	* to fill in exactly Bytes bytes forming complete elements.
+	*
+	* @param Bytes the number of bytes to append.
+	* @return pointer to the first appended byte or nullptr if the document can't grow.
+	*/
+	uint8_t *AppendRawBytes(uint32 Bytes) {
+		uint32 OldLength = bsonDoc->len;
+		if (Bytes > BSON_MAX_SIZE - OldLength) {
+			return nullptr;
+		}
+		uint32 NewLength = OldLength + Bytes;
+		// bson_reserve_buffer(Size) makes room for len + Size bytes and sets len to Size,
+		// so asking for Bytes gives exactly NewLength bytes of capacity, len is fixed up below
+		uint8_t *Data = bson_reserve_buffer(bsonDoc, Bytes);
+		if (!Data) {
+			return nullptr;
+		}
+		bsonDoc->len = NewLength;
+		uint32 LengthLE = BSON_UINT32_TO_LE(NewLength);
+		FMemory::Memcpy(Data, &LengthLE, sizeof(LengthLE));
+		Data[NewLength - 1] = 0;
+		// the new bytes start at the old terminating zero
+		return Data + OldLength - 1;
+	}
+
+	/**
+	* Appends a binary field holding a packed array:
+	* one byte element type code, one byte header length, padding, then the raw little endian elements.
+	*
+	* The padding aligns the elements relative to the start of the document, so they can be read in place
+	* whenever the document's buffer is aligned (libbson's inline and heap buffers are), and the bytes written
+	* don't depend on where the document happens to live. Embedding the document into another one, or reading
+	* it at an arbitrary offset of a dump, can still leave the elements unaligned.
+	*
+	* @param Key the key of the field.
+	* @param KeyLength the length of Key.
+	* @param TypeCode the code identifying the element type.
+	* @param Elements the raw elements.
+	* @param ElementSize the size of a single element, also used as alignment.
+	* @param NumElements the number of elements, rejected if their bytes exceed the Bson size limit.
+	*/
+	void AppendPackedArray(const char *Key, int32 KeyLength, uint8 TypeCode, const void *Elements, uint32 ElementSize, int32 NumElements) {
+		const uint64 DataLength64 = (uint64)ElementSize * (uint64)FMath::Max(NumElements, 0);
+		if (DataLength64 > BSON_MAX_SIZE) {
+			UE_LOG(LogBson, Error, TEXT("Packed array of %d elements exceeds the Bson size limit."), NumElements);
+			return;
+		}
+		uint32 DataLength = (uint32)DataLength64;
+		// type, key, zero, binary length, subtype
+		uint32 PrefixLength = 1 + KeyLength + 1 + 4 + 1;
+		uint32 MaxPayloadLength = PackedArrayHeaderLength + ElementSize - 1 + DataLength;
+
+		uint8_t *Dest = AppendRawBytes(PrefixLength + MaxPayloadLength);
+		if (!Dest) {
+			UE_LOG(LogBson, Error, TEXT("Packed array of %u bytes does not fit into the document."), DataLength);
+			return;
+		}
+
+		uint8_t *Payload = Dest + PrefixLength;
+		uint32 ElementsOffset = (uint32)(Payload + PackedArrayHeaderLength - bson_get_data(bsonDoc));
+		uint32 Padding = (ElementSize - ElementsOffset % ElementSize) % ElementSize;
+		uint32 PayloadLength = PackedArrayHeaderLength + Padding + DataLength;
+
+		Dest[0] = BSON_TYPE_BINARY;
+		FMemory::Memcpy(Dest + 1, Key, KeyLength);
+		Dest[1 + KeyLength] = 0;
+		uint32 PayloadLengthLE = BSON_UINT32_TO_LE(PayloadLength);
+		FMemory::Memcpy(Dest + 2 + KeyLength, &PayloadLengthLE, sizeof(PayloadLengthLE));
+		Dest[PrefixLength - 1] = PackedArraySubtype;
+
+		Payload[0] = TypeCode;
+		Payload[1] = (uint8)(PackedArrayHeaderLength + Padding);
+		FMemory::Memzero(Payload + PackedArrayHeaderLength, Padding);
+		FMemory::Memcpy(Payload + PackedArrayHeaderLength + Padding, Elements, DataLength);
+
+		// give back the padding that wasn't needed
+		uint32 Unused = MaxPayloadLength - PayloadLength;
+		if (Unused > 0) {
+			Truncate(bsonDoc->len - Unused);
+		}
+	}
+
+	/**
+	* Sets a packed array field. An existing packed array with the same element type and count is overwritten in place.
+	*
+	* @param Key the key of the field.
+	* @param TypeCode the code identifying the element type.
+	* @param Elements the raw elements.
+	* @param ElementSize the size of a single element.
+	* @param NumElements the number of elements.
+	*/
+	void SetPackedArray(const FBsonKey &Key, uint8 TypeCode, const void *Elements, uint32 ElementSize, int32 NumElements) {
+		UpsertField(Key,
+			[&](bson_iter_t *iter) {
+				const uint8_t *Existing;
+				int32 Num;
+				if (!PackedArrayFromIter(iter, TypeCode, ElementSize, Existing, Num) || Num != NumElements) {
+					return false;
+				}
+				FMemory::Memcpy(const_cast<uint8_t*>(Existing), Elements, ElementSize * NumElements);
+				return true;
+			},
+			[&](bson_t *Doc) { AppendPackedArray(Key.GetUtf8(), Key.Len(), TypeCode, Elements, ElementSize, NumElements); });
+	}
+
+	/**
+	* Reads the elements of a packed array field an iterator is placed on.
+	*
+	* @param iter an iterator placed on a field.
+	* @param TypeCode the expected element type code.
+	* @param ElementSize the size of a single element.
+	* @param OutElements the start of the elements, not necessarily aligned.
+	* @param OutNum the number of elements.
+	* @return false if the field isn't a packed array of the expected type.
+	*/
+	static bool PackedArrayFromIter(const bson_iter_t *iter, uint8 TypeCode, uint32 ElementSize, const uint8_t *&OutElements, int32 &OutNum) {
+		if (!BSON_ITER_HOLDS_BINARY(iter)) {
+			return false;
+		}
+
+		bson_subtype_t subtype;
+		uint32_t length = 0;
+		const uint8_t *data = nullptr;
+		bson_iter_binary(iter, &subtype, &length, &data);
+		if (subtype != PackedArraySubtype || length < PackedArrayHeaderLength || data[0] != TypeCode
+			|| data[1] < PackedArrayHeaderLength || data[1] > length || (length - data[1]) % ElementSize != 0) {
+			return false;
+		}
+
+		OutElements = data + data[1];
+		OutNum = (length - data[1]) / ElementSize;
+		return true;
+	}
+
+	/** Element type codes of packed arrays, zero for types that can't be packed. */
+	template<typename ElementType> struct TPackedArrayElement { static const uint8 Code = 0; };
+
+	/**
+	* Creates an in-place view of a packed array field.
+	*
+	* @param Key the key of the field.
+	* @param OutView the view to set.
+	* @return false if the field doesn't exist, isn't a packed array of ElementType or isn't aligned.
+	*/
+	template<typename ElementType>
+	bool GetPackedArrayView(const FBsonKey &Key, TArrayView<const ElementType> &OutView) const {
+		bson_iter_t iter;
+		const uint8_t *Elements;
+		int32 Num;
+		if (!FindField(Key, &iter) || !PackedArrayFromIter(&iter, TPackedArrayElement<ElementType>::Code, sizeof(ElementType), Elements, Num)) {
+			return false;
+		}
+		if ((UPTRINT)Elements % alignof(ElementType) != 0) {
+			return false;
+		}
+
+		OutView = TArrayView<const ElementType>((const ElementType*)Elements, Num);
+		return true;
+	}
+
+	/**
+	* Converts an Array in a bson_t to an FBsonValueArray.
+	*
+	* @param iter an iterator placed on an array in a bson_t.
+	* @return the resulting FBsonValueArray in a TSharedPtr
+	*/
+	TSharedPtr<FBsonValueArray> FBsonValueArrayFromBson(bson_iter_t *iter) const {
+		TArray<TSharedPtr<FBsonValue>> returnArray;
+		while (bson_iter_next(iter)) {
+			returnArray.Add(ValueFromIter(iter));
+		}
+
+		return MakeShareable(new FBsonValueArray{ returnArray });
+	}
+	
+
+	/**
+	* Returns the appropriate EBson for a given bson_type_t.
+	*
+	* @param fieldType The bson_type_t to convert.
+	* @return EBson the converted EBson
+	*/
+	static EBson FindEquivalentFieldType(bson_type_t fieldType) {
+		switch (fieldType) {
+		case BSON_TYPE_ARRAY:
+			return EBson::Array;
+		case BSON_TYPE_BOOL:
+			return EBson::Boolean;
+		case BSON_TYPE_DOUBLE:
+			return EBson::Number;
+		case BSON_TYPE_UTF8:
+			return EBson::String;
+		case BSON_TYPE_DOCUMENT:
+			return EBson::Object;
+		case BSON_TYPE_NULL:
+			return EBson::Null;
+		case BSON_TYPE_INT32:
+			return EBson::Int32;
+		case BSON_TYPE_INT64:
+			return EBson::Int64;
+		case BSON_TYPE_DATE_TIME:
+			return EBson::DateTime;
+		case BSON_TYPE_OID:
+			return EBson::ObjectId;
+		case BSON_TYPE_BINARY:
+			return EBson::Binary;
+		case BSON_TYPE_DECIMAL128:
+			return EBson::Decimal128;
+		default:
+			return EBson::None;
+		}
+	}
+
+	/**
+	* Converts the value an iterator is placed on to an FBsonValue.
+	*
+	* @param iter an iterator on bsonDoc placed on a value.
+	* @return TSharedPtr with an appropriate FBsonValue.
+	*/
+	TSharedPtr<FBsonValue> ValueFromIter(const bson_iter_t *iter) const {
+		switch (bson_iter_type(iter)) {
+		case BSON_TYPE_ARRAY:
+		{
+			// if the requested field is of type BSON_TYPE_ARRAY this will be necessary to recurse into it
+			bson_iter_t arrayIter;
+			bson_iter_recurse(iter, &arrayIter);
+			return FBsonValueArrayFromBson(&arrayIter);
+		}
+		case BSON_TYPE_BOOL:
+			return MakeShareable(new FBsonValueBoolean{ bson_iter_as_bool(iter) });
+		case BSON_TYPE_DOUBLE:
+			return MakeShareable(new FBsonValueNumber{ bson_iter_as_double(iter) });
+		case BSON_TYPE_UTF8:
+			return MakeShareable(new FBsonValueString{ bson_iter_utf8(iter, NULL) });
+		case BSON_TYPE_DOCUMENT:
+			return MakeShareable(new FBsonValueObject{ SubdocumentFromIter(iter) });
+		case BSON_TYPE_NULL:
+			return MakeShareable(new FBsonValueNull());
+		case BSON_TYPE_INT32:
+			return MakeShareable(new FBsonValueInt32{ bson_iter_int32(iter) });
+		case BSON_TYPE_INT64:
+			return MakeShareable(new FBsonValueInt64{ bson_iter_int64(iter) });
+		case BSON_TYPE_DATE_TIME:
+			return MakeShareable(new FBsonValueDateTime{ bson_iter_date_time(iter) });
+		case BSON_TYPE_OID:
+			return MakeShareable(new FBsonValueObjectId{ FBsonObjectId(bson_iter_oid(iter)->bytes) });
+		case BSON_TYPE_BINARY:
+		{
+			bson_subtype_t subtype;
+			uint32_t length = 0;
+			const uint8_t *data = nullptr;
+			bson_iter_binary(iter, &subtype, &length, &data);
+			return MakeShareable(new FBsonValueBinary{ TArray<uint8>(data, length), (uint8)subtype });
+		}
+		case BSON_TYPE_DECIMAL128:
+		{
+			bson_decimal128_t Decimal;
+			bson_iter_decimal128(iter, &Decimal);
+			return MakeShareable(new FBsonValueDecimal128{ Decimal.low, Decimal.high });
+		}
+		default:
+			UE_LOG(LogBson, Warning, TEXT("Unsupported Type: %d (see http://mongoc.org/libbson/current/bson_type_t.html for reference)."), bson_iter_type(iter))
+				return MakeShareable(new FBsonValueNull());
+		}
+	}
+
+	/**
+	* Finds a nested field by descending through subdocuments and arrays along a path.
+	*
+	* @param Path the keys to follow, the first one is looked up in bsonDoc.
+	* @param iter the iterator to place on the found field.
+	* @return true if the whole path was found.
+	*/
+	bool FindPath(const FBsonPath &Path, bson_iter_t *iter) const {
+		if (Path.IsEmpty() || !FindField(Path.GetSegment(0), iter)) {
+			return false;
+		}
+
+		bson_iter_t child;
+		for (int32 Segment = 1; Segment < Path.Num(); Segment++) {
+			if (!(BSON_ITER_HOLDS_DOCUMENT(iter) || BSON_ITER_HOLDS_ARRAY(iter)) || !bson_iter_recurse(iter, &child)) {
+				return false;
+			}
+
+			FBsonKey Key = Path.GetSegment(Segment);
+			bool bFound = false;
+			while (!bFound && bson_iter_next(&child)) {
+				bFound = IterKeyEquals(&child, Key.GetUtf8(), Key.Len());
+			}
+			if (!bFound) {
+				return false;
+			}
+			*iter = child;
+		}
+		return true;
+	}
+
+	/**
+	* Calls Visitor(Slot, iter) for the first occurrence of every field of a set that exists in bsonDoc.
+	*
+	* Uses the field index if it is already built, otherwise scans the document once and stops
+	* as soon as all fields were found.
+	*
+	* @param Fields the set of field names to find.
+	* @param Visitor callable taking the index of the field within Fields and an iterator placed on it.
+	* @return the number of fields found.
+	*/
+	template<typename VisitorType>
+	int32 FindFields(const FBsonFieldSet &Fields, VisitorType Visitor) const {
+		int32 NumFound = 0;
+		bson_iter_t iter;
+
+		if (FieldIndex.Load()) {
+			for (int32 Slot = 0; Slot < Fields.Num(); Slot++) {
+				const FBsonKey &Key = Fields.GetKey(Slot);
+				if (Fields.Find(Key) == Slot && FindField(Key, &iter)) {
+					Visitor(Slot, &iter);
+					NumFound++;
+				}
+			}
+			return NumFound;
+		}
+
+		TArray<bool, TInlineAllocator<32>> Found;
+		Found.SetNumZeroed(Fields.Num());
+		if (bson_iter_init(&iter, bsonDoc)) {
+			while (NumFound < Fields.NumUnique() && bson_iter_next(&iter)) {
+				int32 Slot = Fields.Find(FBsonKey(bson_iter_key(&iter), iter.d1 - iter.key - 1));
+				if (Slot != INDEX_NONE && !Found[Slot]) {
+					Found[Slot] = true;
+					Visitor(Slot, &iter);
+					NumFound++;
+				}
+			}
+		}
+		return NumFound;
+	}
+
+	/**
+	* Creates a view of the value an iterator is placed on, pointing into the iterated buffer.
+	*
+	* @param iter an iterator placed on a value.
+	* @return the view of the value.
+	*/
+	static FBsonValueView ViewFromIter(const bson_iter_t *iter) {
+		bson_type_t fieldType = bson_iter_type(iter);
+		EBson Type = FindEquivalentFieldType(fieldType);
+		uint32_t length = 0;
+		const uint8_t *data = nullptr;
+
+		switch (fieldType) {
+		case BSON_TYPE_UTF8:
+			data = (const uint8_t*)bson_iter_utf8(iter, &length);
+			return FBsonValueView(Type, fieldType, data, length);
+		case BSON_TYPE_BINARY:
+		{
+			bson_subtype_t subtype;
+			bson_iter_binary(iter, &subtype, &length, &data);
+			return FBsonValueView(Type, fieldType, data, length, subtype);
+		}
+		case BSON_TYPE_DOCUMENT:
+			bson_iter_document(iter, &length, &data);
+			return FBsonValueView(Type, fieldType, data, length);
+		case BSON_TYPE_ARRAY:
+			bson_iter_array(iter, &length, &data);
+			return FBsonValueView(Type, fieldType, data, length);
+		default:
+			// fixed size values are stored right behind the key
+			return FBsonValueView(Type, fieldType, iter->raw + iter->d1, iter->next_off - iter->d1);
+		}
+	}
+
+	/**
+	* Returns the appropriate bson_type_t for a given EBson.
+	*
+	* @param fieldType The EBson to convert.
+	* @return bson_type_t the converted bson_type_t
+	*/
+	static bson_type_t FindEquivalentFieldType(EBson fieldType) {
+		switch (fieldType) {
+		case EBson::Array:
+			return BSON_TYPE_ARRAY;
+		case EBson::Boolean:
+			return BSON_TYPE_BOOL;
+		case EBson::Number:
+			return BSON_TYPE_DOUBLE;
+		case EBson::String:
+			return BSON_TYPE_UTF8;
+		case EBson::Object:
+			return BSON_TYPE_DOCUMENT;
+		case EBson::Null:
+			return BSON_TYPE_NULL;
+		case EBson::Int32:
+			return BSON_TYPE_INT32;
+		case EBson::Int64:
+			return BSON_TYPE_INT64;
+		case EBson::DateTime:
+			return BSON_TYPE_DATE_TIME;
+		case EBson::ObjectId:
+			return BSON_TYPE_OID;
+		case EBson::Binary:
+			return BSON_TYPE_BINARY;
+		case EBson::Decimal128:
+			return BSON_TYPE_DECIMAL128;
+		default:
+			return BSON_TYPE_UNDEFINED;
+		}
+	}
+
+};
+
+FORCEINLINE const FBsonObject::LibbsonImpl &FBsonObject::ReadImpl() const {
+	if (Impl) {
+		return *Impl;
+	}
+	// never written to, const reads don't change an empty document
+	static const LibbsonImpl Empty;
+	return Empty;
+}
+
+FORCEINLINE FBsonObject::LibbsonImpl &FBsonObject::WriteImpl() {
+	if (!Impl) {
+		Impl = new LibbsonImpl;
+	}
+	return *Impl;
+}
+
+template<> struct FBsonObject::LibbsonImpl::TPackedArrayElement<uint8> { static const uint8 Code = 1; };
+template<> struct FBsonObject::LibbsonImpl::TPackedArrayElement<float> { static const uint8 Code = 2; };
+template<> struct FBsonObject::LibbsonImpl::TPackedArrayElement<double> { static const uint8 Code = 3; };
@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BsonPath.h"
+
+
+FBsonPath::FBsonPath(const FString& Path)
+{
+	// "joints[3].position" addresses the same field as "joints.3.position"
+	FString DottedPath = Path.Replace(TEXT("["), TEXT(".")).Replace(TEXT("]"), TEXT(""));
+
+	TArray<FString> Keys;
+	DottedPath.ParseIntoArray(Keys, TEXT("."), true);
+
+	for (const FString& Key : Keys)
+	{
+		FTCHARToUTF8 Utf8Key(*Key);
+		SegmentStarts.Add(Utf8Keys.Num());
+		SegmentLengths.Add(Utf8Key.Length());
+		SegmentHashes.Add(FBsonKey::HashUtf8(Utf8Key.Get(), Utf8Key.Length()));
+		Utf8Keys.Append(Utf8Key.Get(), Utf8Key.Length());
+		Utf8Keys.Add('\0');
+	}
+}
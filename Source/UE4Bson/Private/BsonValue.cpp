@@ -3,8 +3,11 @@
 #include "BsonValue.h"
 #include "UE4Bson.h"
 #include "BsonObject.h"
+#include <bson.h>
+#include <stdlib.h>
 
 const TArray<TSharedPtr<FBsonValue>> FBsonValue::EMPTY_ARRAY;
+const TArray<uint8> FBsonValue::EMPTY_BINARY;
 const TSharedPtr<FBsonObject> FBsonValue::EMPTY_OBJECT(new FBsonObject());
 
 double FBsonValue::AsNumber() const
@@ -59,6 +62,58 @@ const TArray<TSharedPtr<FBsonValue>>& FBsonValue::AsArray() const
 }
 
 
+int64 FBsonValue::AsInt64() const
+{
+	int64 Number = 0;
+
+	if (!TryGetNumber(Number))
+	{
+		ErrorMessage(TEXT("Int64"));
+	}
+
+	return Number;
+}
+
+
+FDateTime FBsonValue::AsDateTime() const
+{
+	FDateTime DateTime;
+
+	if (!TryGetDateTime(DateTime))
+	{
+		ErrorMessage(TEXT("DateTime"));
+	}
+
+	return DateTime;
+}
+
+
+FBsonObjectId FBsonValue::AsObjectId() const
+{
+	FBsonObjectId Id;
+
+	if (!TryGetObjectId(Id))
+	{
+		ErrorMessage(TEXT("ObjectId"));
+	}
+
+	return Id;
+}
+
+
+const TArray<uint8>& FBsonValue::AsBinary() const
+{
+	const TArray<uint8> *Binary = &EMPTY_BINARY;
+
+	if (!TryGetBinary(Binary))
+	{
+		ErrorMessage(TEXT("Binary"));
+	}
+
+	return *Binary;
+}
+
+
 const TSharedPtr<FBsonObject>& FBsonValue::AsObject() const
 {
 	const TSharedPtr<FBsonObject> *Object = &EMPTY_OBJECT;
@@ -74,18 +129,11 @@ const TSharedPtr<FBsonObject>& FBsonValue::AsObject() const
 
 bool FBsonValue::TryGetNumber(int32& OutNumber) const
 {
-	double Double;
+	int64 Number;
 
-	if (TryGetNumber(Double) && (Double >= INT_MIN) && (Double <= INT_MAX))
+	if (TryGetNumber(Number) && (Number >= INT_MIN) && (Number <= INT_MAX))
 	{
-		if (Double >= 0.0)
-		{
-			OutNumber = (int32)(Double + 0.5);
-		}
-		else
-		{
-			OutNumber = (int32)(Double - 0.5);
-		}
+		OutNumber = (int32)Number;
 
 		return true;
 	}
@@ -96,11 +144,11 @@ bool FBsonValue::TryGetNumber(int32& OutNumber) const
 
 bool FBsonValue::TryGetNumber(uint32& OutNumber) const
 {
-	double Double;
+	int64 Number;
 
-	if (TryGetNumber(Double) && (Double >= 0.0) && (Double <= UINT_MAX))
+	if (TryGetNumber(Number) && (Number >= 0) && (Number <= UINT_MAX))
 	{
-		OutNumber = (uint32)(Double + 0.5);
+		OutNumber = (uint32)Number;
 
 		return true;
 	}
@@ -113,7 +161,8 @@ bool FBsonValue::TryGetNumber(int64& OutNumber) const
 {
 	double Double;
 
-	if (TryGetNumber(Double) && (Double >= INT64_MIN) && (Double <= INT64_MAX))
+	// INT64_MAX converts to 2^63, which is already out of range; NaN fails both comparisons
+	if (TryGetNumber(Double) && (Double >= -9223372036854775808.0) && (Double < 9223372036854775808.0))
 	{
 		if (Double >= 0.0)
 		{
@@ -193,6 +242,22 @@ bool FBsonValue::CompareEqual(const FBsonValue& Lhs, const FBsonValue& Rhs)
 		return false;
 	}
 
+	case EBson::Int32:
+	case EBson::Int64:
+	case EBson::DateTime:
+		return Lhs.AsInt64() == Rhs.AsInt64();
+
+	case EBson::ObjectId:
+		return Lhs.AsObjectId() == Rhs.AsObjectId();
+
+	case EBson::Binary:
+		return static_cast<const FBsonValueBinary&>(Lhs).GetSubtype() == static_cast<const FBsonValueBinary&>(Rhs).GetSubtype()
+			&& Lhs.AsBinary() == Rhs.AsBinary();
+
+	case EBson::Decimal128:
+		return static_cast<const FBsonValueDecimal128&>(Lhs).GetLow() == static_cast<const FBsonValueDecimal128&>(Rhs).GetLow()
+			&& static_cast<const FBsonValueDecimal128&>(Lhs).GetHigh() == static_cast<const FBsonValueDecimal128&>(Rhs).GetHigh();
+
 	default:
 		return false;
 	}
@@ -201,4 +266,38 @@ bool FBsonValue::CompareEqual(const FBsonValue& Lhs, const FBsonValue& Rhs)
 void FBsonValue::ErrorMessage(const FString& InType) const
 {
 	UE_LOG(LogBson, Error, TEXT("Bson Value of type '%s' used as a '%s'."), *GetType(), *InType);
-}
\ No newline at end of file
+}
+
+
+bool FBsonValueDecimal128::TryGetNumber(double& OutNumber) const
+{
+	bson_decimal128_t Decimal;
+	char String[BSON_DECIMAL128_STRING];
+	Decimal.low = Low;
+	Decimal.high = High;
+	bson_decimal128_to_string(&Decimal, String);
+
+	// may lose precision, a double has less significant digits than a Decimal128
+	char* End = nullptr;
+	const double Number = strtod(String, &End);
+
+	// NaN and Infinity aren't numbers here, and neither are exponents out of the range of a double
+	if (End == String || *End != 0 || !FMath::IsFinite(Number))
+	{
+		return false;
+	}
+	OutNumber = Number;
+	return true;
+}
+
+
+bool FBsonValueDecimal128::TryGetString(FString& OutString) const
+{
+	bson_decimal128_t Decimal;
+	char String[BSON_DECIMAL128_STRING];
+	Decimal.low = Low;
+	Decimal.high = High;
+	bson_decimal128_to_string(&Decimal, String);
+	OutString = String;
+	return true;
+}
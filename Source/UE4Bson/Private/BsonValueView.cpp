@@ -0,0 +1,250 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BsonValueView.h"
+#include "UE4Bson.h"
+#include <bson.h>
+
+
+double FBsonValueView::AsDouble() const
+{
+	double Number = 0.0;
+
+	if (!TryGetNumber(Number))
+	{
+		ErrorMessage(TEXT("Number"));
+	}
+
+	return Number;
+}
+
+
+int64 FBsonValueView::AsInt64() const
+{
+	int64 Number = 0;
+
+	if (!TryGetNumber(Number))
+	{
+		ErrorMessage(TEXT("Int64"));
+	}
+
+	return Number;
+}
+
+
+int32 FBsonValueView::AsInt32() const
+{
+	int32 Number = 0;
+
+	if (!TryGetNumber(Number))
+	{
+		ErrorMessage(TEXT("Int32"));
+	}
+
+	return Number;
+}
+
+
+bool FBsonValueView::AsBool() const
+{
+	bool Bool = false;
+
+	if (!TryGetBool(Bool))
+	{
+		ErrorMessage(TEXT("Boolean"));
+	}
+
+	return Bool;
+}
+
+
+TArrayView<const ANSICHAR> FBsonValueView::AsUtf8View() const
+{
+	TArrayView<const ANSICHAR> Utf8;
+
+	if (!TryGetUtf8(Utf8))
+	{
+		ErrorMessage(TEXT("String"));
+	}
+
+	return Utf8;
+}
+
+
+FString FBsonValueView::AsString() const
+{
+	TArrayView<const ANSICHAR> Utf8;
+	double Number;
+	bool Bool;
+
+	if (TryGetUtf8(Utf8))
+	{
+		FUTF8ToTCHAR Converted(Utf8.GetData(), Utf8.Num());
+		return FString(Converted.Length(), Converted.Get());
+	}
+	if (TryGetBool(Bool))
+	{
+		return Bool ? TEXT("true") : TEXT("false");
+	}
+	if (TryGetNumber(Number))
+	{
+		return FString::SanitizeFloat(Number, 0);
+	}
+
+	ErrorMessage(TEXT("String"));
+	return FString();
+}
+
+
+TArrayView<const uint8> FBsonValueView::AsBinaryView() const
+{
+	TArrayView<const uint8> Binary;
+
+	if (!TryGetBinary(Binary))
+	{
+		ErrorMessage(TEXT("Binary"));
+	}
+
+	return Binary;
+}
+
+
+TArrayView<const uint8> FBsonValueView::AsDocumentView() const
+{
+	if (BsonType != BSON_TYPE_DOCUMENT && BsonType != BSON_TYPE_ARRAY)
+	{
+		ErrorMessage(TEXT("Object"));
+		return TArrayView<const uint8>();
+	}
+
+	return TArrayView<const uint8>(Data, Length);
+}
+
+
+bool FBsonValueView::TryGetNumber(double& OutDouble) const
+{
+	switch (BsonType)
+	{
+	case BSON_TYPE_DOUBLE:
+	{
+		double Value;
+		FMemory::Memcpy(&Value, Data, sizeof(Value));
+		OutDouble = BSON_DOUBLE_FROM_LE(Value);
+		return true;
+	}
+	case BSON_TYPE_INT32:
+	case BSON_TYPE_INT64:
+	case BSON_TYPE_DATE_TIME:
+	case BSON_TYPE_BOOL:
+	{
+		int64 Value;
+		TryGetNumber(Value);
+		OutDouble = (double)Value;
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+
+bool FBsonValueView::TryGetNumber(int64& OutNumber) const
+{
+	switch (BsonType)
+	{
+	case BSON_TYPE_INT32:
+	{
+		uint32 Value;
+		FMemory::Memcpy(&Value, Data, sizeof(Value));
+		OutNumber = (int32)BSON_UINT32_FROM_LE(Value);
+		return true;
+	}
+	case BSON_TYPE_INT64:
+	case BSON_TYPE_DATE_TIME:
+	{
+		uint64 Value;
+		FMemory::Memcpy(&Value, Data, sizeof(Value));
+		OutNumber = (int64)BSON_UINT64_FROM_LE(Value);
+		return true;
+	}
+	case BSON_TYPE_BOOL:
+		OutNumber = Data[0] ? 1 : 0;
+		return true;
+	case BSON_TYPE_DOUBLE:
+	{
+		double Double;
+		TryGetNumber(Double);
+		// INT64_MAX converts to 2^63, which is already out of range; NaN fails both comparisons
+		if ((Double >= -9223372036854775808.0) && (Double < 9223372036854775808.0))
+		{
+			OutNumber = (int64)(Double >= 0.0 ? Double + 0.5 : Double - 0.5);
+			return true;
+		}
+		return false;
+	}
+	default:
+		return false;
+	}
+}
+
+
+bool FBsonValueView::TryGetNumber(int32& OutNumber) const
+{
+	int64 Number;
+
+	if (TryGetNumber(Number) && (Number >= INT_MIN) && (Number <= INT_MAX))
+	{
+		OutNumber = (int32)Number;
+		return true;
+	}
+
+	return false;
+}
+
+
+bool FBsonValueView::TryGetBool(bool& OutBool) const
+{
+	if (BsonType == BSON_TYPE_BOOL)
+	{
+		OutBool = Data[0] != 0;
+		return true;
+	}
+
+	double Number;
+	if (TryGetNumber(Number))
+	{
+		OutBool = (Number != 0.0);
+		return true;
+	}
+
+	return false;
+}
+
+
+bool FBsonValueView::TryGetUtf8(TArrayView<const ANSICHAR>& OutUtf8) const
+{
+	if (BsonType != BSON_TYPE_UTF8)
+	{
+		return false;
+	}
+
+	OutUtf8 = TArrayView<const ANSICHAR>((const ANSICHAR*)Data, Length);
+	return true;
+}
+
+
+bool FBsonValueView::TryGetBinary(TArrayView<const uint8>& OutBinary) const
+{
+	if (BsonType != BSON_TYPE_BINARY)
+	{
+		return false;
+	}
+
+	OutBinary = TArrayView<const uint8>(Data, Length);
+	return true;
+}
+
+
+void FBsonValueView::ErrorMessage(const TCHAR* InType) const
+{
+	UE_LOG(LogBson, Error, TEXT("Bson Value of type '%d' used as a '%s'."), BsonType, InType);
+}
@@ -0,0 +1,309 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BsonVariant.h"
+#include "BsonObjectImpl.h"
+
+
+static_assert(sizeof(FBsonVariant) <= 24, "FBsonVariant should stay small enough to be stored by value.");
+
+
+FBsonVariant::FBsonVariant(EBson InType, uint8 InBsonType, const void* Bytes, uint32 Length, uint8 InSubtype)
+	: Type(InType), BsonType(InBsonType), Subtype(InSubtype), bOnHeap(false), InlineLength(0)
+{
+	SetBytes(Bytes, Length);
+}
+
+
+FBsonVariant::FBsonVariant(double Number)
+	: FBsonVariant(EBson::Number, BSON_TYPE_DOUBLE, nullptr, 0)
+{
+	double Value = BSON_DOUBLE_TO_LE(Number);
+	SetBytes(&Value, sizeof(Value));
+}
+
+
+FBsonVariant::FBsonVariant(int32 Number)
+	: FBsonVariant(EBson::Int32, BSON_TYPE_INT32, nullptr, 0)
+{
+	uint32 Value = BSON_UINT32_TO_LE((uint32)Number);
+	SetBytes(&Value, sizeof(Value));
+}
+
+
+FBsonVariant::FBsonVariant(int64 Number)
+	: FBsonVariant(EBson::Int64, BSON_TYPE_INT64, nullptr, 0)
+{
+	uint64 Value = BSON_UINT64_TO_LE((uint64)Number);
+	SetBytes(&Value, sizeof(Value));
+}
+
+
+FBsonVariant::FBsonVariant(bool Bool)
+	: FBsonVariant(EBson::Boolean, BSON_TYPE_BOOL, nullptr, 0)
+{
+	uint8 Value = Bool ? 1 : 0;
+	SetBytes(&Value, sizeof(Value));
+}
+
+
+FBsonVariant::FBsonVariant(const FString& String)
+	: FBsonVariant(EBson::String, BSON_TYPE_UTF8, nullptr, 0)
+{
+	FTCHARToUTF8 Utf8(*String);
+	SetBytes(Utf8.Get(), Utf8.Length());
+}
+
+
+FBsonVariant::FBsonVariant(const ANSICHAR* Utf8)
+	: FBsonVariant(EBson::String, BSON_TYPE_UTF8, Utf8, FCStringAnsi::Strlen(Utf8))
+{
+}
+
+
+FBsonVariant::FBsonVariant(const FDateTime& DateTime)
+	: FBsonVariant(EBson::DateTime, BSON_TYPE_DATE_TIME, nullptr, 0)
+{
+	uint64 Value = BSON_UINT64_TO_LE((uint64)FBsonValueDateTime::ToUnixMilliseconds(DateTime));
+	SetBytes(&Value, sizeof(Value));
+}
+
+
+FBsonVariant::FBsonVariant(const FBsonObjectId& Id)
+	: FBsonVariant(EBson::ObjectId, BSON_TYPE_OID, Id.Bytes, sizeof(Id.Bytes))
+{
+}
+
+
+FBsonVariant::FBsonVariant(const FBsonObject& Object)
+	: FBsonVariant(EBson::Object, BSON_TYPE_DOCUMENT, Object.GetDataPointer(), Object.GetDataLength())
+{
+}
+
+
+FBsonVariant::FBsonVariant(TArrayView<const FBsonVariant> Elements)
+	: FBsonVariant(EBson::Array, BSON_TYPE_ARRAY, nullptr, 0)
+{
+	bson_t Array;
+	bson_init(&Array);
+	for (int32 Index = 0; Index < Elements.Num(); Index++)
+	{
+		FBsonArrayIndexKey IndexKey(Index);
+		FBsonObject::LibbsonImpl::AppendVariant(&Array, IndexKey.Key, IndexKey.Length, Elements[Index]);
+	}
+
+	SetBytes(bson_get_data(&Array), Array.len);
+	bson_destroy(&Array);
+}
+
+
+FBsonVariant::FBsonVariant(const FBsonVariant& Other)
+	: Type(Other.Type), BsonType(Other.BsonType), Subtype(Other.Subtype), bOnHeap(false), InlineLength(0)
+{
+	SetBytes(Other.GetBytes(), Other.GetLength());
+}
+
+
+FBsonVariant::FBsonVariant(FBsonVariant&& Other)
+	: Type(Other.Type), BsonType(Other.BsonType), Subtype(Other.Subtype), bOnHeap(Other.bOnHeap), InlineLength(Other.InlineLength)
+{
+	FMemory::Memcpy(Inline, Other.Inline, sizeof(Inline));
+	Other.bOnHeap = false;
+	Other.Type = EBson::None;
+}
+
+
+FBsonVariant& FBsonVariant::operator=(const FBsonVariant& Other)
+{
+	if (this != &Other)
+	{
+		*this = FBsonVariant(Other);
+	}
+	return *this;
+}
+
+
+FBsonVariant& FBsonVariant::operator=(FBsonVariant&& Other)
+{
+	if (this != &Other)
+	{
+		FreeHeap();
+		Type = Other.Type;
+		BsonType = Other.BsonType;
+		Subtype = Other.Subtype;
+		bOnHeap = Other.bOnHeap;
+		InlineLength = Other.InlineLength;
+		FMemory::Memcpy(Inline, Other.Inline, sizeof(Inline));
+		Other.bOnHeap = false;
+		Other.Type = EBson::None;
+	}
+	return *this;
+}
+
+
+FBsonVariant FBsonVariant::Null()
+{
+	return FBsonVariant(EBson::Null, BSON_TYPE_NULL, nullptr, 0);
+}
+
+
+FBsonVariant FBsonVariant::FromUtf8(TArrayView<const ANSICHAR> Utf8)
+{
+	return FBsonVariant(EBson::String, BSON_TYPE_UTF8, Utf8.GetData(), Utf8.Num());
+}
+
+
+FBsonVariant FBsonVariant::FromBinary(TArrayView<const uint8> Binary, uint8 Subtype)
+{
+	return FBsonVariant(EBson::Binary, BSON_TYPE_BINARY, Binary.GetData(), Binary.Num(), Subtype);
+}
+
+
+FBsonVariant FBsonVariant::FromDecimal128(uint64 Low, uint64 High)
+{
+	uint64 Words[2] = { BSON_UINT64_TO_LE(Low), BSON_UINT64_TO_LE(High) };
+	return FBsonVariant(EBson::Decimal128, BSON_TYPE_DECIMAL128, Words, sizeof(Words));
+}
+
+
+FBsonVariant FBsonVariant::FromView(const FBsonValueView& View)
+{
+	if (!View.IsValid())
+	{
+		return FBsonVariant();
+	}
+	return FBsonVariant(View.Type, View.BsonType, View.Data, View.Length, View.Subtype);
+}
+
+
+bool FBsonVariant::TryGetString(FString& OutString) const
+{
+	if (BsonType == BSON_TYPE_DECIMAL128)
+	{
+		uint64 Low;
+		uint64 High;
+		TryGetDecimal128(Low, High);
+
+		bson_decimal128_t Decimal;
+		Decimal.low = Low;
+		Decimal.high = High;
+		char String[BSON_DECIMAL128_STRING];
+		bson_decimal128_to_string(&Decimal, String);
+		OutString = UTF8_TO_TCHAR(String);
+		return true;
+	}
+
+	TArrayView<const ANSICHAR> Utf8;
+	if (!TryGetUtf8(Utf8))
+	{
+		return false;
+	}
+
+	FUTF8ToTCHAR Converted(Utf8.GetData(), Utf8.Num());
+	OutString = FString(Converted.Length(), Converted.Get());
+	return true;
+}
+
+
+bool FBsonVariant::TryGetDateTime(FDateTime& OutDateTime) const
+{
+	int64 Milliseconds;
+	if (BsonType != BSON_TYPE_DATE_TIME || !TryGetNumber(Milliseconds))
+	{
+		return false;
+	}
+
+	OutDateTime = FBsonValueDateTime::FromUnixMilliseconds(Milliseconds);
+	return true;
+}
+
+
+bool FBsonVariant::TryGetObjectId(FBsonObjectId& OutId) const
+{
+	if (BsonType != BSON_TYPE_OID)
+	{
+		return false;
+	}
+
+	OutId = FBsonObjectId(GetBytes());
+	return true;
+}
+
+
+bool FBsonVariant::TryGetDecimal128(uint64& OutLow, uint64& OutHigh) const
+{
+	if (BsonType != BSON_TYPE_DECIMAL128)
+	{
+		return false;
+	}
+
+	uint64 Words[2];
+	FMemory::Memcpy(Words, GetBytes(), sizeof(Words));
+	OutLow = BSON_UINT64_FROM_LE(Words[0]);
+	OutHigh = BSON_UINT64_FROM_LE(Words[1]);
+	return true;
+}
+
+
+bool FBsonVariant::TryGetObject(FBsonObject& OutObject) const
+{
+	if (BsonType != BSON_TYPE_DOCUMENT)
+	{
+		return false;
+	}
+
+	OutObject = FBsonObject(GetBytes(), GetLength());
+	return true;
+}
+
+
+bool FBsonVariant::TryGetArray(TArray<FBsonVariant>& OutArray) const
+{
+	return TryGetArray(GetView(), OutArray);
+}
+
+
+bool FBsonVariant::TryGetArray(const FBsonValueView& View, TArray<FBsonVariant>& OutArray)
+{
+	OutArray.Reset();
+
+	bson_t Array;
+	bson_iter_t iter;
+	if (View.BsonType != BSON_TYPE_ARRAY || !bson_init_static(&Array, View.Data, View.Length) || !bson_iter_init(&iter, &Array))
+	{
+		return false;
+	}
+
+	FBsonObject::LibbsonImpl::VariantsFromIter(&iter, OutArray);
+	return true;
+}
+
+
+void FBsonVariant::SetBytes(const void* Bytes, uint32 Length)
+{
+	FreeHeap();
+
+	if (Length <= InlineCapacity)
+	{
+		InlineLength = (uint8)Length;
+		if (Length)
+		{
+			FMemory::Memcpy(Inline, Bytes, Length);
+		}
+		return;
+	}
+
+	Heap.Data = (uint8*)FMemory::Malloc(Length);
+	Heap.Length = Length;
+	FMemory::Memcpy(Heap.Data, Bytes, Length);
+	bOnHeap = true;
+}
+
+
+void FBsonVariant::FreeHeap()
+{
+	if (bOnHeap)
+	{
+		FMemory::Free(Heap.Data);
+		bOnHeap = false;
+	}
+}
@@ -0,0 +1,404 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BsonWriter.h"
+#include "BsonObjectImpl.h"
+
+
+struct FBsonWriter::FFrame {
+
+	/** The open object or array, its bytes live inside the buffer of the enclosing document. */
+	bson_t Doc;
+
+	bool bArray;
+
+	/** The index used as key for the next element if this is an array. */
+	uint32 NextIndex;
+
+	/** Begin calls inside this frame that failed to open their object or array and are still waiting for their End. */
+	uint32 FailedBegins;
+};
+
+
+FBsonWriter::FBsonWriter(FBsonObject& InObject) : Object(InObject), Depth(0), RootFailedBegins(0)
+{
+}
+
+
+FBsonWriter::~FBsonWriter()
+{
+	if (Depth > 0)
+	{
+		UE_LOG(LogBson, Warning, TEXT("FBsonWriter destroyed with %d objects or arrays still open, closing them."), Depth);
+		while (Depth > 0)
+		{
+			PopFrame(Frames[Depth - 1]->bArray);
+		}
+	}
+
+	for (FFrame* Frame : Frames)
+	{
+		delete Frame;
+	}
+}
+
+
+bool FBsonWriter::IsInArray() const
+{
+	return Depth > 0 && Frames[Depth - 1]->bArray;
+}
+
+
+bson_t* FBsonWriter::GetTarget()
+{
+	if (Depth > 0)
+	{
+		return &Frames[Depth - 1]->Doc;
+	}
+
+	Object.WriteImpl().PrepareWrite();
+	return Object.WriteImpl().bsonDoc;
+}
+
+
+bool FBsonWriter::NextArrayIndex(uint32& OutIndex)
+{
+	if (!IsInArray())
+	{
+		UE_LOG(LogBson, Error, TEXT("FBsonWriter: value without a key written outside of an array."));
+		return false;
+	}
+
+	OutIndex = Frames[Depth - 1]->NextIndex++;
+	return true;
+}
+
+
+FBsonWriter::FFrame& FBsonWriter::GetNextFrame()
+{
+	if (Depth == Frames.Num())
+	{
+		Frames.Add(new FFrame);
+	}
+	return *Frames[Depth];
+}
+
+
+void FBsonWriter::PushFrame(bool bArray, bool bOpened)
+{
+	if (!bOpened)
+	{
+		UE_LOG(LogBson, Error, TEXT("FBsonWriter: %s failed, nothing is opened until the matching %s."),
+			bArray ? TEXT("BeginArray") : TEXT("BeginObject"), bArray ? TEXT("EndArray") : TEXT("EndObject"));
+		GetFailedBegins()++;
+		return;
+	}
+
+	FFrame& Frame = *Frames[Depth++];
+	Frame.bArray = bArray;
+	Frame.NextIndex = 0;
+	Frame.FailedBegins = 0;
+}
+
+
+uint32& FBsonWriter::GetFailedBegins()
+{
+	return Depth > 0 ? Frames[Depth - 1]->FailedBegins : RootFailedBegins;
+}
+
+
+void FBsonWriter::PopFrame(bool bArray)
+{
+	uint32& FailedBegins = GetFailedBegins();
+	if (FailedBegins > 0)
+	{
+		UE_LOG(LogBson, Warning, TEXT("FBsonWriter: %s ignored, its %s failed."),
+			bArray ? TEXT("EndArray") : TEXT("EndObject"), bArray ? TEXT("BeginArray") : TEXT("BeginObject"));
+		FailedBegins--;
+		return;
+	}
+
+	if (Depth == 0 || Frames[Depth - 1]->bArray != bArray)
+	{
+		UE_LOG(LogBson, Error, TEXT("FBsonWriter: %s called without a matching %s."),
+			bArray ? TEXT("EndArray") : TEXT("EndObject"), bArray ? TEXT("BeginArray") : TEXT("BeginObject"));
+		return;
+	}
+
+	FFrame& Frame = *Frames[--Depth];
+	bson_t* Parent = Depth > 0 ? &Frames[Depth - 1]->Doc : Object.WriteImpl().bsonDoc;
+	if (bArray)
+	{
+		bson_append_array_end(Parent, &Frame.Doc);
+	}
+	else
+	{
+		bson_append_document_end(Parent, &Frame.Doc);
+	}
+}
+
+
+void FBsonWriter::BeginObject(const FBsonKey& Key)
+{
+	bson_t* Parent = GetTarget();
+	PushFrame(false, bson_append_document_begin(Parent, Key.GetUtf8(), Key.Len(), &GetNextFrame().Doc));
+}
+
+
+void FBsonWriter::BeginObject(const FString& FieldName)
+{
+	BeginObject(FTransientBsonKey(FieldName));
+}
+
+
+void FBsonWriter::BeginObject()
+{
+	uint32 Index;
+	if (NextArrayIndex(Index))
+	{
+		BeginObject(FBsonArrayIndexKey(Index).ToKey());
+	}
+	else
+	{
+		PushFrame(false, false);
+	}
+}
+
+
+void FBsonWriter::EndObject()
+{
+	PopFrame(false);
+}
+
+
+void FBsonWriter::BeginArray(const FBsonKey& Key)
+{
+	bson_t* Parent = GetTarget();
+	PushFrame(true, bson_append_array_begin(Parent, Key.GetUtf8(), Key.Len(), &GetNextFrame().Doc));
+}
+
+
+void FBsonWriter::BeginArray(const FString& FieldName)
+{
+	BeginArray(FTransientBsonKey(FieldName));
+}
+
+
+void FBsonWriter::BeginArray()
+{
+	uint32 Index;
+	if (NextArrayIndex(Index))
+	{
+		BeginArray(FBsonArrayIndexKey(Index).ToKey());
+	}
+	else
+	{
+		PushFrame(true, false);
+	}
+}
+
+
+void FBsonWriter::EndArray()
+{
+	PopFrame(true);
+}
+
+
+void FBsonWriter::WriteNumber(const FBsonKey& Key, double Number)
+{
+	bson_append_double(GetTarget(), Key.GetUtf8(), Key.Len(), Number);
+}
+
+
+void FBsonWriter::WriteNumber(const FString& FieldName, double Number)
+{
+	WriteNumber(FTransientBsonKey(FieldName), Number);
+}
+
+
+void FBsonWriter::WriteNumber(double Number)
+{
+	uint32 Index;
+	if (NextArrayIndex(Index))
+	{
+		WriteNumber(FBsonArrayIndexKey(Index).ToKey(), Number);
+	}
+}
+
+
+void FBsonWriter::WriteInt32(const FBsonKey& Key, int32 Number)
+{
+	bson_append_int32(GetTarget(), Key.GetUtf8(), Key.Len(), Number);
+}
+
+
+void FBsonWriter::WriteInt32(const FString& FieldName, int32 Number)
+{
+	WriteInt32(FTransientBsonKey(FieldName), Number);
+}
+
+
+void FBsonWriter::WriteInt32(int32 Number)
+{
+	uint32 Index;
+	if (NextArrayIndex(Index))
+	{
+		WriteInt32(FBsonArrayIndexKey(Index).ToKey(), Number);
+	}
+}
+
+
+void FBsonWriter::WriteInt64(const FBsonKey& Key, int64 Number)
+{
+	bson_append_int64(GetTarget(), Key.GetUtf8(), Key.Len(), Number);
+}
+
+
+void FBsonWriter::WriteInt64(const FString& FieldName, int64 Number)
+{
+	WriteInt64(FTransientBsonKey(FieldName), Number);
+}
+
+
+void FBsonWriter::WriteInt64(int64 Number)
+{
+	uint32 Index;
+	if (NextArrayIndex(Index))
+	{
+		WriteInt64(FBsonArrayIndexKey(Index).ToKey(), Number);
+	}
+}
+
+
+void FBsonWriter::WriteDateTime(const FBsonKey& Key, const FDateTime& DateTime)
+{
+	bson_append_date_time(GetTarget(), Key.GetUtf8(), Key.Len(), FBsonValueDateTime::ToUnixMilliseconds(DateTime));
+}
+
+
+void FBsonWriter::WriteDateTime(const FString& FieldName, const FDateTime& DateTime)
+{
+	WriteDateTime(FTransientBsonKey(FieldName), DateTime);
+}
+
+
+void FBsonWriter::WriteDateTime(const FDateTime& DateTime)
+{
+	uint32 Index;
+	if (NextArrayIndex(Index))
+	{
+		WriteDateTime(FBsonArrayIndexKey(Index).ToKey(), DateTime);
+	}
+}
+
+
+void FBsonWriter::WriteObjectId(const FBsonKey& Key, const FBsonObjectId& Id)
+{
+	bson_oid_t oid;
+	FMemory::Memcpy(oid.bytes, Id.Bytes, sizeof(oid.bytes));
+	bson_append_oid(GetTarget(), Key.GetUtf8(), Key.Len(), &oid);
+}
+
+
+void FBsonWriter::WriteObjectId(const FString& FieldName, const FBsonObjectId& Id)
+{
+	WriteObjectId(FTransientBsonKey(FieldName), Id);
+}
+
+
+void FBsonWriter::WriteObjectId(const FBsonObjectId& Id)
+{
+	uint32 Index;
+	if (NextArrayIndex(Index))
+	{
+		WriteObjectId(FBsonArrayIndexKey(Index).ToKey(), Id);
+	}
+}
+
+
+void FBsonWriter::WriteBool(const FBsonKey& Key, bool Bool)
+{
+	bson_append_bool(GetTarget(), Key.GetUtf8(), Key.Len(), Bool);
+}
+
+
+void FBsonWriter::WriteBool(const FString& FieldName, bool Bool)
+{
+	WriteBool(FTransientBsonKey(FieldName), Bool);
+}
+
+
+void FBsonWriter::WriteBool(bool Bool)
+{
+	uint32 Index;
+	if (NextArrayIndex(Index))
+	{
+		WriteBool(FBsonArrayIndexKey(Index).ToKey(), Bool);
+	}
+}
+
+
+void FBsonWriter::WriteString(const FBsonKey& Key, const FString& StringValue)
+{
+	FTCHARToUTF8 Utf8Value(*StringValue);
+	bson_append_utf8(GetTarget(), Key.GetUtf8(), Key.Len(), Utf8Value.Get(), Utf8Value.Length());
+}
+
+
+void FBsonWriter::WriteString(const FString& FieldName, const FString& StringValue)
+{
+	WriteString(FTransientBsonKey(FieldName), StringValue);
+}
+
+
+void FBsonWriter::WriteString(const FString& StringValue)
+{
+	uint32 Index;
+	if (NextArrayIndex(Index))
+	{
+		WriteString(FBsonArrayIndexKey(Index).ToKey(), StringValue);
+	}
+}
+
+
+void FBsonWriter::WriteNull(const FBsonKey& Key)
+{
+	bson_append_null(GetTarget(), Key.GetUtf8(), Key.Len());
+}
+
+
+void FBsonWriter::WriteNull(const FString& FieldName)
+{
+	WriteNull(FTransientBsonKey(FieldName));
+}
+
+
+void FBsonWriter::WriteNull()
+{
+	uint32 Index;
+	if (NextArrayIndex(Index))
+	{
+		WriteNull(FBsonArrayIndexKey(Index).ToKey());
+	}
+}
+
+
+void FBsonWriter::WriteObject(const FBsonKey& Key, const FBsonObject& InObject)
+{
+	bson_append_document(GetTarget(), Key.GetUtf8(), Key.Len(), InObject.ReadImpl().bsonDoc);
+}
+
+
+void FBsonWriter::WriteObject(const FString& FieldName, const FBsonObject& InObject)
+{
+	WriteObject(FTransientBsonKey(FieldName), InObject);
+}
+
+
+void FBsonWriter::WriteObject(const FBsonObject& InObject)
+{
+	uint32 Index;
+	if (NextArrayIndex(Index))
+	{
+		WriteObject(FBsonArrayIndexKey(Index).ToKey(), InObject);
+	}
+}
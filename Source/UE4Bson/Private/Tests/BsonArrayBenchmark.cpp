@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "BsonObject.h"
+#include "BsonValue.h"
+#include <bson.h>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+* Appends numeric arrays of 10k to 1M elements: with keys formatted through FString::FromInt and
+* TCHAR_TO_UTF8, as before the precomputed index keys, and through SetNumberArrayField() and through
+* SetArrayField() with FBsonValues, which both use the precomputed keys.
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBsonArrayBenchmark, "Bson.Benchmark.ArrayKeys",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FBsonArrayBenchmark::RunTest(const FString& Parameters)
+{
+	const int32 ElementCounts[] = { 10000, 100000, 1000000 };
+
+	AddInfo(TEXT("Elements  FString keys ns/element  SetNumberArrayField ns/element  SetArrayField ns/element"));
+
+	for (int32 NumElements : ElementCounts)
+	{
+		TArray<double> Numbers;
+		TArray<TSharedPtr<FBsonValue>> Values;
+		Numbers.Reserve(NumElements);
+		Values.Reserve(NumElements);
+		for (int32 Index = 0; Index < NumElements; Index++)
+		{
+			Numbers.Add(Index * 0.25);
+			Values.Add(MakeShareable(new FBsonValueNumber(Index * 0.25)));
+		}
+
+		double StartTime = FPlatformTime::Seconds();
+		bson_t* Document = bson_new();
+		bson_t Child;
+		bson_append_array_begin(Document, "Numbers", -1, &Child);
+		for (int32 Index = 0; Index < NumElements; Index++)
+		{
+			bson_append_double(&Child, TCHAR_TO_UTF8(*FString::FromInt(Index)), -1, Numbers[Index]);
+		}
+		bson_append_array_end(Document, &Child);
+		const uint32 FormattedLength = Document->len;
+		bson_destroy(Document);
+		const double FormattedSeconds = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		uint32 NumberArrayLength;
+		{
+			FBsonObject Object;
+			Object.SetNumberArrayField(TEXT("Numbers"), TArrayView<const double>(Numbers));
+			NumberArrayLength = (uint32)Object.GetDataLength();
+		}
+		const double NumberArraySeconds = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		uint32 ValueArrayLength;
+		{
+			FBsonObject Object;
+			Object.SetArrayField(TEXT("Numbers"), Values);
+			ValueArrayLength = (uint32)Object.GetDataLength();
+		}
+		const double ValueArraySeconds = FPlatformTime::Seconds() - StartTime;
+
+		AddInfo(FString::Printf(TEXT("%8d  %23.1f  %30.1f  %24.1f"), NumElements,
+			FormattedSeconds * 1e9 / NumElements, NumberArraySeconds * 1e9 / NumElements, ValueArraySeconds * 1e9 / NumElements));
+		TestEqual(TEXT("Both keys produce the same document"), FormattedLength, NumberArrayLength);
+		TestEqual(TEXT("Both keys produce the same document"), FormattedLength, ValueArrayLength);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "BsonObject.h"
+#include "BsonFileWriter.h"
+#include "BsonCompressedFileReader.h"
+#include "BsonCompressedFormat.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Reads all documents, checking that their "index" fields count up from FirstIndex. */
+	int32 ReadAllDocuments(FAutomationTestBase& Test, FBsonCompressedFileReader& Reader, int32 FirstIndex = 0)
+	{
+		FBsonObject Document;
+		int32 Count = 0;
+		while (Reader.Next(Document))
+		{
+			int32 Index = -1;
+			Document.TryGetNumberField(TEXT("index"), Index);
+			Test.TestEqual(TEXT("Next returns the documents in order"), Index, FirstIndex + Count);
+			Count++;
+		}
+		return Count;
+	}
+}
+
+/**
+* Writes a block-compressed file with a document larger than the writer's buffers and reads it back through
+* its block index, and through its block headers once the index is corrupt.
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBsonCompressedFileTest, "Bson.CompressedFile",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBsonCompressedFileTest::RunTest(const FString& Parameters)
+{
+	const FString Filename = FPaths::AutomationTransientDir() + TEXT("BsonCompressedFileTest.bsonz");
+	const int32 NumDocuments = 2000;
+
+	FBsonFileWriterSettings Settings;
+	Settings.BufferSize = 16 * 1024;
+	Settings.CompressionFormat = NAME_Zlib;
+	FBsonFileStats WriterStats;
+	{
+		FBsonFileWriter Writer(Filename, Settings);
+		for (int32 Index = 0; Index < NumDocuments; Index++)
+		{
+			FBsonObject Document;
+			Document.SetInt32Field(TEXT("index"), Index);
+			Document.SetStringField(TEXT("state"), Index % 3 ? TEXT("running") : TEXT("idle"));
+			if (Index == 1000)
+			{
+				// larger than a buffer, written as a block of its own
+				Document.SetStringField(TEXT("padding"), FString::ChrN((int32)Settings.BufferSize, TEXT('x')));
+			}
+			Writer.Write(Document);
+		}
+		Writer.Close();
+		WriterStats = Writer.GetStats();
+		TestTrue(TEXT("The file header and block index are written besides the blocks"), Writer.GetWrittenBytes() > WriterStats.FileBytes);
+	}
+
+	{
+		FBsonCompressedFileReader Reader(Filename);
+		TestTrue(TEXT("The reader opens the file"), Reader.IsOpen());
+		TestTrue(TEXT("The file has several blocks"), Reader.GetNumBlocks() > 1);
+		TestEqual(TEXT("GetNumDocuments"), Reader.GetNumDocuments(), (int64)NumDocuments);
+		TestEqual(TEXT("Next returns every document"), ReadAllDocuments(*this, Reader), NumDocuments);
+
+		const FBsonFileStats ReaderStats = Reader.GetStats();
+		TestEqual(TEXT("Writer and reader count the same file bytes"), ReaderStats.FileBytes, WriterStats.FileBytes);
+		TestEqual(TEXT("Writer and reader count the same document bytes"), ReaderStats.UncompressedBytes, WriterStats.UncompressedBytes);
+		TestTrue(TEXT("The documents compress"), ReaderStats.GetCompressionRatio() > 1.0);
+
+		TestTrue(TEXT("SeekToDocument"), Reader.SeekToDocument(1234));
+		TestEqual(TEXT("Next continues at the sought document"), ReadAllDocuments(*this, Reader, 1234), NumDocuments - 1234);
+	}
+
+	// an index entry claiming a block of several documents larger than the writer's buffers is rejected,
+	// the block headers are walked instead
+	TArray<uint8> Bytes;
+	FFileHelper::LoadFileToArray(Bytes, *Filename);
+	FBsonCompressedFileFooter Footer;
+	FMemory::Memcpy(&Footer, Bytes.GetData() + Bytes.Num() - sizeof(Footer), sizeof(Footer));
+	FBsonCompressedBlock FirstBlock;
+	FMemory::Memcpy(&FirstBlock, Bytes.GetData() + Footer.IndexOffset, sizeof(FirstBlock));
+	FirstBlock.UncompressedSize = Settings.BufferSize + 1;
+	FMemory::Memcpy(Bytes.GetData() + Footer.IndexOffset, &FirstBlock, sizeof(FirstBlock));
+	FFileHelper::SaveArrayToFile(Bytes, *Filename);
+	{
+		FBsonCompressedFileReader Reader(Filename);
+		TestEqual(TEXT("The blocks are found without the index"), Reader.GetNumDocuments(), (int64)NumDocuments);
+		TestEqual(TEXT("Next returns every document without the index"), ReadAllDocuments(*this, Reader), NumDocuments);
+	}
+
+	IFileManager::Get().Delete(*Filename);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
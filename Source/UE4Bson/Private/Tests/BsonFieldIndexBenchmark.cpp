@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "BsonObject.h"
+#include "BsonKey.h"
+#include <bson.h>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+* Compares field lookups through FBsonObject (linear scan, then the lazily built field index) with a plain
+* libbson scan for every lookup, for documents of different sizes read a different number of times.
+* The crossover is where FBsonObject gets faster than the scan, see LibbsonImpl::FieldIndexLookupThreshold.
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBsonFieldIndexBenchmark, "Bson.Benchmark.FieldIndex",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FBsonFieldIndexBenchmark::RunTest(const FString& Parameters)
+{
+	const int32 FieldCounts[] = { 8, 32, 64, 128, 256 };
+	const int32 LookupCounts[] = { 1, 2, 4, 16, 64 };
+	const int32 LookupsPerRun = 200000;
+
+	AddInfo(TEXT("Fields  Lookups/Doc  Scan ns/lookup  FBsonObject ns/lookup"));
+
+	for (int32 NumFields : FieldCounts)
+	{
+		FBsonObject Object;
+		TArray<FBsonKey> Keys;
+		for (int32 Field = 0; Field < NumFields; Field++)
+		{
+			Keys.Add(FBsonKey(FString::Printf(TEXT("field_%d"), Field)));
+			Object.SetNumberField(Keys.Last(), (double)Field);
+		}
+		const uint8* Data = Object.GetDataPointer();
+		const uint32 Length = (uint32)Object.GetDataLength();
+
+		for (int32 NumLookups : LookupCounts)
+		{
+			const int32 NumDocuments = FMath::Max(LookupsPerRun / NumLookups, 1);
+			int32 Found = 0;
+
+			// a fresh object per document, so every document starts without an index
+			double StartTime = FPlatformTime::Seconds();
+			for (int32 Document = 0; Document < NumDocuments; Document++)
+			{
+				FBsonObject Borrowed = FBsonObject::Borrow(Data, Length);
+				bson_t Doc;
+				bson_iter_t Iter;
+				bson_init_static(&Doc, Borrowed.GetDataPointer(), Borrowed.GetDataLength());
+				for (int32 Lookup = 0; Lookup < NumLookups; Lookup++)
+				{
+					// interned keys are zero terminated
+					const FBsonKey& Key = Keys[(Document + Lookup * 7) % NumFields];
+					Found += bson_iter_init_find(&Iter, &Doc, Key.GetUtf8()) ? 1 : 0;
+				}
+			}
+			const double ScanSeconds = FPlatformTime::Seconds() - StartTime;
+
+			StartTime = FPlatformTime::Seconds();
+			for (int32 Document = 0; Document < NumDocuments; Document++)
+			{
+				FBsonObject Borrowed = FBsonObject::Borrow(Data, Length);
+				for (int32 Lookup = 0; Lookup < NumLookups; Lookup++)
+				{
+					Found += Borrowed.HasField(Keys[(Document + Lookup * 7) % NumFields]) ? 1 : 0;
+				}
+			}
+			const double ObjectSeconds = FPlatformTime::Seconds() - StartTime;
+
+			const double Lookups = (double)NumDocuments * NumLookups;
+			AddInfo(FString::Printf(TEXT("%6d  %11d  %14.1f  %21.1f"), NumFields, NumLookups,
+				ScanSeconds * 1e9 / Lookups, ObjectSeconds * 1e9 / Lookups));
+			TestEqual(TEXT("Every field was found"), Found, NumDocuments * NumLookups * 2);
+		}
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "BsonObject.h"
+#include "BsonFileIndex.h"
+#include "BsonFileReader.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Appends documents with a "time" field of Index * 10 to a dump. */
+	void AppendDocuments(TArray<uint8>& Dump, int32 FirstIndex, int32 NumDocuments, const FString& Name)
+	{
+		for (int32 Index = FirstIndex; Index < FirstIndex + NumDocuments; Index++)
+		{
+			FBsonObject Document;
+			Document.SetStringField(TEXT("name"), Name);
+			Document.SetInt64Field(TEXT("time"), Index * 10);
+			Dump.Append(Document.GetDataPointer(), (int32)Document.GetDataLength());
+		}
+	}
+}
+
+/**
+* Builds a timestamp index, extends it as the dump grows, rebuilds it for a replaced dump and seeks through it.
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBsonFileIndexTest, "Bson.FileIndex",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBsonFileIndexTest::RunTest(const FString& Parameters)
+{
+	const FString DumpFilename = FPaths::AutomationTransientDir() + TEXT("BsonFileIndexTest.bson");
+	const FString IndexFilename = FBsonFileIndex::GetIndexFilename(DumpFilename);
+	IFileManager::Get().Delete(*IndexFilename);
+
+	TArray<uint8> Dump;
+	AppendDocuments(Dump, 0, 100, TEXT("first"));
+	FFileHelper::SaveArrayToFile(Dump, *DumpFilename);
+	TestEqual(TEXT("Update indexes every document"), FBsonFileIndex::Update(DumpFilename, IndexFilename, TEXT("time")), (int64)100);
+	TestEqual(TEXT("Update of an unchanged dump adds nothing"), FBsonFileIndex::Update(DumpFilename, IndexFilename, TEXT("time")), (int64)0);
+
+	// a growing dump with a partially written document at its end
+	AppendDocuments(Dump, 100, 50, TEXT("first"));
+	FFileHelper::SaveArrayToFile(TArrayView<const uint8>(Dump.GetData(), Dump.Num() - 3), *DumpFilename);
+	TestEqual(TEXT("Update skips the partial document"), FBsonFileIndex::Update(DumpFilename, IndexFilename, TEXT("time")), (int64)49);
+	FFileHelper::SaveArrayToFile(Dump, *DumpFilename);
+	TestEqual(TEXT("The next Update adds it"), FBsonFileIndex::Update(DumpFilename, IndexFilename, TEXT("time")), (int64)1);
+
+	FBsonFileIndex Index;
+	TestTrue(TEXT("Load"), Index.Load(IndexFilename));
+	TestEqual(TEXT("The index holds every document"), Index.Num(), 150);
+	TestTrue(TEXT("The index has timestamps"), Index.HasTimestamps());
+	TestEqual(TEXT("FindTimestamp"), Index.FindTimestamp(1234), 124);
+	TestEqual(TEXT("FindTimestamp past the end"), Index.FindTimestamp(10000), (int32)INDEX_NONE);
+
+	{
+		FBsonFileReader Reader(DumpFilename);
+		TestTrue(TEXT("LoadIndex"), Reader.LoadIndex());
+		FBsonObject Document;
+		int64 Time = 0;
+		TestTrue(TEXT("SeekToDocument"), Reader.SeekToDocument(120) && Reader.Next(Document) && Document.TryGetNumberField(TEXT("time"), Time));
+		TestEqual(TEXT("SeekToDocument finds the document"), Time, (int64)1200);
+		TestTrue(TEXT("SeekToTimestamp"), Reader.SeekToTimestamp(555) && Reader.Next(Document) && Document.TryGetNumberField(TEXT("time"), Time));
+		TestEqual(TEXT("SeekToTimestamp finds the next document"), Time, (int64)560);
+	}
+
+	// a new dump with documents of a different length replaces the old one
+	Dump.Reset();
+	AppendDocuments(Dump, 0, 20, TEXT("replacement"));
+	FFileHelper::SaveArrayToFile(Dump, *DumpFilename);
+	TestEqual(TEXT("The index of a replaced dump is rebuilt"), FBsonFileIndex::Update(DumpFilename, IndexFilename, TEXT("time")), (int64)20);
+	TestTrue(TEXT("Load"), Index.Load(IndexFilename));
+	TestEqual(TEXT("The rebuilt index only holds the new documents"), Index.Num(), 20);
+
+	IFileManager::Get().Delete(*DumpFilename);
+	IFileManager::Get().Delete(*IndexFilename);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
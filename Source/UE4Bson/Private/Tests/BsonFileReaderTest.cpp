@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "BsonObject.h"
+#include "BsonFileReader.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+* Reads a dump sequentially, by offset and in chunks, and stops at a truncated document.
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBsonFileReaderTest, "Bson.FileReader",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBsonFileReaderTest::RunTest(const FString& Parameters)
+{
+	const FString Filename = FPaths::AutomationTransientDir() + TEXT("BsonFileReaderTest.bson");
+	const int32 NumDocuments = 50;
+
+	TArray<uint8> Dump;
+	TArray<int64> Offsets;
+	for (int32 Index = 0; Index < NumDocuments; Index++)
+	{
+		FBsonObject Document;
+		Document.SetInt32Field(TEXT("index"), Index);
+		Document.SetStringField(TEXT("name"), FString::ChrN(Index, TEXT('n')));
+		Offsets.Add(Dump.Num());
+		Dump.Append(Document.GetDataPointer(), (int32)Document.GetDataLength());
+	}
+	TestTrue(TEXT("The dump can be saved"), FFileHelper::SaveArrayToFile(Dump, *Filename));
+
+	{
+		FBsonFileReader Reader(Filename);
+		TestTrue(TEXT("The reader maps the file"), Reader.IsOpen());
+		TestEqual(TEXT("GetFileSize"), Reader.GetFileSize(), (int64)Dump.Num());
+
+		FBsonObject Document;
+		int32 Count = 0;
+		while (Reader.Next(Document))
+		{
+			int32 Index = -1;
+			Document.TryGetNumberField(TEXT("index"), Index);
+			TestEqual(TEXT("Next returns the documents in order"), Index, Count);
+			Count++;
+		}
+		TestEqual(TEXT("Next returns every document"), Count, NumDocuments);
+		TestFalse(TEXT("A complete dump has no error"), Reader.HasError());
+
+		Reader.Seek(Offsets[30]);
+		int32 Index = -1;
+		TestTrue(TEXT("Next after Seek"), Reader.Next(Document) && Document.TryGetNumberField(TEXT("index"), Index));
+		TestEqual(TEXT("Seek continues at the given document"), Index, 30);
+
+		TArrayView<const uint8> Bytes;
+		TestTrue(TEXT("ReadDocumentAt"), Reader.ReadDocumentAt(Offsets[7], Bytes));
+		TestEqual(TEXT("ReadDocumentAt returns the whole document"), (int64)Bytes.Num(), Offsets[8] - Offsets[7]);
+		TestFalse(TEXT("ReadDocumentAt rejects an offset inside a document"), Reader.ReadDocumentAt(Offsets[7] + 1, Bytes));
+
+		int32 ChunkedCount = 0;
+		for (const FBsonFileChunk& Chunk : Reader.SplitIntoChunks(4))
+		{
+			TestTrue(TEXT("ForEachDocument"), Reader.ForEachDocument(Chunk, [&ChunkedCount](const FBsonObject&) { ChunkedCount++; }));
+		}
+		TestEqual(TEXT("The chunks cover every document"), ChunkedCount, NumDocuments);
+	}
+
+	// cut the last document in half
+	Dump.SetNum(Dump.Num() - 10);
+	TestTrue(TEXT("The truncated dump can be saved"), FFileHelper::SaveArrayToFile(Dump, *Filename));
+	{
+		FBsonFileReader Reader(Filename);
+		FBsonObject Document;
+		int32 Count = 0;
+		while (Reader.Next(Document))
+		{
+			Count++;
+		}
+		TestEqual(TEXT("Reading stops before the truncated document"), Count, NumDocuments - 1);
+		TestTrue(TEXT("A truncated dump has an error"), Reader.HasError());
+	}
+
+	IFileManager::Get().Delete(*Filename);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
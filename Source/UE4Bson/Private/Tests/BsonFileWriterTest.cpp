@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "BsonObject.h"
+#include "BsonFileWriter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+* Writes documents through small buffers, copied and handed over, checks that a partial buffer reaches the
+* file within the flush interval without another Write(), and reads the dump back in order.
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBsonFileWriterTest, "Bson.FileWriter",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBsonFileWriterTest::RunTest(const FString& Parameters)
+{
+	const FString Filename = FPaths::AutomationTransientDir() + TEXT("BsonFileWriterTest.bson");
+	const int32 NumDocuments = 100;
+
+	FBsonFileWriterSettings Settings;
+	Settings.BufferSize = 1024;
+	Settings.FlushIntervalSeconds = 0.05;
+	{
+		FBsonFileWriter Writer(Filename, Settings);
+		TestTrue(TEXT("The writer opens the file"), Writer.IsOpen());
+
+		FBsonObject Object;
+		Object.SetInt32Field(TEXT("index"), 0);
+		Writer.Write(Object);
+
+		// the background thread takes over the partial buffer on its own
+		FPlatformProcess::Sleep(0.5f);
+		TestEqual(TEXT("A partial buffer is written after the flush interval"), Writer.GetStats().Documents, (uint64)1);
+
+		for (int32 Index = 1; Index < NumDocuments; Index++)
+		{
+			FBsonObject Document;
+			Document.SetInt32Field(TEXT("index"), Index);
+			if (Index % 10 == 0)
+			{
+				// larger than half a buffer, handed over without copying
+				Document.SetStringField(TEXT("padding"), FString::ChrN((int32)Settings.BufferSize, TEXT('x')));
+				TestTrue(TEXT("Write(FBsonObject&&) succeeds"), Writer.Write(MoveTemp(Document)));
+				TestEqual(TEXT("Write(FBsonObject&&) leaves the document empty"), (uint32)Document.GetDataLength(), 5u);
+			}
+			else
+			{
+				TestTrue(TEXT("Write succeeds"), Writer.Write(Document));
+			}
+		}
+
+		Writer.Flush();
+		TestEqual(TEXT("Flush writes every document"), Writer.GetStats().Documents, (uint64)NumDocuments);
+		TestEqual(TEXT("No document is dropped"), Writer.GetDroppedDocuments(), (uint64)0);
+	}
+
+	TArray<uint8> Bytes;
+	TestTrue(TEXT("The dump can be loaded"), FFileHelper::LoadFileToArray(Bytes, *Filename));
+
+	int32 Offset = 0;
+	int32 Expected = 0;
+	while (Offset + 4 <= Bytes.Num())
+	{
+		const uint32 Length = Bytes[Offset] | Bytes[Offset + 1] << 8 | Bytes[Offset + 2] << 16 | (uint32)Bytes[Offset + 3] << 24;
+		if (Length < 5 || Length > (uint32)(Bytes.Num() - Offset))
+		{
+			AddError(FString::Printf(TEXT("Invalid document length %u at offset %d"), Length, Offset));
+			break;
+		}
+
+		FBsonObject Document = FBsonObject::Borrow(&Bytes[Offset], Length);
+		int32 Index = -1;
+		Document.TryGetNumberField(TEXT("index"), Index);
+		TestEqual(TEXT("Documents are written in order"), Index, Expected);
+		Expected++;
+		Offset += Length;
+	}
+	TestEqual(TEXT("The dump holds every document"), Expected, NumDocuments);
+
+	IFileManager::Get().Delete(*Filename);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "BsonObject.h"
+#include "BsonKey.h"
+#include "BsonScopedArena.h"
+#include "BsonMemory.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Builds and discards a document of about a kilobyte, like a per-tick state message. */
+	int32 BuildAndDiscardDocument(int32 Seed)
+	{
+		static const FBsonKey Keys[] = {
+			FBsonKey("Id"), FBsonKey("Time"), FBsonKey("Name"), FBsonKey("X"), FBsonKey("Y"), FBsonKey("Z"),
+			FBsonKey("Pitch"), FBsonKey("Yaw"), FBsonKey("Roll"), FBsonKey("Joints")
+		};
+		const int32 NumJoints = 64;
+		double Joints[NumJoints];
+		for (int32 Joint = 0; Joint < NumJoints; Joint++)
+		{
+			Joints[Joint] = Seed * 0.5 + Joint;
+		}
+
+		FBsonObject Object;
+		Object.SetInt32Field(Keys[0], Seed);
+		Object.SetNumberField(Keys[1], Seed * 0.016);
+		Object.SetStringField(Keys[2], TEXT("BP_Character_C_0"));
+		for (int32 Axis = 3; Axis < 9; Axis++)
+		{
+			Object.SetNumberField(Keys[Axis], Seed + Axis);
+		}
+		Object.SetNumberArrayField(Keys[9], TArrayView<const double>(Joints, NumJoints));
+		return (int32)Object.GetDataLength();
+	}
+}
+
+/**
+* Builds and discards documents with libbson allocating through the C runtime's malloc, through FMemory
+* (the default) and from an FBsonScopedArena that is released every DocumentsPerArena documents.
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBsonMemoryBenchmark, "Bson.Benchmark.Memory",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FBsonMemoryBenchmark::RunTest(const FString& Parameters)
+{
+	const int32 NumDocuments = 200000;
+	const int32 DocumentsPerArena = 100;
+	int64 Bytes[3] = {};
+
+	double StartTime = FPlatformTime::Seconds();
+	{
+		FBsonMemory::FScopedSystemMalloc SystemMalloc;
+		for (int32 Document = 0; Document < NumDocuments; Document++)
+		{
+			Bytes[0] += BuildAndDiscardDocument(Document);
+		}
+	}
+	const double MallocSeconds = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Document = 0; Document < NumDocuments; Document++)
+	{
+		Bytes[1] += BuildAndDiscardDocument(Document);
+	}
+	const double FMemorySeconds = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Frame = 0; Frame < NumDocuments / DocumentsPerArena; Frame++)
+	{
+		FBsonScopedArena Arena;
+		for (int32 Document = Frame * DocumentsPerArena; Document < (Frame + 1) * DocumentsPerArena; Document++)
+		{
+			Bytes[2] += BuildAndDiscardDocument(Document);
+		}
+	}
+	const double ArenaSeconds = FPlatformTime::Seconds() - StartTime;
+
+	AddInfo(FString::Printf(TEXT("%d documents of %lld bytes on average, ns per document:"), NumDocuments, Bytes[0] / NumDocuments));
+	AddInfo(FString::Printf(TEXT("malloc   %8.1f"), MallocSeconds * 1e9 / NumDocuments));
+	AddInfo(FString::Printf(TEXT("FMemory  %8.1f"), FMemorySeconds * 1e9 / NumDocuments));
+	AddInfo(FString::Printf(TEXT("Arena    %8.1f (released every %d documents)"), ArenaSeconds * 1e9 / NumDocuments, DocumentsPerArena));
+
+	TestEqual(TEXT("Every allocator builds the same documents"), Bytes[0], Bytes[1]);
+	TestEqual(TEXT("Every allocator builds the same documents"), Bytes[1], Bytes[2]);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
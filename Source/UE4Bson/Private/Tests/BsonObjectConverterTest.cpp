@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "BsonObject.h"
+#include "BsonObjectConverter.h"
+#include "UObject/Class.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+* Converts an FTransform, which nests FQuat and FVector, to Bson and back, before and after the plans are dropped.
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBsonObjectConverterTest, "Bson.ObjectConverter",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBsonObjectConverterTest::RunTest(const FString& Parameters)
+{
+	const FTransform Transform(FRotator(10.f, 20.f, 30.f), FVector(1.f, 2.f, 3.f), FVector(0.5f, 0.5f, 2.f));
+
+	FBsonObject Object;
+	TestTrue(TEXT("UStructToBsonObject succeeds"),
+		FBsonObjectConverter::UStructToBsonObject(TBaseStructure<FTransform>::Get(), &Transform, Object));
+	TestTrue(TEXT("The nested struct is written as an object"), Object.GetObjectField(TEXT("translation")).IsValid());
+
+	FTransform Decoded;
+	TestTrue(TEXT("BsonObjectToUStruct succeeds"),
+		FBsonObjectConverter::BsonObjectToUStruct(Object, TBaseStructure<FTransform>::Get(), &Decoded));
+	TestTrue(TEXT("The struct survives the round trip"), Decoded.Equals(Transform));
+
+	// conversions after a reset build new plans and write the same bytes
+	const TArray<uint8> Bytes(Object.GetDataPointer(), (int32)Object.GetDataLength());
+	FBsonObjectConverter::ResetPlanCache();
+	FBsonObject Rebuilt;
+	TestTrue(TEXT("UStructToBsonObject succeeds after ResetPlanCache"),
+		FBsonObjectConverter::UStructToBsonObject(TBaseStructure<FTransform>::Get(), &Transform, Rebuilt));
+	TestTrue(TEXT("The rebuilt plan writes the same document"),
+		Rebuilt.GetDataLength() == (uint32)Bytes.Num() && FMemory::Memcmp(Rebuilt.GetDataPointer(), Bytes.GetData(), Bytes.Num()) == 0);
+
+	TestFalse(TEXT("UStructToBsonObject fails without a struct"),
+		FBsonObjectConverter::UStructToBsonObject(TBaseStructure<FTransform>::Get(), nullptr, Object));
+	TestEqual(TEXT("A failed conversion leaves the document empty"), (uint32)Object.GetDataLength(), 5u);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
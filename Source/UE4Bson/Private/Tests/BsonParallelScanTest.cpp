@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "BsonObject.h"
+#include "BsonFileReader.h"
+#include "BsonParallelScan.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+* Scans a dump in parallel, sums a field with ordered and unordered ParallelReduceDocuments and keeps copies of
+* documents and subdocuments that are read after the reader has unmapped the file.
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBsonParallelScanTest, "Bson.ParallelScan",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBsonParallelScanTest::RunTest(const FString& Parameters)
+{
+	const FString Filename = FPaths::AutomationTransientDir() + TEXT("BsonParallelScanTest.bson");
+	const int32 NumDocuments = 1000;
+
+	TArray<uint8> Dump;
+	for (int32 Index = 0; Index < NumDocuments; Index++)
+	{
+		TSharedPtr<FBsonObject> Location = MakeShareable(new FBsonObject());
+		Location->SetNumberField(TEXT("x"), Index);
+		FBsonObject Document;
+		Document.SetInt32Field(TEXT("index"), Index);
+		Document.SetObjectField(TEXT("location"), Location);
+		Dump.Append(Document.GetDataPointer(), (int32)Document.GetDataLength());
+	}
+	FFileHelper::SaveArrayToFile(Dump, *Filename);
+
+	FCriticalSection KeptLock;
+	TArray<FBsonObject> KeptDocuments;
+	TArray<FBsonObject> KeptLocations;
+	{
+		FBsonFileReader Reader(Filename);
+		TestTrue(TEXT("The reader maps the file"), Reader.IsOpen());
+
+		auto SumIndex = [](int64& State, const FBsonObject& Document)
+		{
+			int32 Index = 0;
+			Document.TryGetNumberField(TEXT("index"), Index);
+			State += Index;
+		};
+		auto AddSums = [](int64& InOutState, int64& ChunkState) { InOutState += ChunkState; };
+
+		int64 Sum = 0;
+		TestTrue(TEXT("ParallelReduceDocuments"), ParallelReduceDocuments(Reader, Sum, SumIndex, AddSums));
+		TestEqual(TEXT("Every document is reduced once"), Sum, (int64)NumDocuments * (NumDocuments - 1) / 2);
+
+		int64 UnorderedSum = 0;
+		TestTrue(TEXT("Unordered ParallelReduceDocuments"), ParallelReduceDocuments(Reader, UnorderedSum, SumIndex, AddSums, EBsonReduceOrder::Unordered));
+		TestEqual(TEXT("Every document is reduced once in any order"), UnorderedSum, Sum);
+
+		TestTrue(TEXT("ParallelForEachDocument"), ParallelForEachDocument(Reader, [&](const FBsonObject& Document)
+		{
+			int32 Index = 0;
+			if (Document.TryGetNumberField(TEXT("index"), Index) && Index % 100 == 0)
+			{
+				FScopeLock Lock(&KeptLock);
+				KeptDocuments.Add(Document);
+				KeptLocations.Add(*Document.GetObjectField(TEXT("location")));
+			}
+		}));
+	}
+
+	// the copies own their bytes, the file is no longer mapped
+	TestEqual(TEXT("Every kept document is there"), KeptDocuments.Num(), NumDocuments / 100);
+	int64 KeptSum = 0;
+	for (int32 Kept = 0; Kept < KeptDocuments.Num(); Kept++)
+	{
+		int32 Index = -1;
+		double X = -1;
+		KeptDocuments[Kept].TryGetNumberField(TEXT("index"), Index);
+		KeptLocations[Kept].TryGetNumberField(TEXT("x"), X);
+		TestEqual(TEXT("A kept subdocument belongs to its document"), X, (double)Index);
+		KeptSum += Index;
+	}
+	TestEqual(TEXT("The kept documents are intact"), KeptSum, (int64)(0 + 100 + 200 + 300 + 400 + 500 + 600 + 700 + 800 + 900));
+
+	IFileManager::Get().Delete(*Filename);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "BsonTraits.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	struct FBsonTraitsTestSample
+	{
+		int32 Channel = 0;
+		double Value = 0.0;
+	};
+
+	struct FBsonTraitsTestRecord
+	{
+		int64 Id = 0;
+		bool bValid = false;
+		float Scale = 0.f;
+		FString Name;
+		FBsonTraitsTestSample Latest;
+		TArray<FBsonTraitsTestSample> Samples;
+		TArray<double> Values;
+	};
+}
+
+template<>
+struct TBsonTraits<FBsonTraitsTestSample>
+{
+	template<typename VisitorType, typename RecordType>
+	static void VisitFields(VisitorType& Visitor, RecordType& Record)
+	{
+		Visitor("channel", Record.Channel);
+		Visitor("value", Record.Value);
+	}
+};
+
+template<>
+struct TBsonTraits<FBsonTraitsTestRecord>
+{
+	template<typename VisitorType, typename RecordType>
+	static void VisitFields(VisitorType& Visitor, RecordType& Record)
+	{
+		Visitor("id", Record.Id);
+		Visitor("valid", Record.bValid);
+		Visitor("scale", Record.Scale);
+		Visitor("name", Record.Name);
+		Visitor("latest", Record.Latest);
+		Visitor("samples", Record.Samples);
+		Visitor("values", Record.Values);
+	}
+};
+
+/**
+* Encodes a struct with nested structs and arrays through TBsonTraits, checks the size bound and decodes it again.
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBsonTraitsTest, "Bson.Traits",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBsonTraitsTest::RunTest(const FString& Parameters)
+{
+	FBsonTraitsTestRecord Record;
+	Record.Id = 1ll << 40;
+	Record.bValid = true;
+	Record.Scale = 0.5f;
+	Record.Latest = { 3, 2.5 };
+	for (int32 Index = 0; Index < 12; Index++)
+	{
+		Record.Samples.Add({ Index, Index * 0.25 });
+		Record.Values.Add(Index * 1.5);
+	}
+
+	// without strings the bound is exact
+	FBsonObject Object = FBsonTraitsSerializer::Encode(Record);
+	TestEqual(TEXT("The size of a document without strings is exact"),
+		(uint32)Object.GetDataLength(), FBsonTraitsSerializer::GetEncodedSizeBound(Record));
+
+	Record.Name = TEXT("Sensor \u00e4");
+	FBsonTraitsSerializer::Encode(Record, Object);
+	TestTrue(TEXT("The size bound holds for strings"),
+		(uint32)Object.GetDataLength() <= FBsonTraitsSerializer::GetEncodedSizeBound(Record));
+
+	FBsonTraitsTestRecord Decoded;
+	TestTrue(TEXT("Decode succeeds"), FBsonTraitsSerializer::Decode(Object, Decoded));
+	TestEqual(TEXT("id"), Decoded.Id, Record.Id);
+	TestEqual(TEXT("valid"), Decoded.bValid, Record.bValid);
+	TestEqual(TEXT("scale"), Decoded.Scale, Record.Scale);
+	TestEqual(TEXT("name"), Decoded.Name, Record.Name);
+	TestEqual(TEXT("latest.value"), Decoded.Latest.Value, Record.Latest.Value);
+	TestEqual(TEXT("samples"), Decoded.Samples.Num(), Record.Samples.Num());
+	TestEqual(TEXT("samples[11].channel"), Decoded.Samples.Last().Channel, Record.Samples.Last().Channel);
+	TestTrue(TEXT("values"), Decoded.Values == Record.Values);
+
+	// a field of the wrong type fails, the fields before it are read
+	FBsonObject Mismatched;
+	Mismatched.SetNumberField(TEXT("scale"), 4.0);
+	Mismatched.SetNumberField(TEXT("name"), 1.0);
+	FBsonTraitsTestRecord Partial;
+	TestFalse(TEXT("Decode fails for a numeric name"), FBsonTraitsSerializer::Decode(Mismatched, Partial));
+	TestEqual(TEXT("scale is read before the failure"), Partial.Scale, 4.f);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -1,18 +1,25 @@
 // Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
 
 #include "UE4Bson.h"
+#include "BsonMemory.h"
 
 #define LOCTEXT_NAMESPACE "FUE4BsonModule"
 
 void FUE4BsonModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+
+	// before anything is allocated by libbson, so all of its memory is tracked by Unreal
+	FBsonMemory::Install();
 }
 
 void FUE4BsonModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+
+	// only once all documents are gone, their buffers can't be released by libbson's default free
+	FBsonMemory::Uninstall();
 }
 
 #undef LOCTEXT_NAMESPACE
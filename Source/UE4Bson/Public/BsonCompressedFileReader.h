@@ -0,0 +1,172 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BsonObject.h"
+#include "BsonFileStats.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+* A block of a block-compressed Bson file, as stored in its block index.
+*/
+struct FBsonCompressedBlock
+{
+	/** Offset of the compressed payload in the file. */
+	int64 Offset;
+
+	/** Number of the first document of the block in the file. */
+	int64 FirstDocument;
+
+	uint32 CompressedSize;
+	uint32 UncompressedSize;
+	uint32 NumDocuments;
+
+	/** Whether the payload is stored uncompressed, see the file format. */
+	uint32 Flags;
+};
+
+
+/**
+* \brief Reads block-compressed Bson files, as written by FBsonFileWriter with a compression format.
+*
+* The file is memory mapped and its block index loaded, so opening is instant and any block can be
+* decompressed on its own: Next() and SeekToDocument() only decompress the block they need, and
+* DecompressBlock() and ForEachDocumentInBlock() can be called from several threads at the same time,
+* see ParallelForEachDocument(). A file without block index, e.g. one that is still being written,
+* is indexed by walking its block headers.
+*/
+class UE4BSON_API FBsonCompressedFileReader
+{
+public:
+
+	/**
+	* Maps the file and loads its block index.
+	*
+	* @param InFilename the file to read.
+	*/
+	explicit FBsonCompressedFileReader(const FString& InFilename);
+
+	/**
+	* Unmaps the file.
+	*/
+	~FBsonCompressedFileReader();
+
+	FBsonCompressedFileReader(const FBsonCompressedFileReader&) = delete;
+	FBsonCompressedFileReader& operator=(const FBsonCompressedFileReader&) = delete;
+
+	/** @return false if the file could not be opened or is not a block-compressed Bson file. */
+	bool IsOpen() const;
+
+	/** @return the FCompression format of the blocks. */
+	FName GetFormat() const { return Format; }
+
+	/** @return the number of blocks. */
+	int32 GetNumBlocks() const { return Blocks.Num(); }
+
+	/** @return a block of the index. */
+	const FBsonCompressedBlock& GetBlock(int32 BlockIndex) const { return Blocks[BlockIndex]; }
+
+	/** @return the number of documents in the file. */
+	int64 GetNumDocuments() const;
+
+	/**
+	* Decompresses a block. Can be called from several threads at the same time.
+	*
+	* @param BlockIndex the block to decompress.
+	* @param OutDocuments the buffer to fill with the concatenated documents of the block.
+	* @return false if the block is corrupt.
+	*/
+	bool DecompressBlock(int32 BlockIndex, TArray<uint8>& OutDocuments) const;
+
+	/**
+	* Calls Function(const FBsonObject& Document) for every document of a block, with the read-only
+	* object reused from one document to the next. Can be called from several threads at the same time.
+	*
+	* The documents borrow the decompressed block, which is freed when this returns. Function copies a
+	* document (FBsonObject Kept = Document;) to keep it, which copies its bytes.
+	*
+	* @return false if the block is corrupt.
+	*/
+	template<typename FunctionType>
+	bool ForEachDocumentInBlock(int32 BlockIndex, FunctionType&& Function) const
+	{
+		TArray<uint8> Documents;
+		if (!DecompressBlock(BlockIndex, Documents))
+		{
+			return false;
+		}
+
+		FBsonObject Document;
+		const FBsonObject& ReadOnlyDocument = Document;
+		TArrayView<const uint8> Bytes;
+		for (int32 Position = 0; Position < Documents.Num(); Position += Bytes.Num())
+		{
+			if (!ReadDocumentAt(Documents, Position, Bytes))
+			{
+				return false;
+			}
+			Document.SetBorrowed(Bytes.GetData(), Bytes.Num());
+			Function(ReadOnlyDocument);
+		}
+		return true;
+	}
+
+	/**
+	* Returns the next document of the file, decompressing the next block when the current one is done.
+	* The document and its subdocuments are only valid until the next block is decompressed. Copy it
+	* (FBsonObject Kept = Document;) to keep it, copies of borrowed documents own their bytes.
+	*
+	* @param OutObject the object to set to a read-only view of the document.
+	* @return false at the end of the file or at a corrupt block.
+	*/
+	bool Next(FBsonObject& OutObject);
+
+	/**
+	* Continues reading at the document with the given number, decompressing only the block that contains it.
+	*
+	* @param DocumentIndex the zero-based number of the document.
+	* @return false if the file has fewer documents.
+	*/
+	bool SeekToDocument(int64 DocumentIndex);
+
+	/** @return the statistics of all blocks decompressed so far. */
+	FBsonFileStats GetStats() const;
+
+private:
+
+	/** Walks the block headers to build the index of a file without one. */
+	void ScanBlocks(int64 FirstBlockOffset);
+
+	/**
+	* Checks a block index loaded from the footer: every block within the file before BlocksEnd, with
+	* sizes the writer can produce and the document numbers of the blocks before it.
+	*/
+	bool ValidateBlocks(int64 BlocksEnd) const;
+
+	/** Decompresses a block into CurrentDocuments, for Next(). */
+	bool LoadCurrentBlock(int32 BlockIndex);
+
+	static bool ReadDocumentAt(const TArray<uint8>& Documents, int32 Position, TArrayView<const uint8>& OutDocument);
+
+	FString Filename;
+	FName Format;
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	const uint8* Data;
+	int64 Size;
+	TArray<FBsonCompressedBlock> Blocks;
+
+	/** The writer's buffer size from the file header, the largest block of several documents. */
+	uint32 BufferSize;
+
+	/** State of Next(). */
+	int32 CurrentBlock;
+	int32 CurrentPosition;
+	TArray<uint8> CurrentDocuments;
+
+	mutable FCriticalSection StatsLock;
+	mutable FBsonFileStats Stats;
+};
@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BsonKey.h"
+
+/**
+* \brief A reusable set of field names for extracting several fields of an FBsonObject at once.
+*
+* The names are stored as FBsonKeys, so matching them against the keys of a document
+* doesn't need any conversions.
+*/
+class UE4BSON_API FBsonFieldSet
+{
+public:
+
+	/**
+	* Constructor that creates an empty set.
+	*/
+	FBsonFieldSet() {}
+
+	/**
+	* Creates a set containing the given field names, in this order.
+	*
+	* @param FieldNames the names of the fields.
+	*/
+	explicit FBsonFieldSet(const TArray<FString>& FieldNames);
+
+	/**
+	* Adds a field name to the set.
+	*
+	* If the name is already part of the set, batch lookups only fill the slot it was first added at.
+	*
+	* @param FieldName the name of the field to add.
+	* @return the index of the field within the set, which is also its slot in batch lookup results.
+	*/
+	int32 Add(const FString& FieldName) { return Add(FBsonKey(FieldName)); }
+
+	/**
+	* Adds a field name to the set.
+	*
+	* If the name is already part of the set, batch lookups only fill the slot it was first added at.
+	*
+	* @param Key the name of the field to add, has to stay valid as long as the set is used.
+	* @return the index of the field within the set, which is also its slot in batch lookup results.
+	*/
+	int32 Add(const FBsonKey& Key);
+
+	/** @return the number of field names in this set. */
+	int32 Num() const { return Keys.Num(); }
+
+	/** @return the number of distinct field names in this set. */
+	int32 NumUnique() const { return NumUniqueKeys; }
+
+	/**
+	* @param Index the index of the field within the set.
+	* @return the name of the field.
+	*/
+	const FBsonKey& GetKey(int32 Index) const { return Keys[Index]; }
+
+	/**
+	* Finds the index of a field name within the set.
+	*
+	* @param Key the name to find.
+	* @return the index of the field, INDEX_NONE if it is not part of the set.
+	*/
+	int32 Find(const FBsonKey& Key) const;
+
+private:
+
+	TArray<FBsonKey> Keys;
+
+	/** Open addressing hash table of indices into Keys, INDEX_NONE marks empty buckets. */
+	TArray<int32> Buckets;
+
+	int32 NumUniqueKeys = 0;
+
+	void Insert(int32 Index);
+
+	void Rehash();
+};
@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FBsonKey;
+
+/**
+* \brief The offsets of the documents of a Bson dump file, stored in a sidecar file next to the dump.
+*
+* The sidecar is a small header followed by one entry per document: its offset in the dump and, if the
+* index was built with a timestamp field, the value of that field. Update() only scans the part of the
+* dump that was written since the last update and appends to the sidecar, so it can be called periodically
+* while an FBsonFileWriter is still producing the dump. The sidecar records the start of the first document,
+* a sidecar of a dump that has been replaced since is rebuilt instead of appended to.
+*
+* FBsonFileReader::LoadIndex() loads the sidecar for FBsonFileReader::SeekToDocument() and SeekToTimestamp().
+*/
+class UE4BSON_API FBsonFileIndex
+{
+public:
+
+	/** @return the default sidecar of a dump, the dump file name with ".idx" appended. */
+	static FString GetIndexFilename(const FString& DumpFilename);
+
+	/**
+	* Indexes the documents of a dump that are not in the sidecar yet, creating the sidecar if needed.
+	* A document at the end of the dump that is not completely written yet is left for the next update.
+	*
+	* @param DumpFilename the dump to index.
+	* @param IndexFilename the sidecar to create or append to.
+	* @return the number of documents added, INDEX_NONE if a file could not be read or written.
+	*/
+	static int64 Update(const FString& DumpFilename, const FString& IndexFilename);
+
+	/**
+	* Indexes the documents of a dump that are not in the sidecar yet, recording the value of a timestamp
+	* field of every document (a DateTime as Unix milliseconds, or an integer or number). Documents without
+	* the field get the timestamp of the previous document. Timestamps must not decrease through the dump
+	* for SeekToTimestamp() to work.
+	*
+	* An existing sidecar without timestamps is rebuilt.
+	*
+	* @param DumpFilename the dump to index.
+	* @param IndexFilename the sidecar to create or append to.
+	* @param TimestampField the name of the timestamp field.
+	* @return the number of documents added, INDEX_NONE if a file could not be read or written.
+	*/
+	static int64 Update(const FString& DumpFilename, const FString& IndexFilename, const FString& TimestampField);
+
+	/**
+	* Overload taking an already encoded FBsonKey.
+	*/
+	static int64 Update(const FString& DumpFilename, const FString& IndexFilename, const FBsonKey& TimestampKey);
+
+	/**
+	* Loads a sidecar, replacing the current entries.
+	*
+	* @param IndexFilename the sidecar to load.
+	* @return false if the file is missing or not an index.
+	*/
+	bool Load(const FString& IndexFilename);
+
+	/** @return the number of indexed documents. */
+	int32 Num() const { return Offsets.Num(); }
+
+	/** @return true if the index holds a timestamp for every document. */
+	bool HasTimestamps() const { return bTimestamps; }
+
+	/** @return the offset in the dump of the document with the given number. */
+	int64 GetOffset(int32 Index) const { return Offsets[Index]; }
+
+	/** @return the timestamp of the document with the given number. */
+	int64 GetTimestamp(int32 Index) const { return Timestamps[Index]; }
+
+	/**
+	* Binary searches the timestamps.
+	*
+	* @return the number of the first document with a timestamp not less than Timestamp, INDEX_NONE if there is none.
+	*/
+	int32 FindTimestamp(int64 Timestamp) const;
+
+private:
+
+	static int64 UpdateIndex(const FString& DumpFilename, const FString& IndexFilename, const FBsonKey* TimestampKey);
+
+	TArray<int64> Offsets;
+	TArray<int64> Timestamps;
+	bool bTimestamps = false;
+};
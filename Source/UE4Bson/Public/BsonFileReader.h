@@ -0,0 +1,180 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BsonObject.h"
+#include "BsonFileIndex.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+* A range of whole documents of a dump file, see FBsonFileReader::SplitIntoChunks().
+*/
+struct FBsonFileChunk
+{
+	/** Offset of the first document. */
+	int64 Begin;
+
+	/** Offset after the last document. */
+	int64 End;
+
+	/** Number of the first document in the dump. */
+	int64 FirstDocument;
+};
+
+/**
+* \brief Reads the documents of a Bson dump file (concatenated documents, as written by FBsonFileWriter or mongodump).
+*
+* The file is memory mapped instead of read, so opening it takes the same time for any size. Next() returns
+* read-only FBsonObjects that borrow the mapped bytes (see FBsonObject::Borrow()), nothing is copied until a
+* document is modified. Pages are loaded by the OS as the documents are read. No access pattern hint is given,
+* the mapping relies on the OS read-ahead of mapped files; preloading the whole region would cost as much as
+* reading the file.
+*
+* Documents returned by Next() and subdocuments of them must not be read after the reader is destroyed.
+* Copy a document (FBsonObject Kept = Document;) to keep it, copies of borrowed documents own their bytes.
+*/
+class UE4BSON_API FBsonFileReader
+{
+public:
+
+	/**
+	* Maps the file.
+	*
+	* @param InFilename the dump file to read.
+	*/
+	explicit FBsonFileReader(const FString& InFilename);
+
+	/**
+	* Unmaps the file.
+	*/
+	~FBsonFileReader();
+
+	FBsonFileReader(const FBsonFileReader&) = delete;
+	FBsonFileReader& operator=(const FBsonFileReader&) = delete;
+
+	/** @return false if the file could not be opened or mapped. */
+	bool IsOpen() const;
+
+	/**
+	* Returns the next document of the file.
+	*
+	* The length header of the document is checked against the rest of the file and the document must end with
+	* a zero byte. If it doesn't the file is corrupt and reading stops, see HasError().
+	*
+	* @param OutObject the object to set to a read-only view of the document.
+	* @return false at the end of the file or at a corrupt document.
+	*/
+	bool Next(FBsonObject& OutObject);
+
+	/**
+	* Returns the bytes of the next document of the file, without creating an FBsonObject.
+	*
+	* @param OutDocument the view to set to the bytes of the document.
+	* @return false at the end of the file or at a corrupt document.
+	*/
+	bool Next(TArrayView<const uint8>& OutDocument);
+
+	/**
+	* Returns the bytes of the document at the given position, without moving the read position.
+	* Can be called from several threads at the same time.
+	*
+	* @param InOffset the position of the document.
+	* @param OutDocument the view to set to the bytes of the document.
+	* @return false if there is no valid document at InOffset.
+	*/
+	bool ReadDocumentAt(int64 InOffset, TArrayView<const uint8>& OutDocument) const;
+
+	/**
+	* Splits the file into ranges of whole documents, e.g. for ParallelForEachDocument().
+	*
+	* With an index (see LoadIndex()) every chunk gets the same number of documents. Without one the chunks
+	* get about the same number of bytes, which requires walking all length headers once.
+	*
+	* @param NumChunks the number of chunks wanted, fewer are returned for small files.
+	* @return the chunks in file order, covering the whole file.
+	*/
+	TArray<FBsonFileChunk> SplitIntoChunks(int32 NumChunks) const;
+
+	/**
+	* Calls Function(const FBsonObject& Document) for every document of a chunk, with the read-only
+	* object reused from one document to the next. Can be called from several threads at the same time.
+	*
+	* @return false if the chunk contains a corrupt document, which ends it.
+	*/
+	template<typename FunctionType>
+	bool ForEachDocument(const FBsonFileChunk& Chunk, FunctionType&& Function) const
+	{
+		FBsonObject Document;
+		const FBsonObject& ReadOnlyDocument = Document;
+		TArrayView<const uint8> Bytes;
+		for (int64 Position = Chunk.Begin; Position < Chunk.End; Position += Bytes.Num())
+		{
+			if (!ReadDocumentAt(Position, Bytes))
+			{
+				return false;
+			}
+			Document.SetBorrowed(Bytes.GetData(), Bytes.Num());
+			Function(ReadOnlyDocument);
+		}
+		return true;
+	}
+
+	/** @return true if reading stopped at a corrupt document instead of the end of the file. */
+	bool HasError() const { return bError; }
+
+	/** @return the position of the next document in the file. */
+	int64 GetOffset() const { return Offset; }
+
+	/** @return the size of the file. */
+	int64 GetFileSize() const { return Size; }
+
+	/**
+	* Continues reading at the given position, which must be the start of a document, e.g. from GetOffset().
+	* Clears the error state.
+	*/
+	void Seek(int64 InOffset);
+
+	/**
+	* Loads the sidecar index of the dump, see FBsonFileIndex.
+	*
+	* @param IndexFilename the sidecar, FBsonFileIndex::GetIndexFilename() of the dump if empty.
+	* @return false if there is no valid index.
+	*/
+	bool LoadIndex(const FString& IndexFilename = FString());
+
+	/**
+	* Continues reading at the document with the given number. Uses the index where it covers the document,
+	* otherwise walks the length headers from the last indexed document, or from the start without index.
+	*
+	* @param DocumentIndex the zero-based number of the document.
+	* @return false if the dump has fewer documents.
+	*/
+	bool SeekToDocument(int64 DocumentIndex);
+
+	/**
+	* Continues reading at the first document with a timestamp not less than Timestamp.
+	* Requires an index built with a timestamp field.
+	*
+	* @param Timestamp the timestamp to search, Unix milliseconds for DateTime fields.
+	* @return false if there is no index with timestamps or no such document.
+	*/
+	bool SeekToTimestamp(int64 Timestamp);
+
+	/** @return the loaded index, empty if LoadIndex() was not called. */
+	const FBsonFileIndex& GetIndex() const { return Index; }
+
+private:
+
+	FString Filename;
+	FBsonFileIndex Index;
+
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	const uint8* Data;
+	int64 Size;
+	int64 Offset;
+	bool bError;
+};
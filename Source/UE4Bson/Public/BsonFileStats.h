@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* Statistics of an FBsonFileWriter or FBsonCompressedFileReader.
+*/
+struct FBsonFileStats
+{
+	/** Number of documents written or read. */
+	uint64 Documents = 0;
+
+	/** Bytes of the documents themselves. */
+	uint64 UncompressedBytes = 0;
+
+	/**
+	* Bytes of the blocks in the file: compressed payloads and block headers, without the file header and the
+	* block index, so writer and reader of the same file report the same. For plain dumps the document bytes.
+	*/
+	uint64 FileBytes = 0;
+
+	/** Time spent compressing or decompressing. */
+	double CompressionSeconds = 0;
+
+	/** @return how many times smaller the file is than the documents. */
+	double GetCompressionRatio() const
+	{
+		return FileBytes > 0 ? (double)UncompressedBytes / FileBytes : 1.0;
+	}
+
+	/** @return the uncompressed megabytes compressed or decompressed per second. */
+	double GetCompressionThroughput() const
+	{
+		return CompressionSeconds > 0 ? UncompressedBytes / (1024.0 * 1024.0) / CompressionSeconds : 0;
+	}
+};
@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BsonFileStats.h"
+
+class FBsonObject;
+class FBsonFileWriterThread;
+
+/**
+* What FBsonFileWriter does with a document when all of its buffers are waiting to be written.
+*/
+enum class EBsonFileWriterOverflow : uint8
+{
+	/** Wait on the calling thread until the background thread has written a buffer. */
+	Block,
+	/** Drop the document that is being written. */
+	DropNewest,
+	/** Drop the oldest buffer that has not been written yet, with all documents in it. */
+	DropOldest
+};
+
+
+/**
+* Settings of an FBsonFileWriter.
+*/
+struct FBsonFileWriterSettings
+{
+	/** Size of each buffer. Documents are collected in a buffer until it is full and then written with a single call. */
+	uint32 BufferSize = 4 * 1024 * 1024;
+
+	/** Number of full buffers that can wait for the background thread before Overflow applies. */
+	int32 MaxQueuedBuffers = 8;
+
+	/** What to do with documents when MaxQueuedBuffers are waiting. */
+	EBsonFileWriterOverflow Overflow = EBsonFileWriterOverflow::Block;
+
+	/**
+	* Seconds after which the background thread takes over a partially filled buffer and flushes the file to disk,
+	* so documents reach the disk within about this time even if no more are written. 0 hands buffers over only
+	* when they are full or on Flush(), and flushes the file to disk after every buffer.
+	*/
+	double FlushIntervalSeconds = 1.0;
+
+	/** Append to an existing file instead of replacing it. Not supported for compressed files. */
+	bool bAppend = false;
+
+	/**
+	* FCompression format (e.g. NAME_Zlib or NAME_LZ4) to compress every buffer with as an independent block,
+	* writing a block-compressed file for FBsonCompressedFileReader instead of a plain dump. NAME_None writes
+	* a plain dump. Compression happens on the background thread.
+	*/
+	FName CompressionFormat = NAME_None;
+};
+
+
+/**
+* \brief Writes Bson documents to a dump file (concatenated documents, as read by mongorestore) on a background thread.
+*
+* Write() only copies the bytes of a document into the current buffer. Full buffers are queued for a
+* dedicated thread that writes them through an IFileHandle and then returns them to a pool, so after
+* warming up no memory is allocated and the calling thread never waits for the disk, unless
+* EBsonFileWriterOverflow::Block is used and the disk can't keep up.
+*
+* Write(), Flush() and Close() must not be called from several threads at the same time.
+*/
+class UE4BSON_API FBsonFileWriter
+{
+public:
+
+	/**
+	* Opens the file and starts the background thread.
+	*
+	* @param Filename the file to write to, missing directories are created.
+	* @param InSettings buffer sizes and overflow behaviour.
+	*/
+	explicit FBsonFileWriter(const FString& Filename, const FBsonFileWriterSettings& InSettings = FBsonFileWriterSettings());
+
+	/**
+	* Writes all pending documents and closes the file.
+	*/
+	~FBsonFileWriter();
+
+	FBsonFileWriter(const FBsonFileWriter&) = delete;
+	FBsonFileWriter& operator=(const FBsonFileWriter&) = delete;
+
+	/** @return false if the file could not be opened or the writer has been closed. */
+	bool IsOpen() const;
+
+	/**
+	* Copies a document into the current buffer.
+	*
+	* @param Object the document to write.
+	* @return false if the document was dropped or the writer is not open.
+	*/
+	bool Write(const FBsonObject& Object);
+
+	/**
+	* Writes a document that is not needed anymore. Documents of at least half a buffer are handed to the
+	* background thread with FBsonObject::Release() instead of being copied, unless they were built inside an
+	* FBsonScopedArena. Smaller documents are copied into the current buffer like Write(const FBsonObject&).
+	*
+	* @param Object the document to write, empty afterwards.
+	* @return false if the document was dropped or the writer is not open.
+	*/
+	bool Write(FBsonObject&& Object);
+
+	/**
+	* Copies an already encoded document into the current buffer.
+	*
+	* @param Data pointer to the bytes of the document.
+	* @param Length number of bytes of the document.
+	* @return false if the document was dropped or the writer is not open.
+	*/
+	bool Write(const uint8* Data, uint32 Length);
+
+	/**
+	* Hands the current buffer to the background thread and waits until everything is written and flushed to disk.
+	*/
+	void Flush();
+
+	/**
+	* Writes all pending documents, stops the background thread and closes the file.
+	*/
+	void Close();
+
+	/** @return the number of bytes written to the file so far. */
+	uint64 GetWrittenBytes() const;
+
+	/** @return the number of documents and bytes written so far, and the compression ratio and throughput. */
+	FBsonFileStats GetStats() const;
+
+	/** @return the number of documents dropped because of EBsonFileWriterOverflow or failed writes. */
+	uint64 GetDroppedDocuments() const;
+
+private:
+
+	friend class FBsonFileWriterThread;
+
+	/** A block of complete documents. */
+	struct FBuffer
+	{
+		TArray<uint8> Data;
+		int32 NumDocuments = 0;
+
+		/** A single document handed over by Write(FBsonObject&&), written instead of Data. */
+		uint8* Released = nullptr;
+		uint32 ReleasedLength = 0;
+
+		const uint8* GetData() const { return Released ? Released : Data.GetData(); }
+		uint32 Num() const { return Released ? ReleasedLength : (uint32)Data.Num(); }
+	};
+
+	FBsonFileWriterSettings Settings;
+
+	/** Owns the file, the buffers, the queue and the buffer Write() appends to. Invalid if the file could not be opened or after Close(). */
+	TUniquePtr<FBsonFileWriterThread> Thread;
+
+	/** Totals of the background thread, kept after Close(). */
+	FBsonFileStats Stats;
+	uint64 DroppedDocuments;
+	uint64 WrittenBytes;
+};
@@ -0,0 +1,136 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* \brief A field name that is already encoded as UTF-8 and hashed.
+*
+* Passing an FBsonKey instead of an FString to the field accessors of FBsonObject
+* skips the TCHAR to UTF-8 conversion and the hashing of the name on every call.
+* Keys created from string literals are computed at compile time, keys created from
+* FStrings or FNames are interned once and stay valid until the module is unloaded.
+*
+* Interned names are never freed and every interning constructor takes a global lock, so create such
+* keys once for a fixed set of names (e.g. as statics) rather than per call, and never from unbounded
+* data like user input or map keys: wrap the UTF-8 bytes of those with the (InUtf8, InLength) constructor.
+*
+* \code
+* static const FBsonKey LocationKey("Location");
+* Object->SetNumberField(LocationKey, 42);
+* \endcode
+*/
+class UE4BSON_API FBsonKey
+{
+public:
+
+	/**
+	* Creates a key from a (UTF-8 or plain ASCII) string literal, at compile time where possible.
+	*
+	* Any const array binds here, not only literals, so the key ends at the first zero of the array.
+	* Non-const arrays, i.e. buffers filled at runtime, are rejected, see the (InUtf8, InLength) constructor.
+	*
+	* @param Literal the string literal.
+	*/
+	template<int32 N>
+	explicit constexpr FBsonKey(const ANSICHAR (&Literal)[N])
+		: Utf8(Literal), Length(LiteralLength(Literal, N)), Hash(HashUtf8(Literal, LiteralLength(Literal, N))) {}
+
+	template<int32 N>
+	explicit FBsonKey(ANSICHAR (&Buffer)[N]) = delete;
+
+	/**
+	* Wraps UTF-8 bytes without copying them, the bytes have to outlive the key.
+	*
+	* @param InUtf8 the UTF-8 bytes of the key.
+	* @param InLength the number of bytes, without a terminating zero.
+	*/
+	constexpr FBsonKey(const ANSICHAR* InUtf8, int32 InLength)
+		: Utf8(InUtf8), Length(InLength), Hash(HashUtf8(InUtf8, InLength)) {}
+
+	/**
+	* Wraps UTF-8 bytes with an already computed hash, the bytes have to outlive the key.
+	*
+	* @param InUtf8 the UTF-8 bytes of the key.
+	* @param InLength the number of bytes, without a terminating zero.
+	* @param InHash the result of HashUtf8(InUtf8, InLength).
+	*/
+	constexpr FBsonKey(const ANSICHAR* InUtf8, int32 InLength, uint32 InHash)
+		: Utf8(InUtf8), Length(InLength), Hash(InHash) {}
+
+	/**
+	* Creates a key from an FString, converting it only the first time a name is seen.
+	*
+	* @param Name the name of the field.
+	*/
+	explicit FBsonKey(const FString& Name);
+
+	/**
+	* Creates a key from an FName, converting it only the first time a name is seen.
+	* Later calls find the key by the index and number of the name, without converting it to a string.
+	*
+	* @param Name the name of the field.
+	*/
+	explicit FBsonKey(FName Name);
+
+	/** @return the UTF-8 bytes of the key. Interned and literal keys are zero terminated. */
+	constexpr const ANSICHAR* GetUtf8() const { return Utf8; }
+
+	/** @return the number of UTF-8 bytes of the key, without a terminating zero. */
+	constexpr int32 Len() const { return Length; }
+
+	/** @return the hash of the UTF-8 bytes, see HashUtf8(). */
+	constexpr uint32 GetHash() const { return Hash; }
+
+	/** @return the key converted back to an FString. */
+	FString ToString() const;
+
+	bool operator==(const FBsonKey& Other) const
+	{
+		return Hash == Other.Hash && Length == Other.Length && FMemory::Memcmp(Utf8, Other.Utf8, Length) == 0;
+	}
+
+	bool operator!=(const FBsonKey& Other) const { return !(*this == Other); }
+
+	/**
+	* Hashes UTF-8 bytes (FNV-1a). All hashed key lookups of the plugin use this function.
+	*
+	* @param Key the bytes to hash.
+	* @param KeyLength the number of bytes to hash.
+	* @return the hash of the bytes.
+	*/
+	static constexpr uint32 HashUtf8(const ANSICHAR* Key, int32 KeyLength)
+	{
+		uint32 Result = 2166136261u;
+		for (int32 Idx = 0; Idx < KeyLength; Idx++)
+		{
+			Result = (Result ^ (uint8)Key[Idx]) * 16777619u;
+		}
+		return Result;
+	}
+
+private:
+
+	const ANSICHAR* Utf8;
+	int32 Length;
+	uint32 Hash;
+
+	void Intern(const TCHAR* Name);
+
+	/** @return the number of bytes of an array of N bytes before its first zero, at most N - 1. */
+	static constexpr int32 LiteralLength(const ANSICHAR* Literal, int32 N)
+	{
+		int32 Result = 0;
+		while (Result < N - 1 && Literal[Result] != 0)
+		{
+			Result++;
+		}
+		return Result;
+	}
+};
+
+FORCEINLINE uint32 GetTypeHash(const FBsonKey& Key)
+{
+	return Key.GetHash();
+}
@@ -4,6 +4,11 @@
 
 #include "CoreMinimal.h"
 #include "BsonValue.h"
+#include "BsonKey.h"
+#include "BsonValueView.h"
+#include "BsonVariant.h"
+#include "BsonPath.h"
+#include "BsonFieldSet.h"
 #include "Json.h"
 
 
@@ -12,15 +17,41 @@
 *
 * This classes main purpose is to contain a hidden bson_t document.
 * It can be edited and read (mostly) in known FJsonObject manner.
+*
+* Setting a field that already exists replaces it instead of adding a duplicate key. Fixed width
+* values (numbers, booleans, DateTimes, ObjectIds) of the same type are overwritten in place, so
+* a pre-shaped object can be patched repeatedly without allocating. Other replacements rewrite the
+* fields behind the replaced one.
+*
+* Field lookups are served from an index that is built lazily on the first repeated read. Appends
+* and in-place overwrites keep it up to date, other writes drop it. The index is published atomically,
+* so const access from several threads at once is safe; writes need exclusive access to the object.
 */
 class UE4BSON_API FBsonObject
 {
 private:
+
+	friend class FBsonWriter;
+	friend class FBsonVariant;
+	friend class FBsonObjectConverter;
+	friend class FBsonFileWriter;
 	
 	struct LibbsonImpl;
 
+	/** The implementation, nullptr after this object was moved from until it is written to again. */
 	LibbsonImpl *Impl;
 
+	/** @return Impl, or a shared empty document if there is none. */
+	const LibbsonImpl &ReadImpl() const;
+
+	/** @return Impl, created empty if there is none. */
+	LibbsonImpl &WriteImpl();
+
+	/**
+	* Creates an FBsonObject around an already set up implementation, taking ownership of it.
+	*/
+	explicit FBsonObject(LibbsonImpl *InImpl);
+
 public:
 
 	/**
@@ -28,6 +59,16 @@ public:
 	*/
 	FBsonObject();
 
+	/**
+	* Constructor that creates an empty Bson Document with room for the given number of bytes,
+	* avoiding the reallocations while it is filled.
+	*
+	* Small documents don't need this, they are kept inline without a separate buffer.
+	*
+	* @param ReserveBytes the expected size of the finished document.
+	*/
+	explicit FBsonObject(uint32 ReserveBytes);
+
 	/**
 	* Creates a Bson Document from the provided Data, assumes the data is valid Bson format.
 	*/
@@ -35,8 +76,84 @@ public:
 
 	FBsonObject(FString Data);
 
+	/**
+	* Creates a read-only Bson Document that adopts the given serialized bytes without copying them.
+	* The bytes are copied on the first write.
+	*/
+	explicit FBsonObject(TArray<uint8>&& Buffer);
+
+	/**
+	* Creates a copy that shares this document's bytes until either of them is written to.
+	* A small document, or one that outgrew libbson's inline storage with its last write, is copied instead,
+	* as is a document on borrowed bytes (see Borrow()), so the copy stays valid after those bytes are gone.
+	* Copying is a const operation, several threads may copy or read the same object at the same time.
+	*/
+	FBsonObject(const FBsonObject& Other);
+
+	/**
+	* Takes over the document of Other, which is left empty.
+	* Doesn't allocate, Other only allocates a new document if it is written to again.
+	*/
+	FBsonObject(FBsonObject&& Other);
+
+	FBsonObject& operator=(const FBsonObject& Other);
+	FBsonObject& operator=(FBsonObject&& Other);
+
 	~FBsonObject();
 
+	/**
+	* Creates a read-only Bson Document on bytes owned by the caller, without copying them.
+	*
+	* The bytes must stay valid and unchanged as long as the returned object, or any subdocument of it,
+	* reads them. The first write copies them. Copies of the object (and of its subdocuments) copy the bytes,
+	* keep one with FBsonObject Kept = Document; to read it after the bytes are gone.
+	*
+	* @param Data the serialized document.
+	* @param Length the length of Data.
+	* @return the borrowing object, an empty one if Data isn't a valid document.
+	*/
+	static FBsonObject Borrow(const uint8* Data, uint32 Length);
+
+	/**
+	* Makes this object a read-only document on bytes owned by the caller, like Borrow(), but reuses this
+	* object instead of creating a new one. Meant for loops over many documents.
+	*
+	* @param Data the serialized document.
+	* @param Length the length of Data.
+	* @return false if Data isn't a valid document, this object is empty then.
+	*/
+	bool SetBorrowed(const uint8* Data, uint32 Length);
+
+	/**
+	* Hands the buffer of this document over to the caller and leaves this object empty.
+	*
+	* An owned buffer is handed out as is, without copying. It has to be freed with FreeReleasedBuffer().
+	*
+	* @param OutLength the length of the document in the buffer.
+	* @return the serialized document.
+	*/
+	uint8* Release(uint32& OutLength);
+
+	/**
+	* Frees a buffer obtained from Release().
+	*/
+	static void FreeReleasedBuffer(uint8* Buffer);
+
+	/**
+	* Removes all fields, keeping the allocated buffer for the next document built in this object.
+	*
+	* Rebuilding a document of the same shape after a Reset() doesn't allocate. A buffer shared with
+	* copies or subdocuments is left to them instead, and this object starts over empty.
+	*/
+	void Reset();
+
+	/**
+	* High-water mark of the document length, e.g. for choosing the size passed to FBsonObject(uint32).
+	*
+	* @return the largest length this document had, across all calls to Reset().
+	*/
+	uint32 GetPeakDataLength() const;
+
 	/**
 	* @return a pointer to the memory region where the bson formatted data is located.
 	*/
@@ -80,6 +197,9 @@ public:
 	*/
 	TSharedPtr<FBsonValue> GetField(const FString &FieldName) const; // create more options?
 
+	/** Overload taking an already encoded FBsonKey. */
+	TSharedPtr<FBsonValue> GetField(const FBsonKey& Key) const;
+
 	/**
 	* Tries to find the specified field and returns it.
 	*
@@ -87,6 +207,9 @@ public:
 	* @return a TSharedPtr<FBsonValue> that contains the data at the first key named 'FieldName'. If no key 'FieldName' exists, return nullptr.
 	*/
 	TSharedPtr<FBsonValue> TryGetField(const FString& FieldName) const;
+
+	/** Overload taking an already encoded FBsonKey. */
+	TSharedPtr<FBsonValue> TryGetField(const FBsonKey& Key) const;
 	
 	/**
 	* Checks whether the specified field exists.
@@ -96,6 +219,88 @@ public:
 	*/
 	bool HasField(const FString& FieldName) const;
 
+	/** Overload taking an already encoded FBsonKey. */
+	bool HasField(const FBsonKey& Key) const;
+
+	/**
+	* Returns a non-owning view of the field with the given fieldname(key).
+	*
+	* Reading a field this way does not allocate, the view points directly into this object's buffer.
+	* It stays valid as long as this object is alive and not modified.
+	*
+	* @param FieldName The name of the field to get.
+	* @return a view of the field, or a view of type EBson::None if no key 'FieldName' exists.
+	*/
+	FBsonValueView GetFieldView(const FString& FieldName) const;
+
+	/** Overload taking an already encoded FBsonKey. */
+	FBsonValueView GetFieldView(const FBsonKey& Key) const;
+
+	/**
+	* Tries to find the specified field and returns a non-owning view of it.
+	*
+	* @param FieldName The name of the field to find.
+	* @param OutView A reference for the view to go in.
+	* @return false if FieldName doesn't exist.
+	*/
+	bool TryGetFieldView(const FString& FieldName, FBsonValueView& OutView) const;
+
+	/** Overload taking an already encoded FBsonKey. */
+	bool TryGetFieldView(const FBsonKey& Key, FBsonValueView& OutView) const;
+
+	/**
+	* Returns a nested field, descending through subdocuments and arrays along a dotted path.
+	*
+	* @param Path The path to the field, e.g. "pose.location.x" or "joints[3].position".
+	* @return TSharedPtr with an appropriate FBsonValue, FBsonValueNull if the path doesn't exist.
+	*/
+	TSharedPtr<FBsonValue> GetFieldByPath(const FString& Path) const;
+
+	/**
+	* Returns a nested field along a precompiled path.
+	*
+	* The path is walked on the raw bytes, no intermediate objects are created.
+	*
+	* @param Path The parsed path to the field.
+	* @return TSharedPtr with an appropriate FBsonValue, FBsonValueNull if the path doesn't exist.
+	*/
+	TSharedPtr<FBsonValue> GetFieldByPath(const FBsonPath& Path) const;
+
+	/**
+	* Returns a non-owning view of a nested field along a precompiled path.
+	*
+	* @param Path The parsed path to the field.
+	* @return a view of the field, or a view of type EBson::None if the path doesn't exist.
+	*/
+	FBsonValueView GetFieldViewByPath(const FBsonPath& Path) const;
+
+	/**
+	* Tries to find a nested field along a precompiled path and returns a non-owning view of it.
+	*
+	* @param Path The parsed path to the field.
+	* @param OutView A reference for the view to go in.
+	* @return false if the path doesn't exist.
+	*/
+	bool TryGetFieldViewByPath(const FBsonPath& Path, FBsonValueView& OutView) const;
+
+	/**
+	* Finds several fields in a single pass over the document, stopping as soon as all of them are found.
+	*
+	* @param Fields The set of field names to find.
+	* @param OutValues Receives one value per name in Fields, in the same order. Names that don't exist get a nullptr.
+	* @return the number of fields that were found.
+	*/
+	int32 GetFields(const FBsonFieldSet& Fields, TArray<TSharedPtr<FBsonValue>>& OutValues) const;
+
+	/**
+	* Finds several fields in a single pass over the document and returns non-owning views of them.
+	*
+	* @param Fields The set of field names to find.
+	* @param OutViews Receives one view per name in Fields, in the same order. Names that don't exist get a view of type EBson::None.
+	*                 Has to have exactly Fields.Num() elements.
+	* @return the number of fields that were found.
+	*/
+	int32 GetFieldViews(const FBsonFieldSet& Fields, TArrayView<FBsonValueView> OutViews) const;
 
 
 
@@ -109,6 +314,9 @@ public:
 	*/
 	double GetNumberField(const FString& FieldName) const;
 
+	/** Overload taking an already encoded FBsonKey. */
+	double GetNumberField(const FBsonKey& Key) const;
+
 	/**
 	* Finds the field with the specified name and returns it as an int32.
 	*
@@ -122,6 +330,12 @@ public:
 		return (int32)GetNumberField(FieldName);
 	}
 
+	/** Overload taking an already encoded FBsonKey. */
+	FORCEINLINE int32 GetIntegerField(const FBsonKey& Key) const
+	{
+		return (int32)GetNumberField(Key);
+	}
+
 	/**
 	* Tries to find the field with the specified name and return it as a double.
 	*
@@ -131,6 +345,110 @@ public:
 	*/
 	bool TryGetNumberField(const FString& FieldName, double& OutNumber) const;
 
+	/** Overload taking an already encoded FBsonKey. */
+	bool TryGetNumberField(const FBsonKey& Key, double& OutNumber) const;
+
+	/**
+	* Tries to find the field with the specified name and return it as an int32.
+	* Integer fields are read exactly, doubles are rounded.
+	*
+	* @param FieldName The name of the field to get.
+	* @param OutNumber A reference for the output to go in.
+	* @return false if FieldName doesn't exist or cannot be converted to int32.
+	*/
+	bool TryGetNumberField(const FString& FieldName, int32& OutNumber) const;
+
+	/** Overload taking an already encoded FBsonKey. */
+	bool TryGetNumberField(const FBsonKey& Key, int32& OutNumber) const;
+
+	/**
+	* Tries to find the field with the specified name and return it as an int64.
+	* Integer fields are read exactly, doubles are rounded.
+	*
+	* @param FieldName The name of the field to get.
+	* @param OutNumber A reference for the output to go in.
+	* @return false if FieldName doesn't exist or cannot be converted to int64.
+	*/
+	bool TryGetNumberField(const FString& FieldName, int64& OutNumber) const;
+
+	/** Overload taking an already encoded FBsonKey. */
+	bool TryGetNumberField(const FBsonKey& Key, int64& OutNumber) const;
+
+	/**
+	* Finds the field with the specified name and returns it as an int64.
+	*
+	* Assumes that the field is present and is of numerical type. Integer fields are read exactly.
+	*
+	* @param FieldName The name of the field to get.
+	* @return The field's value as an int64.
+	*/
+	int64 GetInt64Field(const FString& FieldName) const;
+
+	/** Overload taking an already encoded FBsonKey. */
+	int64 GetInt64Field(const FBsonKey& Key) const;
+
+	/**
+	* Finds the field with the specified name and returns it as an FDateTime.
+	*
+	* Assumes that the field is present and is of type DateTime.
+	*
+	* @param FieldName The name of the field to get.
+	* @return The field's value as an FDateTime.
+	*/
+	FDateTime GetDateTimeField(const FString& FieldName) const;
+
+	/** Overload taking an already encoded FBsonKey. */
+	FDateTime GetDateTimeField(const FBsonKey& Key) const;
+
+	/**
+	* Tries to find the field with the specified name and return it as an FDateTime.
+	*
+	* @param FieldName The name of the field to get.
+	* @param OutDateTime A reference for the output to go in.
+	* @return false if FieldName doesn't exist or is not a DateTime.
+	*/
+	bool TryGetDateTimeField(const FString& FieldName, FDateTime& OutDateTime) const;
+
+	/** Overload taking an already encoded FBsonKey. */
+	bool TryGetDateTimeField(const FBsonKey& Key, FDateTime& OutDateTime) const;
+
+	/**
+	* Finds the field with the specified name and returns it as an FBsonObjectId.
+	*
+	* Assumes that the field is present and is of type ObjectId.
+	*
+	* @param FieldName The name of the field to get.
+	* @return The field's value as an FBsonObjectId.
+	*/
+	FBsonObjectId GetObjectIdField(const FString& FieldName) const;
+
+	/** Overload taking an already encoded FBsonKey. */
+	FBsonObjectId GetObjectIdField(const FBsonKey& Key) const;
+
+	/**
+	* Tries to find the field with the specified name and return it as an FBsonObjectId.
+	*
+	* @param FieldName The name of the field to get.
+	* @param OutId A reference for the output to go in.
+	* @return false if FieldName doesn't exist or is not an ObjectId.
+	*/
+	bool TryGetObjectIdField(const FString& FieldName, FBsonObjectId& OutId) const;
+
+	/** Overload taking an already encoded FBsonKey. */
+	bool TryGetObjectIdField(const FBsonKey& Key, FBsonObjectId& OutId) const;
+
+	/**
+	* Tries to find the field with the specified name and copy the payload of the binary.
+	*
+	* @param FieldName The name of the field to get.
+	* @param OutBinary A reference for the output to go in.
+	* @return false if FieldName doesn't exist or is not a binary.
+	*/
+	bool TryGetBinaryField(const FString& FieldName, TArray<uint8>& OutBinary) const;
+
+	/** Overload taking an already encoded FBsonKey. */
+	bool TryGetBinaryField(const FBsonKey& Key, TArray<uint8>& OutBinary) const;
+
 	/**
 	* Finds the field with the specified name and returns it as an FString.
 	*
@@ -141,6 +459,9 @@ public:
 	*/
 	FString GetStringField(const FString& FieldName) const;
 
+	/** Overload taking an already encoded FBsonKey. */
+	FString GetStringField(const FBsonKey& Key) const;
+
 	/**
 	* Tries to find the field with the specified name and return it as a string.
 	*
@@ -150,6 +471,9 @@ public:
 	*/
 	bool TryGetStringField(const FString& FieldName, FString& OutString) const;
 
+	/** Overload taking an already encoded FBsonKey. */
+	bool TryGetStringField(const FBsonKey& Key, FString& OutString) const;
+
 	/**
 	* Tries to find the field with the specified name and return it as an array of FStrings.
 	*
@@ -159,6 +483,9 @@ public:
 	*/
 	bool TryGetStringArrayField(const FString& FieldName, TArray<FString>& OutArray) const;
 
+	/** Overload taking an already encoded FBsonKey. */
+	bool TryGetStringArrayField(const FBsonKey& Key, TArray<FString>& OutArray) const;
+
 	/**
 	* Finds the field with the specified name and returns it as a boolean.
 	*
@@ -169,6 +496,9 @@ public:
 	*/
 	bool GetBoolField(const FString& FieldName) const;
 
+	/** Overload taking an already encoded FBsonKey. */
+	bool GetBoolField(const FBsonKey& Key) const;
+
 	/**
 	* Tries to find the field with the specified name and return it as a boolean.
 	*
@@ -178,6 +508,9 @@ public:
 	*/
 	bool TryGetBoolField(const FString& FieldName, bool& OutBool) const;
 
+	/** Overload taking an already encoded FBsonKey. */
+	bool TryGetBoolField(const FBsonKey& Key, bool& OutBool) const;
+
 	/**
 	* Finds the field with the specified name and returns it as a TArray< TSharedPtr<FBsonValue> >.
 	*
@@ -188,6 +521,9 @@ public:
 	*/
 	const TArray<TSharedPtr<FBsonValue>> GetArrayField(const FString& FieldName) const;
 
+	/** Overload taking an already encoded FBsonKey. */
+	const TArray<TSharedPtr<FBsonValue>> GetArrayField(const FBsonKey& Key) const;
+
 	/**
 	* Tries to find the field with the specified name and return it as a TArray< TSharedPtr<FBsonValue> >.
 	*
@@ -197,16 +533,81 @@ public:
 	*/
 	bool TryGetArrayField(const FString& FieldName, TArray<TSharedPtr<FBsonValue>>& OutArray) const;
 
+	/** Overload taking an already encoded FBsonKey. */
+	bool TryGetArrayField(const FBsonKey& Key, TArray<TSharedPtr<FBsonValue>>& OutArray) const;
+
+	/**
+	* Tries to find the array field with the specified name and decode it into FBsonVariants.
+	*
+	* All elements end up in the single allocation of OutArray, no FBsonValue is created per element.
+	*
+	* @param FieldName The name of the field to get.
+	* @param OutArray the array to reset and fill.
+	* @return false if FieldName doesn't exist or isn't an array.
+	*/
+	bool TryGetArrayField(const FString& FieldName, TArray<FBsonVariant>& OutArray) const;
+
+	/** Overload taking an already encoded FBsonKey. */
+	bool TryGetArrayField(const FBsonKey& Key, TArray<FBsonVariant>& OutArray) const;
+
+	/**
+	* Tries to find the array field with the specified name and decode all its elements as numbers.
+	*
+	* The elements are converted directly into OutArray, no FBsonValue is created per element.
+	* OutArray is reset first but keeps its allocation, so it can be reused for repeated reads.
+	* Packed arrays (see SetPackedArrayField()) of the same element type are read as well.
+	* Integers are read exactly into the integer variants, doubles are rounded.
+	*
+	* @param FieldName The name of the field to get.
+	* @param OutArray A reference for the output to go in.
+	* @return false if FieldName doesn't exist, isn't an array or any of its elements cannot be converted.
+	*/
+	bool TryGetNumberArrayField(const FString& FieldName, TArray<double>& OutArray) const;
+	bool TryGetNumberArrayField(const FString& FieldName, TArray<float>& OutArray) const;
+	bool TryGetNumberArrayField(const FString& FieldName, TArray<int32>& OutArray) const;
+	bool TryGetNumberArrayField(const FString& FieldName, TArray<int64>& OutArray) const;
+
+	/** Overloads taking an already encoded FBsonKey. */
+	bool TryGetNumberArrayField(const FBsonKey& Key, TArray<double>& OutArray) const;
+	bool TryGetNumberArrayField(const FBsonKey& Key, TArray<float>& OutArray) const;
+	bool TryGetNumberArrayField(const FBsonKey& Key, TArray<int32>& OutArray) const;
+	bool TryGetNumberArrayField(const FBsonKey& Key, TArray<int64>& OutArray) const;
+
+	/**
+	* Tries to find a packed array field written by SetPackedArrayField() and view its elements in place.
+	*
+	* The view points into this object's buffer and is only valid as long as the object is alive and unmodified.
+	* Fails if the elements aren't aligned for direct access, which can happen when the document was embedded
+	* into another one. TryGetNumberArrayField() copies the elements regardless of their alignment.
+	*
+	* @param FieldName The name of the field to get.
+	* @param OutView A reference for the view to go in.
+	* @return false if FieldName doesn't exist, isn't a packed array of that element type or isn't aligned.
+	*/
+	bool TryGetPackedArrayView(const FString& FieldName, TArrayView<const float>& OutView) const;
+	bool TryGetPackedArrayView(const FString& FieldName, TArrayView<const double>& OutView) const;
+	bool TryGetPackedArrayView(const FString& FieldName, TArrayView<const uint8>& OutView) const;
+
+	/** Overloads taking an already encoded FBsonKey. */
+	bool TryGetPackedArrayView(const FBsonKey& Key, TArrayView<const float>& OutView) const;
+	bool TryGetPackedArrayView(const FBsonKey& Key, TArrayView<const double>& OutView) const;
+	bool TryGetPackedArrayView(const FBsonKey& Key, TArrayView<const uint8>& OutView) const;
+
 	/**
 	* Finds the field with the specified name and returns it as a TSharedPtr<FBsonObject>.
 	*
 	* Assumes that the field is present and is of type object.
+	* The returned object doesn't copy the subdocument but shares this object's buffer, see the copy constructor.
+	* It is copied on the first write to either of them.
 	*
 	* @param FieldName The name of the field to get.
 	* @return The field's value as a TSharedPtr<FBsonObject>.
 	*/
 	const TSharedPtr<FBsonObject> GetObjectField(const FString& FieldName) const;
 
+	/** Overload taking an already encoded FBsonKey. */
+	const TSharedPtr<FBsonObject> GetObjectField(const FBsonKey& Key) const;
+
 	/** 
 	* Adds a field, automatically determines the type of the field to set from the given FBsonValue. 
 	* 
@@ -215,6 +616,9 @@ public:
 	*/
 	void SetField(const FString &FieldName, const TSharedPtr<FBsonValue> &Value);
 
+	/** Overload taking an already encoded FBsonKey. */
+	void SetField(const FBsonKey& Key, const TSharedPtr<FBsonValue> &Value);
+
 	/**
 	* Adds a field of type double (number).
 	*
@@ -223,6 +627,86 @@ public:
 	*/
 	void SetNumberField(const FString &FieldName, double Number);
 
+	/** Overload taking an already encoded FBsonKey. */
+	void SetNumberField(const FBsonKey& Key, double Number);
+
+	/**
+	* Adds a field of type int32.
+	*
+	* @param FieldName The name to be given to the field (key).
+	* @param Number The desired value of the field (value).
+	*/
+	void SetInt32Field(const FString &FieldName, int32 Number);
+
+	/** Overload taking an already encoded FBsonKey. */
+	void SetInt32Field(const FBsonKey& Key, int32 Number);
+
+	/**
+	* Adds a field of type int64.
+	*
+	* @param FieldName The name to be given to the field (key).
+	* @param Number The desired value of the field (value).
+	*/
+	void SetInt64Field(const FString &FieldName, int64 Number);
+
+	/** Overload taking an already encoded FBsonKey. */
+	void SetInt64Field(const FBsonKey& Key, int64 Number);
+
+	/**
+	* Adds a field of type DateTime, stored with millisecond precision.
+	*
+	* @param FieldName The name to be given to the field (key).
+	* @param DateTime The desired value of the field (value), in UTC.
+	*/
+	void SetDateTimeField(const FString &FieldName, const FDateTime &DateTime);
+
+	/** Overload taking an already encoded FBsonKey. */
+	void SetDateTimeField(const FBsonKey& Key, const FDateTime &DateTime);
+
+	/**
+	* Adds a field of type ObjectId.
+	*
+	* @param FieldName The name to be given to the field (key).
+	* @param Id The desired value of the field (value).
+	*/
+	void SetObjectIdField(const FString &FieldName, const FBsonObjectId &Id);
+
+	/** Overload taking an already encoded FBsonKey. */
+	void SetObjectIdField(const FBsonKey& Key, const FBsonObjectId &Id);
+
+	/**
+	* Adds a field of type binary.
+	*
+	* @param FieldName The name to be given to the field (key).
+	* @param Binary The desired payload of the field (value).
+	* @param Subtype The bson_subtype_t of the binary, generic binary data by default.
+	*/
+	void SetBinaryField(const FString &FieldName, TArrayView<const uint8> Binary, uint8 Subtype = 0);
+
+	/** Overload taking an already encoded FBsonKey. */
+	void SetBinaryField(const FBsonKey& Key, TArrayView<const uint8> Binary, uint8 Subtype = 0);
+
+	/**
+	* Adds a field of type Decimal128. Read it back with GetStringField() to keep all digits.
+	*
+	* @param FieldName The name to be given to the field (key).
+	* @param Decimal The desired value of the field (value) as a decimal string, e.g. "12.345E-2".
+	*/
+	void SetDecimal128Field(const FString &FieldName, const FString &Decimal);
+
+	/** Overload taking an already encoded FBsonKey. */
+	void SetDecimal128Field(const FBsonKey& Key, const FString &Decimal);
+
+	/**
+	* Adds a field of type null.
+	*
+	* @param FieldName The name to be given to the field (key).
+	*/
+	void SetNullField(const FString &FieldName);
+
+	/** Overload taking an already encoded FBsonKey. */
+	void SetNullField(const FBsonKey& Key);
+
 	/**
 	* Adds a field of type string.
 	*
@@ -231,6 +715,9 @@ public:
 	*/
 	void SetStringField(const FString &FieldName, const FString &StringValue);
 
+	/** Overload taking an already encoded FBsonKey. */
+	void SetStringField(const FBsonKey& Key, const FString &StringValue);
+
 	/**
 	* Adds a field of type boolean.
 	*
@@ -239,6 +726,9 @@ public:
 	*/
 	void SetBoolField(const FString &FieldName, bool Bool);
 
+	/** Overload taking an already encoded FBsonKey. */
+	void SetBoolField(const FBsonKey& Key, bool Bool);
+
 	/**
 	* Adds a field of type Array.
 	*
@@ -247,6 +737,68 @@ public:
 	*/
 	void SetArrayField(const FString &FieldName, const TArray<TSharedPtr<FBsonValue> > &Array);
 
+	/** Overload taking an already encoded FBsonKey. */
+	void SetArrayField(const FBsonKey& Key, const TArray<TSharedPtr<FBsonValue> > &Array);
+
+	/**
+	* Adds a field of type Array from FBsonVariants.
+	*
+	* @param FieldName The name to be given to the field (key).
+	* @param Values The elements of the array.
+	*/
+	void SetArrayField(const FString &FieldName, TArrayView<const FBsonVariant> Values);
+
+	/** Overload taking an already encoded FBsonKey. */
+	void SetArrayField(const FBsonKey& Key, TArrayView<const FBsonVariant> Values);
+
+	/**
+	* Adds a field of type Array containing the given numbers as doubles.
+	*
+	* Much cheaper than SetArrayField() for numeric data, no FBsonValue is created per element.
+	*
+	* @param FieldName The name to be given to the field (key).
+	* @param Numbers The desired elements of the array.
+	*/
+	void SetNumberArrayField(const FString &FieldName, TArrayView<const double> Numbers);
+	void SetNumberArrayField(const FString &FieldName, TArrayView<const float> Numbers);
+
+	/** Overloads taking an already encoded FBsonKey. */
+	void SetNumberArrayField(const FBsonKey& Key, TArrayView<const double> Numbers);
+	void SetNumberArrayField(const FBsonKey& Key, TArrayView<const float> Numbers);
+
+	/**
+	* Adds a field of type Array containing the given integers, stored as Bson int32 or int64 respectively.
+	*
+	* @param FieldName The name to be given to the field (key).
+	* @param Numbers The desired elements of the array.
+	*/
+	void SetNumberArrayField(const FString &FieldName, TArrayView<const int32> Numbers);
+	void SetNumberArrayField(const FString &FieldName, TArrayView<const int64> Numbers);
+
+	/** Overloads taking an already encoded FBsonKey. */
+	void SetNumberArrayField(const FBsonKey& Key, TArrayView<const int32> Numbers);
+	void SetNumberArrayField(const FBsonKey& Key, TArrayView<const int64> Numbers);
+
+	/**
+	* Adds a binary field holding the raw bytes of the given elements behind a small typed header.
+	*
+	* Meant for large homogeneous arrays like depth images or point clouds: compared to a Bson array
+	* there are no per-element keys and type tags, and the elements can be read back in place with
+	* TryGetPackedArrayView() or copied as a whole with TryGetNumberArrayField().
+	* Other Bson readers see a binary of a user defined subtype, not an array.
+	*
+	* @param FieldName The name to be given to the field (key).
+	* @param Elements The desired elements of the array.
+	*/
+	void SetPackedArrayField(const FString &FieldName, TArrayView<const float> Elements);
+	void SetPackedArrayField(const FString &FieldName, TArrayView<const double> Elements);
+	void SetPackedArrayField(const FString &FieldName, TArrayView<const uint8> Elements);
+
+	/** Overloads taking an already encoded FBsonKey. */
+	void SetPackedArrayField(const FBsonKey& Key, TArrayView<const float> Elements);
+	void SetPackedArrayField(const FBsonKey& Key, TArrayView<const double> Elements);
+	void SetPackedArrayField(const FBsonKey& Key, TArrayView<const uint8> Elements);
+
 	/**
 	* Adds a field of type double.
 	*
@@ -255,16 +807,33 @@ public:
 	*/
 	void SetObjectField(const FString &FieldName, const TSharedPtr<FBsonObject> &Object);
 
+	/** Overload taking an already encoded FBsonKey. */
+	void SetObjectField(const FBsonKey& Key, const TSharedPtr<FBsonObject> &Object);
+
 	/** 
-	* Removes the given field.
+	* Removes the given field, including all duplicates of it.
 	*
-	* WARNING: INEFFICIENT!
+	* The fields behind it are moved down within the buffer, nothing is reallocated.
 	*
 	* @param FieldName The name of the field to remove.
 	* @return true if the field was successfully removed.
 	*/
 	bool RemoveField(const FString& FieldName);
 
+	/** Overload taking an already encoded FBsonKey. */
+	bool RemoveField(const FBsonKey& Key);
+
+	/**
+	* Removes all the given fields in a single pass over the document.
+	*
+	* @param FieldNames The names of the fields to remove.
+	* @return the number of removed fields.
+	*/
+	int32 RemoveFields(TArrayView<const FString> FieldNames);
+
+	/** Overload taking a prepared FBsonFieldSet, which avoids converting the names on every call. */
+	int32 RemoveFields(const FBsonFieldSet& Fields);
+
 
 
 	
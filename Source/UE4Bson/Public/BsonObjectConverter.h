@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BsonObject.h"
+
+class UStruct;
+struct FBsonStructPlan;
+struct FBsonPropertyPlan;
+
+typedef TSharedPtr<const FBsonStructPlan, ESPMode::ThreadSafe> FBsonStructPlanPtr;
+typedef TSharedRef<const FBsonStructPlan, ESPMode::ThreadSafe> FBsonStructPlanRef;
+
+/**
+* \brief Converts UStructs to and from Bson, the counterpart of FJsonObjectConverter.
+*
+* Field names are the standardized property names FJsonObjectConverter uses. The first conversion of a
+* UStruct (with a given set of flags) builds a plan holding the offset, encoded key and type of every
+* property. All later conversions only walk that plan, without FString keys and without FBsonValues.
+*
+* Integers are written as int32 or int64, floats as doubles, enums by name, FDateTime as a Bson DateTime
+* and nested structs as objects. Property types without a Bson counterpart (maps, sets, object references)
+* are written as their exported text.
+*/
+class UE4BSON_API FBsonObjectConverter
+{
+public:
+
+	/**
+	* Converts a UStruct into a Bson document, replacing the previous contents of OutBsonObject.
+	*
+	* Reusing the same OutBsonObject keeps its buffer, see FBsonObject::Reset().
+	*
+	* @param StructDefinition the UStruct definition that is looked over for properties.
+	* @param Struct the pointer to the instance of the struct.
+	* @param OutBsonObject the document to write the properties into.
+	* @param CheckFlags only convert properties that match at least one of these flags. If 0 check all properties.
+	* @param SkipFlags skip properties that match any of these flags.
+	* @return false if the struct does not fit into a Bson document, OutBsonObject is left empty then.
+	*/
+	static bool UStructToBsonObject(const UStruct* StructDefinition, const void* Struct, FBsonObject& OutBsonObject, int64 CheckFlags = 0, int64 SkipFlags = 0);
+
+	/**
+	* Templated version of UStructToBsonObject to try and make most of the params.
+	*
+	* @param InStruct the struct to read from.
+	* @param CheckFlags only convert properties that match at least one of these flags. If 0 check all properties.
+	* @param SkipFlags skip properties that match any of these flags.
+	* @return the converted document, invalid if any properties failed to write.
+	*/
+	template<typename InStructType>
+	static TSharedPtr<FBsonObject> UStructToBsonObject(const InStructType& InStruct, int64 CheckFlags = 0, int64 SkipFlags = 0)
+	{
+		TSharedPtr<FBsonObject> BsonObject = MakeShareable(new FBsonObject());
+		if (!UStructToBsonObject(InStructType::StaticStruct(), &InStruct, *BsonObject, CheckFlags, SkipFlags))
+		{
+			return TSharedPtr<FBsonObject>();
+		}
+		return BsonObject;
+	}
+
+	/**
+	* Converts a Bson document into a UStruct. Fields without a matching property are ignored,
+	* properties without a matching field keep their value.
+	*
+	* @param BsonObject the document to read from.
+	* @param StructDefinition the UStruct definition that is looked over for properties.
+	* @param OutStruct the pointer to the instance of the struct.
+	* @param CheckFlags only convert properties that match at least one of these flags. If 0 check all properties.
+	* @param SkipFlags skip properties that match any of these flags.
+	* @return false if any field failed to convert.
+	*/
+	static bool BsonObjectToUStruct(const FBsonObject& BsonObject, const UStruct* StructDefinition, void* OutStruct, int64 CheckFlags = 0, int64 SkipFlags = 0);
+
+	/**
+	* Templated version of BsonObjectToUStruct.
+	*
+	* @param BsonObject the document to read from.
+	* @param OutStruct the struct to write into.
+	* @param CheckFlags only convert properties that match at least one of these flags. If 0 check all properties.
+	* @param SkipFlags skip properties that match any of these flags.
+	* @return false if any field failed to convert.
+	*/
+	template<typename OutStructType>
+	static bool BsonObjectToUStruct(const FBsonObject& BsonObject, OutStructType* OutStruct, int64 CheckFlags = 0, int64 SkipFlags = 0)
+	{
+		return BsonObjectToUStruct(BsonObject, OutStructType::StaticStruct(), OutStruct, CheckFlags, SkipFlags);
+	}
+
+	/**
+	* Drops all cached plans. Conversions running on other threads keep using the plans they started with,
+	* each plan is freed with the last conversion and the last plan of an enclosing struct referring to it.
+	* Plans of destroyed UStructs are rebuilt automatically, this is only needed to free their memory.
+	*/
+	static void ResetPlanCache();
+
+private:
+
+	/** @return the cached plan of a UStruct for the given flags, building it the first time. */
+	static FBsonStructPlanRef GetPlan(const UStruct* StructDefinition, int64 CheckFlags, int64 SkipFlags);
+
+	/** @return false if a value did not fit into the document. */
+	static bool EncodeStruct(const FBsonStructPlan& Plan, const void* Struct, struct _bson_t* Document);
+	static bool EncodeProperty(const FBsonPropertyPlan& Property, const void* Struct, struct _bson_t* Document);
+	static bool EncodeValue(const FBsonPropertyPlan& Property, const void* Value, struct _bson_t* Parent, const ANSICHAR* Key, int32 KeyLength);
+
+	static bool DecodeStruct(const FBsonStructPlan& Plan, const uint8* Data, uint32 Length, void* OutStruct);
+	static bool DecodeProperty(const FBsonPropertyPlan& Property, const FBsonValueView& View, void* OutStruct);
+	static bool DecodeValue(const FBsonPropertyPlan& Property, const FBsonValueView& View, void* OutValue);
+};
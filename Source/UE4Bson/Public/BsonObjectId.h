@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* \brief The 12 byte ObjectId of Bson (see http://mongoc.org/libbson/current/bson_oid_t.html).
+*/
+struct UE4BSON_API FBsonObjectId
+{
+	uint8 Bytes[12];
+
+	/**
+	* Constructor that creates an ObjectId of all zeros.
+	*/
+	FBsonObjectId()
+	{
+		FMemory::Memzero(Bytes, sizeof(Bytes));
+	}
+
+	/**
+	* Creates an ObjectId from its raw bytes.
+	*
+	* @param InBytes the 12 bytes of the ObjectId.
+	*/
+	explicit FBsonObjectId(const uint8* InBytes)
+	{
+		FMemory::Memcpy(Bytes, InBytes, sizeof(Bytes));
+	}
+
+	/**
+	* @return a new unique ObjectId.
+	*/
+	static FBsonObjectId Generate();
+
+	/**
+	* Parses the 24 character hexadecimal representation of an ObjectId.
+	*
+	* @param String the hexadecimal string.
+	* @param OutId a reference to write the parsed ObjectId into.
+	* @return false if String isn't a valid ObjectId.
+	*/
+	static bool FromString(const FString& String, FBsonObjectId& OutId);
+
+	/** @return the 24 character lowercase hexadecimal representation. */
+	FString ToString() const;
+
+	bool operator==(const FBsonObjectId& Other) const
+	{
+		return FMemory::Memcmp(Bytes, Other.Bytes, sizeof(Bytes)) == 0;
+	}
+
+	bool operator!=(const FBsonObjectId& Other) const
+	{
+		return !(*this == Other);
+	}
+
+	friend uint32 GetTypeHash(const FBsonObjectId& Id)
+	{
+		// the last bytes are a counter and vary the most
+		uint32 Hash;
+		FMemory::Memcpy(&Hash, Id.Bytes + 8, sizeof(Hash));
+		return Hash;
+	}
+};
@@ -0,0 +1,186 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "HAL/ThreadSafeBool.h"
+#include "BsonFileReader.h"
+#include "BsonCompressedFileReader.h"
+
+/**
+* How ParallelReduceDocuments() combines the states of the chunks.
+*/
+enum class EBsonReduceOrder : uint8
+{
+	/** Combine the chunk states in file order once all chunks are done, the result is deterministic. */
+	Ordered,
+	/** Combine every chunk state as soon as its chunk is done, holding fewer states at a time. */
+	Unordered
+};
+
+
+/** @return the default number of chunks a dump is split into: a few per task graph worker, to even out the load. */
+inline int32 GetBsonScanNumChunks()
+{
+	return (FTaskGraphInterface::Get().GetNumWorkerThreads() + 1) * 4;
+}
+
+
+/**
+* Runs ForEachInChunk(ChunkIndex, Callback), which calls Callback for every document of a chunk, for all
+* chunks on the task graph. The shared part of the ParallelForEachDocument() overloads.
+*/
+template<typename ForEachInChunkType, typename FunctionType>
+bool ParallelForEachChunkDocument(int32 NumChunks, ForEachInChunkType ForEachInChunk, FunctionType& Function)
+{
+	FThreadSafeBool bCorrupt;
+
+	ParallelFor(NumChunks, [&](int32 ChunkIndex)
+	{
+		if (!ForEachInChunk(ChunkIndex, Function))
+		{
+			bCorrupt = true;
+		}
+	});
+
+	return !bCorrupt;
+}
+
+
+/**
+* Accumulates the documents of every chunk into a state of its own and reduces those into InOutState.
+* The shared part of the ParallelReduceDocuments() overloads.
+*/
+template<typename ForEachInChunkType, typename StateType, typename FunctionType, typename ReduceType>
+bool ParallelReduceChunkDocuments(int32 NumChunks, ForEachInChunkType ForEachInChunk, StateType& InOutState, FunctionType& Function, ReduceType& Reduce, EBsonReduceOrder Order)
+{
+	FThreadSafeBool bCorrupt;
+
+	if (Order == EBsonReduceOrder::Ordered)
+	{
+		TArray<StateType> ChunkStates;
+		ChunkStates.SetNum(NumChunks);
+
+		ParallelFor(NumChunks, [&](int32 ChunkIndex)
+		{
+			StateType& State = ChunkStates[ChunkIndex];
+			if (!ForEachInChunk(ChunkIndex, [&](const FBsonObject& Document) { Function(State, Document); }))
+			{
+				bCorrupt = true;
+			}
+		});
+
+		for (StateType& State : ChunkStates)
+		{
+			Reduce(InOutState, State);
+		}
+	}
+	else
+	{
+		FCriticalSection ReduceLock;
+
+		ParallelFor(NumChunks, [&](int32 ChunkIndex)
+		{
+			StateType State{};
+			if (!ForEachInChunk(ChunkIndex, [&](const FBsonObject& Document) { Function(State, Document); }))
+			{
+				bCorrupt = true;
+			}
+
+			FScopeLock Lock(&ReduceLock);
+			Reduce(InOutState, State);
+		});
+	}
+
+	return !bCorrupt;
+}
+
+
+/**
+* Calls Function(const FBsonObject& Document) for every document of a dump, on the task graph.
+*
+* The dump is split into chunks of whole documents (see FBsonFileReader::SplitIntoChunks(), load an index
+* first to avoid walking the length headers), which are processed by ParallelFor. The documents are read-only
+* views of the mapped file, reused from one document to the next. To keep a document, Function copies it
+* (FBsonObject Kept = Document;), which copies its bytes.
+* Function is called concurrently and in no particular order.
+*
+* @param Reader an open reader.
+* @param Function the function to call for every document.
+* @param NumChunks the number of chunks to split the dump into.
+* @return false if a corrupt document was found, the documents after it are skipped.
+*/
+template<typename FunctionType>
+bool ParallelForEachDocument(const FBsonFileReader& Reader, FunctionType Function, int32 NumChunks = GetBsonScanNumChunks())
+{
+	const TArray<FBsonFileChunk> Chunks = Reader.SplitIntoChunks(NumChunks);
+	return ParallelForEachChunkDocument(Chunks.Num(), [&](int32 ChunkIndex, auto&& Callback)
+	{
+		return Reader.ForEachDocument(Chunks[ChunkIndex], Callback);
+	}, Function);
+}
+
+
+/**
+* Calls Function(const FBsonObject& Document) for every document of a block-compressed file, on the task graph.
+*
+* Every block is decompressed and processed by its own task, see the overload for plain dumps. The documents
+* borrow the decompressed block, which is freed after its last document, copy a document to keep it.
+*
+* @param Reader an open reader.
+* @param Function the function to call for every document.
+* @return false if a corrupt block was found, the documents after it in the block are skipped.
+*/
+template<typename FunctionType>
+bool ParallelForEachDocument(const FBsonCompressedFileReader& Reader, FunctionType Function)
+{
+	return ParallelForEachChunkDocument(Reader.GetNumBlocks(), [&](int32 BlockIndex, auto&& Callback)
+	{
+		return Reader.ForEachDocumentInBlock(BlockIndex, Callback);
+	}, Function);
+}
+
+
+/**
+* Accumulates all documents of a dump into a state, on the task graph.
+*
+* Every chunk of the dump gets a value-initialized StateType (zero for scalars) that is only touched by the task processing
+* the chunk, Function(StateType& State, const FBsonObject& Document) accumulates into it without locking.
+* Reduce(StateType& InOutState, StateType& ChunkState) then merges the chunk states into InOutState, see
+* EBsonReduceOrder. Reduce is never called concurrently.
+*
+* @param Reader an open reader.
+* @param InOutState the state to merge all chunk states into.
+* @param Function the function to call for every document.
+* @param Reduce the function merging a chunk state into InOutState.
+* @param Order whether to merge the chunk states in file order.
+* @param NumChunks the number of chunks to split the dump into.
+* @return false if a corrupt document was found, the documents after it are skipped.
+*/
+template<typename StateType, typename FunctionType, typename ReduceType>
+bool ParallelReduceDocuments(const FBsonFileReader& Reader, StateType& InOutState, FunctionType Function, ReduceType Reduce,
+	EBsonReduceOrder Order = EBsonReduceOrder::Ordered, int32 NumChunks = GetBsonScanNumChunks())
+{
+	const TArray<FBsonFileChunk> Chunks = Reader.SplitIntoChunks(NumChunks);
+	return ParallelReduceChunkDocuments(Chunks.Num(), [&](int32 ChunkIndex, auto&& Callback)
+	{
+		return Reader.ForEachDocument(Chunks[ChunkIndex], Callback);
+	}, InOutState, Function, Reduce, Order);
+}
+
+
+/**
+* Accumulates all documents of a block-compressed file into a state, on the task graph, with a state
+* per block. See the overload for plain dumps.
+*/
+template<typename StateType, typename FunctionType, typename ReduceType>
+bool ParallelReduceDocuments(const FBsonCompressedFileReader& Reader, StateType& InOutState, FunctionType Function, ReduceType Reduce,
+	EBsonReduceOrder Order = EBsonReduceOrder::Ordered)
+{
+	return ParallelReduceChunkDocuments(Reader.GetNumBlocks(), [&](int32 BlockIndex, auto&& Callback)
+	{
+		return Reader.ForEachDocumentInBlock(BlockIndex, Callback);
+	}, InOutState, Function, Reduce, Order);
+}
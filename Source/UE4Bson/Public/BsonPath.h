@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BsonKey.h"
+
+/**
+* \brief A precompiled path to a nested field of an FBsonObject.
+*
+* A path like "pose.location.x" or "joints[3].position" is parsed once into hashed UTF-8 keys,
+* which can then be used to descend into any number of documents without further conversions.
+* Array elements are addressed by their index, either as "joints[3]" or as "joints.3".
+* Keys containing '.', '[' or ']' can't be addressed by a path.
+*/
+class UE4BSON_API FBsonPath
+{
+public:
+
+	/**
+	* Constructor that creates an empty path.
+	*/
+	FBsonPath() {}
+
+	/**
+	* Parses a dotted path.
+	*
+	* @param Path the path to parse, e.g. "pose.location.x" or "joints[3].position".
+	*/
+	explicit FBsonPath(const FString& Path);
+
+	/** @return the number of keys in this path. */
+	int32 Num() const { return SegmentStarts.Num(); }
+
+	/** @return true if this path contains no keys. */
+	bool IsEmpty() const { return SegmentStarts.Num() == 0; }
+
+	/**
+	* @param Index the index of the key within the path.
+	* @return the key at the given position, valid as long as this path is alive and unchanged.
+	*/
+	FBsonKey GetSegment(int32 Index) const
+	{
+		return FBsonKey(Utf8Keys.GetData() + SegmentStarts[Index], SegmentLengths[Index], SegmentHashes[Index]);
+	}
+
+private:
+
+	/** All keys of the path, each followed by a terminating zero. */
+	TArray<ANSICHAR> Utf8Keys;
+
+	TArray<int32> SegmentStarts;
+	TArray<int32> SegmentLengths;
+	TArray<uint32> SegmentHashes;
+};
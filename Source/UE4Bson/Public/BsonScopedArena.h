@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* \brief Bump-allocates the memory libbson requests on the current thread while it is in scope.
+*
+* Outside of an arena, libbson allocates through FMemory. While an arena is alive, the buffers of
+* documents created on its thread inside the scope are carved out of a few large blocks instead,
+* freeing is a no-op, and all blocks are released together when the arena is destroyed. This is meant
+* for documents that are built and thrown away within a frame or tick.
+*
+* Every document created inside the scope must therefore be destroyed before the arena. Documents
+* created before keep allocating where they did, also when they outgrow their inline storage or are
+* copied on their first write inside the scope. Only the first write to such a small document costs
+* an FMemory allocation it might not have needed otherwise.
+*
+* Arenas can be nested, the innermost one of the thread is used.
+*/
+class UE4BSON_API FBsonScopedArena
+{
+public:
+
+	/**
+	* Makes this the arena libbson allocates from on the calling thread.
+	*
+	* @param InBlockSize the size of the blocks requested from FMemory. Larger allocations get a block of their own.
+	*/
+	explicit FBsonScopedArena(uint32 InBlockSize = 64 * 1024);
+
+	/**
+	* Restores the previous arena of the thread and frees all memory allocated from this one.
+	*/
+	~FBsonScopedArena();
+
+	FBsonScopedArena(const FBsonScopedArena&) = delete;
+	FBsonScopedArena& operator=(const FBsonScopedArena&) = delete;
+
+	/** @return the number of bytes handed out by this arena so far. */
+	SIZE_T GetAllocatedBytes() const { return AllocatedBytes; }
+
+	/** @return the arena libbson allocates from on the calling thread, nullptr if there is none. */
+	static FBsonScopedArena* GetCurrent();
+
+private:
+
+	friend struct FBsonMemory;
+
+	/**
+	* Returns 16-byte aligned memory that stays valid until the arena is destroyed.
+	*/
+	void* Allocate(SIZE_T Size);
+
+	/**
+	* Resizes the most recent allocation without moving it, if there is room left in its block.
+	*
+	* @return false if Memory was not the most recent allocation or the block is too small.
+	*/
+	bool TryResize(void* Memory, SIZE_T NewSize);
+
+	/** @return true if Arena is the current arena of the calling thread or one it is nested in. */
+	static bool IsActiveOnThisThread(const FBsonScopedArena* Arena);
+
+	FBsonScopedArena* Previous;
+	uint32 BlockSize;
+	TArray<uint8*> Blocks;
+	uint8* Cursor;
+	uint8* End;
+	uint8* LastAllocation;
+	SIZE_T AllocatedBytes;
+};
@@ -0,0 +1,433 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BsonObject.h"
+#include "BsonWriter.h"
+#include "BsonVariant.h"
+#include "BsonObjectId.h"
+
+/**
+* \brief Declares the fields of a plain C++ struct for FBsonTraitsSerializer.
+*
+* Specialize it for a struct and list every field once, with its key as a string literal.
+* The same function is used for sizing, encoding and decoding, so the serializer is generated
+* at compile time for the exact field types, without reflection and without FString keys.
+*
+* \code
+* template<>
+* struct TBsonTraits<FTelemetryRecord>
+* {
+*	template<typename VisitorType, typename RecordType>
+*	static void VisitFields(VisitorType& Visitor, RecordType& Record)
+*	{
+*		Visitor("id", Record.Id);
+*		Visitor("location", Record.Location);
+*		Visitor("samples", Record.Samples);
+*	}
+* };
+* \endcode
+*
+* Fields can be bool, int32, int64, float, double, FString, FDateTime, FBsonObjectId, any struct with
+* TBsonTraits (written as an object) and TArrays of all of these. Keys are lowercase like the ones
+* FBsonObjectConverter writes for the same struct.
+*/
+template<typename T>
+struct TBsonTraits;
+
+
+/**
+* \brief Size, encoding and decoding of a single field type, used by FBsonTraitsSerializer.
+*
+* The primary template handles structs with TBsonTraits, the specializations below all other supported types.
+*/
+template<typename T>
+struct TBsonFieldCodec
+{
+	static uint32 GetSizeBound(const T& Value);
+	static void Write(FBsonWriter& Writer, const FBsonKey* Key, const T& Value);
+	static bool Read(const FBsonValueView& View, T& OutValue);
+};
+
+
+/**
+* \brief Encodes and decodes structs described by TBsonTraits.
+*
+* The length of the document is computed before encoding: exactly for fixed-size fields, as an upper
+* bound for strings, so the document buffer is allocated at most once. Documents up to 120 bytes stay
+* in libbson's inline storage, so they only cost the allocation of the FBsonObject's implementation.
+*/
+struct FBsonTraitsSerializer
+{
+	/**
+	* @return the number of bytes the encoded document takes at most, the exact length if there are no strings.
+	*/
+	template<typename T>
+	static uint32 GetEncodedSizeBound(const T& Value)
+	{
+		FSizeVisitor Visitor;
+		TBsonTraits<T>::VisitFields(Visitor, Value);
+		return Visitor.Size;
+	}
+
+	/**
+	* Encodes a struct into a new document that is allocated with the right size upfront.
+	*/
+	template<typename T>
+	static FBsonObject Encode(const T& Value)
+	{
+		FBsonObject Object(GetEncodedSizeBound(Value));
+		{
+			FBsonWriter Writer(Object);
+			FWriteVisitor Visitor(Writer);
+			TBsonTraits<T>::VisitFields(Visitor, Value);
+		}
+		return Object;
+	}
+
+	/**
+	* Encodes a struct into an existing document, replacing its contents and keeping its buffer.
+	*/
+	template<typename T>
+	static void Encode(const T& Value, FBsonObject& OutObject)
+	{
+		OutObject.Reset();
+		FBsonWriter Writer(OutObject);
+		FWriteVisitor Visitor(Writer);
+		TBsonTraits<T>::VisitFields(Visitor, Value);
+	}
+
+	/**
+	* Decodes a document into a struct. Missing fields keep their value.
+	*
+	* @return false if a field has a type that can't be converted to the type of the member.
+	*/
+	template<typename T>
+	static bool Decode(const FBsonObject& Object, T& OutValue)
+	{
+		FReadVisitor Visitor(Object);
+		TBsonTraits<T>::VisitFields(Visitor, OutValue);
+		return Visitor.bSuccess;
+	}
+
+	/** @return the encoded size of an element with the given key length and value size. */
+	static constexpr uint32 GetElementSize(int32 KeyLength, uint32 ValueSize)
+	{
+		// type, key, terminating zero, value
+		return 1 + KeyLength + 1 + ValueSize;
+	}
+
+	/** @return the number of digits of an array index, the length of its key. */
+	static uint32 GetIndexKeyLength(int32 Index)
+	{
+		uint32 Length = 1;
+		for (; Index >= 10; Index /= 10)
+		{
+			Length++;
+		}
+		return Length;
+	}
+
+private:
+
+	template<typename> friend struct TBsonFieldCodec;
+
+	struct FSizeVisitor
+	{
+		/** Starts with the length header and the terminating zero of the document. */
+		uint32 Size = 5;
+
+		template<int32 N, typename FieldType>
+		void operator()(const ANSICHAR (&Key)[N], const FieldType& Value)
+		{
+			Size += GetElementSize(N - 1, TBsonFieldCodec<FieldType>::GetSizeBound(Value));
+		}
+	};
+
+	struct FWriteVisitor
+	{
+		FBsonWriter& Writer;
+
+		explicit FWriteVisitor(FBsonWriter& InWriter) : Writer(InWriter) {}
+
+		template<int32 N, typename FieldType>
+		void operator()(const ANSICHAR (&Key)[N], const FieldType& Value)
+		{
+			const FBsonKey FieldKey(Key);
+			TBsonFieldCodec<FieldType>::Write(Writer, &FieldKey, Value);
+		}
+	};
+
+	struct FReadVisitor
+	{
+		const FBsonObject& Object;
+		bool bSuccess = true;
+
+		explicit FReadVisitor(const FBsonObject& InObject) : Object(InObject) {}
+
+		template<int32 N, typename FieldType>
+		void operator()(const ANSICHAR (&Key)[N], FieldType& OutValue)
+		{
+			FBsonValueView View;
+			if (bSuccess && Object.TryGetFieldView(FBsonKey(Key), View) && !View.IsNull())
+			{
+				bSuccess = TBsonFieldCodec<FieldType>::Read(View, OutValue);
+			}
+		}
+	};
+};
+
+
+template<typename T>
+uint32 TBsonFieldCodec<T>::GetSizeBound(const T& Value)
+{
+	return FBsonTraitsSerializer::GetEncodedSizeBound(Value);
+}
+
+template<typename T>
+void TBsonFieldCodec<T>::Write(FBsonWriter& Writer, const FBsonKey* Key, const T& Value)
+{
+	if (Key)
+	{
+		Writer.BeginObject(*Key);
+	}
+	else
+	{
+		Writer.BeginObject();
+	}
+	FBsonTraitsSerializer::FWriteVisitor Visitor(Writer);
+	TBsonTraits<T>::VisitFields(Visitor, Value);
+	Writer.EndObject();
+}
+
+template<typename T>
+bool TBsonFieldCodec<T>::Read(const FBsonValueView& View, T& OutValue)
+{
+	if (View.Type != EBson::Object)
+	{
+		return false;
+	}
+	TArrayView<const uint8> Bytes = View.AsDocumentView();
+	return FBsonTraitsSerializer::Decode(FBsonObject::Borrow(Bytes.GetData(), Bytes.Num()), OutValue);
+}
+
+
+template<>
+struct TBsonFieldCodec<bool>
+{
+	static uint32 GetSizeBound(bool Value) { return 1; }
+	static void Write(FBsonWriter& Writer, const FBsonKey* Key, bool Value) { Key ? Writer.WriteBool(*Key, Value) : Writer.WriteBool(Value); }
+	static bool Read(const FBsonValueView& View, bool& OutValue) { return View.TryGetBool(OutValue); }
+};
+
+template<>
+struct TBsonFieldCodec<int32>
+{
+	static uint32 GetSizeBound(int32 Value) { return 4; }
+	static void Write(FBsonWriter& Writer, const FBsonKey* Key, int32 Value) { Key ? Writer.WriteInt32(*Key, Value) : Writer.WriteInt32(Value); }
+	static bool Read(const FBsonValueView& View, int32& OutValue) { return View.TryGetNumber(OutValue); }
+};
+
+template<>
+struct TBsonFieldCodec<int64>
+{
+	static uint32 GetSizeBound(int64 Value) { return 8; }
+	static void Write(FBsonWriter& Writer, const FBsonKey* Key, int64 Value) { Key ? Writer.WriteInt64(*Key, Value) : Writer.WriteInt64(Value); }
+	static bool Read(const FBsonValueView& View, int64& OutValue) { return View.TryGetNumber(OutValue); }
+};
+
+template<>
+struct TBsonFieldCodec<double>
+{
+	static uint32 GetSizeBound(double Value) { return 8; }
+	static void Write(FBsonWriter& Writer, const FBsonKey* Key, double Value) { Key ? Writer.WriteNumber(*Key, Value) : Writer.WriteNumber(Value); }
+	static bool Read(const FBsonValueView& View, double& OutValue) { return View.TryGetNumber(OutValue); }
+};
+
+template<>
+struct TBsonFieldCodec<float>
+{
+	static uint32 GetSizeBound(float Value) { return 8; }
+	static void Write(FBsonWriter& Writer, const FBsonKey* Key, float Value) { TBsonFieldCodec<double>::Write(Writer, Key, Value); }
+
+	static bool Read(const FBsonValueView& View, float& OutValue)
+	{
+		double Number;
+		if (!View.TryGetNumber(Number))
+		{
+			return false;
+		}
+		OutValue = (float)Number;
+		return true;
+	}
+};
+
+template<>
+struct TBsonFieldCodec<FString>
+{
+	/** Length header, at most three UTF-8 bytes per UTF-16 code unit, terminating zero. */
+	static uint32 GetSizeBound(const FString& Value) { return 4 + Value.Len() * 3 + 1; }
+	static void Write(FBsonWriter& Writer, const FBsonKey* Key, const FString& Value) { Key ? Writer.WriteString(*Key, Value) : Writer.WriteString(Value); }
+
+	static bool Read(const FBsonValueView& View, FString& OutValue)
+	{
+		if (View.Type != EBson::String)
+		{
+			return false;
+		}
+		OutValue = View.AsString();
+		return true;
+	}
+};
+
+template<>
+struct TBsonFieldCodec<FDateTime>
+{
+	static uint32 GetSizeBound(const FDateTime& Value) { return 8; }
+	static void Write(FBsonWriter& Writer, const FBsonKey* Key, const FDateTime& Value) { Key ? Writer.WriteDateTime(*Key, Value) : Writer.WriteDateTime(Value); }
+
+	static bool Read(const FBsonValueView& View, FDateTime& OutValue)
+	{
+		int64 Milliseconds;
+		if (View.Type != EBson::DateTime || !View.TryGetNumber(Milliseconds))
+		{
+			return false;
+		}
+		OutValue = FBsonValueDateTime::FromUnixMilliseconds(Milliseconds);
+		return true;
+	}
+};
+
+template<>
+struct TBsonFieldCodec<FBsonObjectId>
+{
+	static uint32 GetSizeBound(const FBsonObjectId& Value) { return 12; }
+	static void Write(FBsonWriter& Writer, const FBsonKey* Key, const FBsonObjectId& Value) { Key ? Writer.WriteObjectId(*Key, Value) : Writer.WriteObjectId(Value); }
+	static bool Read(const FBsonValueView& View, FBsonObjectId& OutValue) { return FBsonVariant::FromView(View).TryGetObjectId(OutValue); }
+};
+
+template<typename ElementType>
+struct TBsonFieldCodec<TArray<ElementType>>
+{
+	static uint32 GetSizeBound(const TArray<ElementType>& Value)
+	{
+		uint32 Size = 5;
+		for (int32 Index = 0; Index < Value.Num(); Index++)
+		{
+			Size += FBsonTraitsSerializer::GetElementSize(FBsonTraitsSerializer::GetIndexKeyLength(Index), TBsonFieldCodec<ElementType>::GetSizeBound(Value[Index]));
+		}
+		return Size;
+	}
+
+	static void Write(FBsonWriter& Writer, const FBsonKey* Key, const TArray<ElementType>& Value)
+	{
+		if (Key)
+		{
+			Writer.BeginArray(*Key);
+		}
+		else
+		{
+			Writer.BeginArray();
+		}
+		for (const ElementType& Element : Value)
+		{
+			TBsonFieldCodec<ElementType>::Write(Writer, nullptr, Element);
+		}
+		Writer.EndArray();
+	}
+
+	static bool Read(const FBsonValueView& View, TArray<ElementType>& OutValue)
+	{
+		TArray<FBsonVariant> Elements;
+		if (!FBsonVariant::TryGetArray(View, Elements))
+		{
+			return false;
+		}
+
+		OutValue.SetNum(Elements.Num());
+		for (int32 Index = 0; Index < Elements.Num(); Index++)
+		{
+			if (!TBsonFieldCodec<ElementType>::Read(Elements[Index].GetView(), OutValue[Index]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+
+template<>
+struct TBsonTraits<FVector>
+{
+	template<typename VisitorType, typename VectorType>
+	static void VisitFields(VisitorType& Visitor, VectorType& Vector)
+	{
+		Visitor("x", Vector.X);
+		Visitor("y", Vector.Y);
+		Visitor("z", Vector.Z);
+	}
+};
+
+template<>
+struct TBsonTraits<FVector2D>
+{
+	template<typename VisitorType, typename VectorType>
+	static void VisitFields(VisitorType& Visitor, VectorType& Vector)
+	{
+		Visitor("x", Vector.X);
+		Visitor("y", Vector.Y);
+	}
+};
+
+template<>
+struct TBsonTraits<FVector4>
+{
+	template<typename VisitorType, typename VectorType>
+	static void VisitFields(VisitorType& Visitor, VectorType& Vector)
+	{
+		Visitor("x", Vector.X);
+		Visitor("y", Vector.Y);
+		Visitor("z", Vector.Z);
+		Visitor("w", Vector.W);
+	}
+};
+
+template<>
+struct TBsonTraits<FRotator>
+{
+	template<typename VisitorType, typename RotatorType>
+	static void VisitFields(VisitorType& Visitor, RotatorType& Rotator)
+	{
+		Visitor("pitch", Rotator.Pitch);
+		Visitor("yaw", Rotator.Yaw);
+		Visitor("roll", Rotator.Roll);
+	}
+};
+
+template<>
+struct TBsonTraits<FQuat>
+{
+	template<typename VisitorType, typename QuatType>
+	static void VisitFields(VisitorType& Visitor, QuatType& Quat)
+	{
+		Visitor("x", Quat.X);
+		Visitor("y", Quat.Y);
+		Visitor("z", Quat.Z);
+		Visitor("w", Quat.W);
+	}
+};
+
+template<>
+struct TBsonTraits<FLinearColor>
+{
+	template<typename VisitorType, typename ColorType>
+	static void VisitFields(VisitorType& Visitor, ColorType& Color)
+	{
+		Visitor("r", Color.R);
+		Visitor("g", Color.G);
+		Visitor("b", Color.B);
+		Visitor("a", Color.A);
+	}
+};
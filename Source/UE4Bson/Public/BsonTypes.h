@@ -19,5 +19,11 @@ enum class EBson
 	Number,
 	Boolean,
 	Array,
-	Object
+	Object,
+	Int32,
+	Int64,
+	DateTime,
+	ObjectId,
+	Binary,
+	Decimal128
 };
\ No newline at end of file
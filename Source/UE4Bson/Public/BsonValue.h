@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "BsonTypes.h"
+#include "BsonObjectId.h"
 #include "Json.h"
 
 class FBsonObject;
@@ -46,6 +47,35 @@ public:
 	*/
 	const TArray<TSharedPtr<FBsonValue>>& AsArray() const;
 
+	/**
+	* Returns this value as an int64, logging an error and returning zero if not possible.
+	* Integer values are returned exactly, without a conversion to double.
+	*
+	* @return this value as an int64 or zero if it can't be converted.
+	*/
+	int64 AsInt64() const;
+
+	/**
+	* Returns this value as an FDateTime, logging an error and returning the default FDateTime if not possible.
+	*
+	* @return this value as an FDateTime or the default FDateTime if it can't be converted.
+	*/
+	FDateTime AsDateTime() const;
+
+	/**
+	* Returns this value as an FBsonObjectId, logging an error and returning an all zero ObjectId if not possible.
+	*
+	* @return this value as an FBsonObjectId or an all zero ObjectId if it can't be converted.
+	*/
+	FBsonObjectId AsObjectId() const;
+
+	/**
+	* Returns the payload of a binary value, logging an error and returning an empty TArray if not possible.
+	*
+	* @return the payload of the binary or an empty TArray if this is not a binary.
+	*/
+	const TArray<uint8>& AsBinary() const;
+
 	/**
 	* Returns this value as an FBsonObject, throwing an error if this is not possible.
 	*
@@ -79,11 +109,12 @@ public:
 
 	/**
 	* Tries to convert this value to an int64, returning false if not possible.
+	* Integer values are read exactly, all others are converted from double.
 	*
 	* @param OutNumber a reference to write the converted number into.
 	* @return false if value can't be converted, true otherwise.
 	*/
-	bool TryGetNumber(int64& OutNumber) const;
+	virtual bool TryGetNumber(int64& OutNumber) const;
 
 	/**
 	* Tries to convert this value to an FString, returning false if not possible.
@@ -109,6 +140,30 @@ public:
 	*/	
 	virtual bool TryGetArray(const TArray<TSharedPtr<FBsonValue>>*& OutArray) const { return false; }
 
+	/**
+	* Tries to convert this value to an FDateTime, returning false if not possible.
+	*
+	* @param OutDateTime a reference to write the converted FDateTime into.
+	* @return false if value can't be converted, true otherwise.
+	*/
+	virtual bool TryGetDateTime(FDateTime& OutDateTime) const { return false; }
+
+	/**
+	* Tries to get this value as an FBsonObjectId, returning false if not possible.
+	*
+	* @param OutId a reference to write the ObjectId into.
+	* @return false if value can't be converted, true otherwise.
+	*/
+	virtual bool TryGetObjectId(FBsonObjectId& OutId) const { return false; }
+
+	/**
+	* Tries to get the payload of a binary value, returning false if this is not a binary.
+	*
+	* @param OutBinary a pointer to a reference to write the payload into.
+	* @return false if value is not a binary, true otherwise.
+	*/
+	virtual bool TryGetBinary(const TArray<uint8>*& OutBinary) const { return false; }
+
 	/**
 	* Tries to convert this value to an FBsonObject, returning false if not possible.
 	*
@@ -131,6 +186,10 @@ public:
 	void AsArgumentType(bool                            & Value) { Value = AsBool(); }
 	void AsArgumentType(TArray<TSharedPtr<FBsonValue>>& Value) { Value = AsArray(); }
 	void AsArgumentType(TSharedPtr<FBsonObject>         & Value) { Value = AsObject(); }
+	void AsArgumentType(int64                           & Value) { Value = AsInt64(); }
+	void AsArgumentType(FDateTime                       & Value) { Value = AsDateTime(); }
+	void AsArgumentType(FBsonObjectId                   & Value) { Value = AsObjectId(); }
+	void AsArgumentType(TArray<uint8>                   & Value) { Value = AsBinary(); }
 
 	EBson Type;
 
@@ -150,6 +209,7 @@ public:
 protected:
 
 	static const TArray<TSharedPtr<FBsonValue>> EMPTY_ARRAY;
+	static const TArray<uint8> EMPTY_BINARY;
 	static const TSharedPtr<FBsonObject> EMPTY_OBJECT;
 
 	FBsonValue() : Type(EBson::None) {}
@@ -168,6 +228,7 @@ class UE4BSON_API FBsonValueString : public FBsonValue
 public:
 	FBsonValueString(const FString& InString) : Value(InString) { Type = EBson::String; }
 
+	using FBsonValue::TryGetNumber;
 	virtual bool TryGetString(FString& OutString) const override { OutString = Value; return true; }
 	virtual bool TryGetNumber(double& OutDouble) const override { if (Value.IsNumeric()) { OutDouble = FCString::Atod(*Value); return true; } else { return false; } }
 	virtual bool TryGetBool(bool& OutBool) const override { OutBool = Value.ToBool(); return true; }
@@ -183,6 +244,7 @@ class UE4BSON_API FBsonValueNumber : public FBsonValue
 {
 public:
 	FBsonValueNumber(double InNumber) : Value(InNumber) { Type = EBson::Number; }
+	using FBsonValue::TryGetNumber;
 	virtual bool TryGetNumber(double& OutNumber) const override { OutNumber = Value; return true; }
 	virtual bool TryGetBool(bool& OutBool) const override { OutBool = (Value != 0.0); return true; }
 	virtual bool TryGetString(FString& OutString) const override { OutString = FString::SanitizeFloat(Value, 0); return true; }
@@ -198,6 +260,7 @@ class UE4BSON_API FBsonValueBoolean : public FBsonValue
 {
 public:
 	FBsonValueBoolean(bool InBool) : Value(InBool) { Type = EBson::Boolean; }
+	using FBsonValue::TryGetNumber;
 	virtual bool TryGetNumber(double& OutNumber) const override { OutNumber = Value ? 1 : 0; return true; }
 	virtual bool TryGetBool(bool& OutBool) const override { OutBool = Value; return true; }
 	virtual bool TryGetString(FString& OutString) const override { OutString = Value ? TEXT("true") : TEXT("false"); return true; }
@@ -243,3 +306,117 @@ public:
 protected:
 	virtual FString GetType() const override { return TEXT("Null"); }
 };
+
+/** \brief A Bson 32 bit Integer Value. */
+class UE4BSON_API FBsonValueInt32 : public FBsonValue
+{
+public:
+	FBsonValueInt32(int32 InNumber) : Value(InNumber) { Type = EBson::Int32; }
+
+	using FBsonValue::TryGetNumber;
+	virtual bool TryGetNumber(double& OutNumber) const override { OutNumber = Value; return true; }
+	virtual bool TryGetNumber(int64& OutNumber) const override { OutNumber = Value; return true; }
+	virtual bool TryGetBool(bool& OutBool) const override { OutBool = (Value != 0); return true; }
+	virtual bool TryGetString(FString& OutString) const override { OutString = FString::FromInt(Value); return true; }
+
+protected:
+	int32 Value;
+
+	virtual FString GetType() const override { return TEXT("Int32"); }
+};
+
+/** \brief A Bson 64 bit Integer Value. */
+class UE4BSON_API FBsonValueInt64 : public FBsonValue
+{
+public:
+	FBsonValueInt64(int64 InNumber) : Value(InNumber) { Type = EBson::Int64; }
+
+	using FBsonValue::TryGetNumber;
+	virtual bool TryGetNumber(double& OutNumber) const override { OutNumber = (double)Value; return true; }
+	virtual bool TryGetNumber(int64& OutNumber) const override { OutNumber = Value; return true; }
+	virtual bool TryGetBool(bool& OutBool) const override { OutBool = (Value != 0); return true; }
+	virtual bool TryGetString(FString& OutString) const override { OutString = FString::Printf(TEXT("%lld"), Value); return true; }
+
+protected:
+	int64 Value;
+
+	virtual FString GetType() const override { return TEXT("Int64"); }
+};
+
+/** \brief A Bson UTC DateTime Value, stored as milliseconds since the Unix epoch. */
+class UE4BSON_API FBsonValueDateTime : public FBsonValue
+{
+public:
+	FBsonValueDateTime(int64 InUnixMilliseconds) : Value(InUnixMilliseconds) { Type = EBson::DateTime; }
+	FBsonValueDateTime(const FDateTime& InDateTime) : Value(ToUnixMilliseconds(InDateTime)) { Type = EBson::DateTime; }
+
+	using FBsonValue::TryGetNumber;
+	virtual bool TryGetNumber(double& OutNumber) const override { OutNumber = (double)Value; return true; }
+	virtual bool TryGetNumber(int64& OutNumber) const override { OutNumber = Value; return true; }
+	virtual bool TryGetDateTime(FDateTime& OutDateTime) const override { OutDateTime = FromUnixMilliseconds(Value); return true; }
+	virtual bool TryGetString(FString& OutString) const override { OutString = FromUnixMilliseconds(Value).ToIso8601(); return true; }
+
+	/** @return the milliseconds since the Unix epoch of an FDateTime. */
+	static int64 ToUnixMilliseconds(const FDateTime& DateTime) { return (DateTime - FDateTime(1970, 1, 1)).GetTicks() / ETimespan::TicksPerMillisecond; }
+
+	/** @return the FDateTime of the given milliseconds since the Unix epoch. */
+	static FDateTime FromUnixMilliseconds(int64 Milliseconds) { return FDateTime(1970, 1, 1) + FTimespan(Milliseconds * ETimespan::TicksPerMillisecond); }
+
+protected:
+	int64 Value;
+
+	virtual FString GetType() const override { return TEXT("DateTime"); }
+};
+
+/** \brief A Bson ObjectId Value. */
+class UE4BSON_API FBsonValueObjectId : public FBsonValue
+{
+public:
+	FBsonValueObjectId(const FBsonObjectId& InId) : Value(InId) { Type = EBson::ObjectId; }
+
+	virtual bool TryGetObjectId(FBsonObjectId& OutId) const override { OutId = Value; return true; }
+	virtual bool TryGetString(FString& OutString) const override { OutString = Value.ToString(); return true; }
+
+protected:
+	FBsonObjectId Value;
+
+	virtual FString GetType() const override { return TEXT("ObjectId"); }
+};
+
+/** \brief A Bson Binary Value. */
+class UE4BSON_API FBsonValueBinary : public FBsonValue
+{
+public:
+	FBsonValueBinary(const TArray<uint8>& InBinary, uint8 InSubtype = 0) : Value(InBinary), Subtype(InSubtype) { Type = EBson::Binary; }
+
+	virtual bool TryGetBinary(const TArray<uint8>*& OutBinary) const override { OutBinary = &Value; return true; }
+
+	/** @return the bson_subtype_t of the binary. */
+	uint8 GetSubtype() const { return Subtype; }
+
+protected:
+	TArray<uint8> Value;
+	uint8 Subtype;
+
+	virtual FString GetType() const override { return TEXT("Binary"); }
+};
+
+/** \brief A Bson Decimal128 Value, kept in its IEEE 754-2008 binary integer decimal encoding. */
+class UE4BSON_API FBsonValueDecimal128 : public FBsonValue
+{
+public:
+	FBsonValueDecimal128(uint64 InLow, uint64 InHigh) : Low(InLow), High(InHigh) { Type = EBson::Decimal128; }
+
+	using FBsonValue::TryGetNumber;
+	virtual bool TryGetNumber(double& OutNumber) const override;
+	virtual bool TryGetString(FString& OutString) const override;
+
+	uint64 GetLow() const { return Low; }
+	uint64 GetHigh() const { return High; }
+
+protected:
+	uint64 Low;
+	uint64 High;
+
+	virtual FString GetType() const override { return TEXT("Decimal128"); }
+};
@@ -0,0 +1,167 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BsonTypes.h"
+
+/**
+* \brief A non-owning view of a single value inside an FBsonObject.
+*
+* Unlike FBsonValue, a view does not copy anything: it consists of the type of the value and a
+* pointer into the buffer of the FBsonObject it was obtained from, so reading it never allocates.
+* A view is only valid as long as that FBsonObject is alive and has not been modified.
+*/
+class UE4BSON_API FBsonValueView
+{
+public:
+
+	/**
+	* Constructor that creates a view of no value (EBson::None).
+	*/
+	FBsonValueView() : Type(EBson::None), BsonType(0), Subtype(0), Data(nullptr), Length(0) {}
+
+	/**
+	* Creates a view of raw Bson value bytes.
+	*
+	* @param InType the general type of the value.
+	* @param InBsonType the exact bson_type_t of the value.
+	* @param InData pointer to the value. Strings and binaries point at their payload, documents and arrays at their length header.
+	* @param InLength the number of bytes at InData belonging to the value.
+	* @param InSubtype the bson_subtype_t of a binary value.
+	*/
+	FBsonValueView(EBson InType, uint8 InBsonType, const uint8* InData, uint32 InLength, uint8 InSubtype = 0)
+		: Type(InType), BsonType(InBsonType), Subtype(InSubtype), Data(InData), Length(InLength) {}
+
+	/** @return true if this view points at a value, which may still be a Bson null. */
+	bool IsValid() const { return Data != nullptr; }
+
+	/** @return true if this value is 'null' or the view doesn't point at a value. */
+	bool IsNull() const { return Type == EBson::Null || Type == EBson::None; }
+
+	/** @return the exact bson_type_t of the value (see http://mongoc.org/libbson/current/bson_type_t.html). */
+	uint8 GetBsonType() const { return BsonType; }
+
+	/** @return the bson_subtype_t of a binary value. */
+	uint8 GetBinarySubtype() const { return Subtype; }
+
+	/**
+	* Returns this value as a double, logging an error and returning zero if not possible.
+	*
+	* @return this value as a double or zero if it can't be converted.
+	*/
+	double AsDouble() const;
+
+	/**
+	* Returns this value as an int64, logging an error and returning zero if not possible.
+	*
+	* @return this value as an int64 or zero if it can't be converted.
+	*/
+	int64 AsInt64() const;
+
+	/**
+	* Returns this value as an int32, logging an error and returning zero if not possible.
+	*
+	* @return this value as an int32 or zero if it can't be converted.
+	*/
+	int32 AsInt32() const;
+
+	/**
+	* Returns this value as a boolean, logging an error and returning false if not possible.
+	*
+	* @return this value as a boolean or false if it can't be converted.
+	*/
+	bool AsBool() const;
+
+	/**
+	* Returns the UTF-8 bytes of a string value (without terminating zero), logging an error and returning an empty view if not possible.
+	*
+	* @return the bytes of the string or an empty view if this is not a string.
+	*/
+	TArrayView<const ANSICHAR> AsUtf8View() const;
+
+	/**
+	* Returns this value converted to an FString, logging an error and returning an empty string if not possible.
+	* Mind that this allocates, use AsUtf8View() to read the string in place.
+	*
+	* @return this value as an FString or an empty string if it can't be converted.
+	*/
+	FString AsString() const;
+
+	/**
+	* Returns the payload of a binary value, logging an error and returning an empty view if not possible.
+	*
+	* @return the payload of the binary or an empty view if this is not a binary.
+	*/
+	TArrayView<const uint8> AsBinaryView() const;
+
+	/**
+	* Returns the raw bytes (including the length header) of an object or array value,
+	* logging an error and returning an empty view if not possible.
+	*
+	* @return the bytes of the embedded document or an empty view if this is not an object or array.
+	*/
+	TArrayView<const uint8> AsDocumentView() const;
+
+	/**
+	* Tries to convert this value to a double, returning false if not possible.
+	*
+	* @param OutDouble a reference to write the converted number into.
+	* @return false if value can't be converted, true otherwise.
+	*/
+	bool TryGetNumber(double& OutDouble) const;
+
+	/**
+	* Tries to convert this value to an int64, returning false if not possible.
+	* Integer values are read exactly, doubles are rounded.
+	*
+	* @param OutNumber a reference to write the converted number into.
+	* @return false if value can't be converted, true otherwise.
+	*/
+	bool TryGetNumber(int64& OutNumber) const;
+
+	/**
+	* Tries to convert this value to an int32, returning false if not possible.
+	*
+	* @param OutNumber a reference to write the converted number into.
+	* @return false if value can't be converted or is out of range, true otherwise.
+	*/
+	bool TryGetNumber(int32& OutNumber) const;
+
+	/**
+	* Tries to convert this value to a boolean, returning false if not possible.
+	*
+	* @param OutBool a reference to write the converted boolean into.
+	* @return false if value can't be converted, true otherwise.
+	*/
+	bool TryGetBool(bool& OutBool) const;
+
+	/**
+	* Tries to get the UTF-8 bytes of a string value, returning false if this is not a string.
+	*
+	* @param OutUtf8 a reference to write the view of the string into.
+	* @return false if value is not a string, true otherwise.
+	*/
+	bool TryGetUtf8(TArrayView<const ANSICHAR>& OutUtf8) const;
+
+	/**
+	* Tries to get the payload of a binary value, returning false if this is not a binary.
+	*
+	* @param OutBinary a reference to write the view of the payload into.
+	* @return false if value is not a binary, true otherwise.
+	*/
+	bool TryGetBinary(TArrayView<const uint8>& OutBinary) const;
+
+	EBson Type;
+
+private:
+
+	friend class FBsonVariant;
+
+	uint8 BsonType;
+	uint8 Subtype;
+	const uint8* Data;
+	uint32 Length;
+
+	void ErrorMessage(const TCHAR* InType) const;
+};
@@ -0,0 +1,218 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BsonTypes.h"
+#include "BsonValueView.h"
+#include "BsonObjectId.h"
+
+class FBsonObject;
+
+/**
+* \brief A compact Bson value that is stored by value, e.g. directly in a TArray.
+*
+* Unlike FBsonValue, a variant has no virtual functions and needs no TSharedPtr. It keeps the Bson
+* encoding of its value: numbers, booleans, dates, ObjectIds, decimals and strings of up to 16 UTF-8
+* bytes are stored inside the variant itself. Longer strings, binaries, objects and arrays are kept in
+* a single heap block owned by the variant. A TArray<FBsonVariant> of numbers is one allocation.
+*
+* Objects and arrays stay encoded, TryGetObject() and TryGetArray() decode them on demand.
+*/
+class UE4BSON_API FBsonVariant
+{
+public:
+
+	/**
+	* Constructor that creates no value (EBson::None), which is written as a Bson null.
+	*/
+	FBsonVariant() : Type(EBson::None), BsonType(0), Subtype(0), bOnHeap(false), InlineLength(0) {}
+
+	explicit FBsonVariant(double Number);
+	explicit FBsonVariant(int32 Number);
+	explicit FBsonVariant(int64 Number);
+	explicit FBsonVariant(bool Bool);
+	explicit FBsonVariant(const FString& String);
+	explicit FBsonVariant(const TCHAR* String) : FBsonVariant(FString(String)) {}
+
+	/**
+	* Creates a string value from a zero terminated narrow string, e.g. a "literal", whose bytes are taken as UTF-8.
+	* Without it, narrow strings would silently pick the bool constructor where TCHAR is wchar_t.
+	*/
+	explicit FBsonVariant(const ANSICHAR* Utf8);
+
+	/** Other pointers would convert to bool as well. */
+	template <typename PointeeType>
+	explicit FBsonVariant(const PointeeType* Pointer) = delete;
+
+	explicit FBsonVariant(const FDateTime& DateTime);
+	explicit FBsonVariant(const FBsonObjectId& Id);
+
+	/**
+	* Creates an object value holding a copy of the bytes of a document.
+	*/
+	explicit FBsonVariant(const FBsonObject& Object);
+
+	/**
+	* Creates an array value, encoding the elements into a single block.
+	*/
+	explicit FBsonVariant(TArrayView<const FBsonVariant> Elements);
+
+	FBsonVariant(const FBsonVariant& Other);
+	FBsonVariant(FBsonVariant&& Other);
+	FBsonVariant& operator=(const FBsonVariant& Other);
+	FBsonVariant& operator=(FBsonVariant&& Other);
+
+	~FBsonVariant()
+	{
+		FreeHeap();
+	}
+
+	/** @return a Bson null. */
+	static FBsonVariant Null();
+
+	/**
+	* Creates a string value from UTF-8 bytes, without converting them.
+	*
+	* @param Utf8 the bytes of the string, without terminating zero.
+	*/
+	static FBsonVariant FromUtf8(TArrayView<const ANSICHAR> Utf8);
+
+	/**
+	* Creates a binary value.
+	*
+	* @param Binary the payload.
+	* @param Subtype the bson_subtype_t of the binary.
+	*/
+	static FBsonVariant FromBinary(TArrayView<const uint8> Binary, uint8 Subtype = 0);
+
+	/**
+	* Creates a Decimal128 value from its two 64 bit words (see FBsonValueDecimal128).
+	*/
+	static FBsonVariant FromDecimal128(uint64 Low, uint64 High);
+
+	/**
+	* Copies the value a view points at.
+	*/
+	static FBsonVariant FromView(const FBsonValueView& View);
+
+	/** @return the general type of the value. */
+	EBson GetType() const { return Type; }
+
+	/** @return the exact bson_type_t of the value, zero for EBson::None. */
+	uint8 GetBsonType() const { return BsonType; }
+
+	/** @return true if this value is 'null' or no value. */
+	bool IsNull() const { return Type == EBson::Null || Type == EBson::None; }
+
+	/**
+	* Returns a view of this value, which offers the As*() accessors.
+	* The view is only valid as long as this variant is alive and unchanged.
+	*/
+	FBsonValueView GetView() const
+	{
+		return Type == EBson::None ? FBsonValueView() : FBsonValueView(Type, BsonType, GetBytes(), GetLength(), Subtype);
+	}
+
+	/** See FBsonValueView::TryGetNumber(). */
+	bool TryGetNumber(double& OutNumber) const { return GetView().TryGetNumber(OutNumber); }
+	bool TryGetNumber(int64& OutNumber) const { return GetView().TryGetNumber(OutNumber); }
+	bool TryGetNumber(int32& OutNumber) const { return GetView().TryGetNumber(OutNumber); }
+
+	/** See FBsonValueView::TryGetBool(). */
+	bool TryGetBool(bool& OutBool) const { return GetView().TryGetBool(OutBool); }
+
+	/** See FBsonValueView::TryGetUtf8(). */
+	bool TryGetUtf8(TArrayView<const ANSICHAR>& OutUtf8) const { return GetView().TryGetUtf8(OutUtf8); }
+
+	/** See FBsonValueView::TryGetBinary(). */
+	bool TryGetBinary(TArrayView<const uint8>& OutBinary) const { return GetView().TryGetBinary(OutBinary); }
+
+	/**
+	* Tries to get a string or Decimal128 value as an FString, returning false for other types.
+	*
+	* @param OutString a reference to write the string into.
+	* @return false if value is neither a string nor a decimal, true otherwise.
+	*/
+	bool TryGetString(FString& OutString) const;
+
+	/**
+	* Tries to get a DateTime value, returning false for other types.
+	*
+	* @param OutDateTime a reference to write the date into.
+	* @return false if value is not a DateTime, true otherwise.
+	*/
+	bool TryGetDateTime(FDateTime& OutDateTime) const;
+
+	/**
+	* Tries to get an ObjectId value, returning false for other types.
+	*
+	* @param OutId a reference to write the ObjectId into.
+	* @return false if value is not an ObjectId, true otherwise.
+	*/
+	bool TryGetObjectId(FBsonObjectId& OutId) const;
+
+	/**
+	* Tries to get the two 64 bit words of a Decimal128 value, returning false for other types.
+	*
+	* @return false if value is not a Decimal128, true otherwise.
+	*/
+	bool TryGetDecimal128(uint64& OutLow, uint64& OutHigh) const;
+
+	/**
+	* Tries to copy an object value into an FBsonObject, returning false for other types.
+	*
+	* @param OutObject a reference to write the copied object into.
+	* @return false if value is not an object, true otherwise.
+	*/
+	bool TryGetObject(FBsonObject& OutObject) const;
+
+	/**
+	* Tries to decode the elements of an array value, returning false for other types.
+	*
+	* @param OutArray the array to reset and fill.
+	* @return false if value is not an array, true otherwise.
+	*/
+	bool TryGetArray(TArray<FBsonVariant>& OutArray) const;
+
+	/**
+	* Decodes the elements of the array a view points at, without copying the array first.
+	*
+	* @param View a view of an array value.
+	* @param OutArray the array to reset and fill.
+	* @return false if View is not an array, true otherwise.
+	*/
+	static bool TryGetArray(const FBsonValueView& View, TArray<FBsonVariant>& OutArray);
+
+private:
+
+	/** Heap block of values that don't fit into Inline. */
+	struct FHeapBytes
+	{
+		uint8* Data;
+		uint32 Length;
+	};
+
+	static const uint32 InlineCapacity = 16;
+
+	EBson Type;
+	uint8 BsonType;
+	uint8 Subtype;
+	bool bOnHeap;
+	uint8 InlineLength;
+
+	/** The Bson encoding of the value, without the type and key of the element. */
+	union
+	{
+		uint8 Inline[InlineCapacity];
+		FHeapBytes Heap;
+	};
+
+	FBsonVariant(EBson InType, uint8 InBsonType, const void* Bytes, uint32 Length, uint8 InSubtype = 0);
+
+	void SetBytes(const void* Bytes, uint32 Length);
+	void FreeHeap();
+
+	const uint8* GetBytes() const { return bOnHeap ? Heap.Data : Inline; }
+	uint32 GetLength() const { return bOnHeap ? Heap.Length : InlineLength; }
+};
@@ -0,0 +1,177 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BsonKey.h"
+
+class FBsonObject;
+struct FBsonObjectId;
+
+/**
+* \brief Streams fields, including arbitrarily nested objects and arrays, directly into an FBsonObject.
+*
+* Nested objects and arrays are opened with BeginObject()/BeginArray() and closed with EndObject()/EndArray().
+* Everything is appended in place to the buffer of the target object, no intermediate documents or
+* FBsonValues are created. Inside arrays the keyless Write functions are used, the indices are generated.
+* The target object must not be used otherwise while objects or arrays are open.
+*
+* \code
+* FBsonWriter Writer(*Object);
+* Writer.BeginObject(TEXT("Pose"));
+*     Writer.WriteNumber(TEXT("X"), 1.0);
+*     Writer.BeginArray(TEXT("Joints"));
+*         Writer.WriteNumber(0.5);
+*         Writer.WriteNumber(0.25);
+*     Writer.EndArray();
+* Writer.EndObject();
+* \endcode
+*/
+class UE4BSON_API FBsonWriter
+{
+public:
+
+	/**
+	* Starts appending to the given object. Fields already present in it are kept.
+	*
+	* @param InObject the object to write to, has to outlive the writer.
+	*/
+	explicit FBsonWriter(FBsonObject& InObject);
+
+	/**
+	* Closes all objects and arrays that are still open.
+	*/
+	~FBsonWriter();
+
+	/** @return the number of currently open objects and arrays. */
+	int32 GetDepth() const { return Depth; }
+
+	/** @return true if the innermost open container is an array. */
+	bool IsInArray() const;
+
+	/**
+	* Opens an object field, all following writes go into it until EndObject().
+	* If it can't be opened, the failure is logged and the matching EndObject() does nothing.
+	*/
+	void BeginObject(const FBsonKey& Key);
+	void BeginObject(const FString& FieldName);
+
+	/** Opens an object as the next element of the current array. */
+	void BeginObject();
+
+	/** Closes the innermost object. */
+	void EndObject();
+
+	/**
+	* Opens an array field, all following writes go into it until EndArray().
+	* If it can't be opened, the failure is logged and the matching EndArray() does nothing.
+	*/
+	void BeginArray(const FBsonKey& Key);
+	void BeginArray(const FString& FieldName);
+
+	/** Opens an array as the next element of the current array. */
+	void BeginArray();
+
+	/** Closes the innermost array. */
+	void EndArray();
+
+	/** Writes a field of type double (number). */
+	void WriteNumber(const FBsonKey& Key, double Number);
+	void WriteNumber(const FString& FieldName, double Number);
+
+	/** Writes a double (number) as the next element of the current array. */
+	void WriteNumber(double Number);
+
+	/** Writes a field of type int32. */
+	void WriteInt32(const FBsonKey& Key, int32 Number);
+	void WriteInt32(const FString& FieldName, int32 Number);
+
+	/** Writes an int32 as the next element of the current array. */
+	void WriteInt32(int32 Number);
+
+	/** Writes a field of type int64. */
+	void WriteInt64(const FBsonKey& Key, int64 Number);
+	void WriteInt64(const FString& FieldName, int64 Number);
+
+	/** Writes an int64 as the next element of the current array. */
+	void WriteInt64(int64 Number);
+
+	/** Writes a field of type DateTime. */
+	void WriteDateTime(const FBsonKey& Key, const FDateTime& DateTime);
+	void WriteDateTime(const FString& FieldName, const FDateTime& DateTime);
+
+	/** Writes a DateTime as the next element of the current array. */
+	void WriteDateTime(const FDateTime& DateTime);
+
+	/** Writes a field of type ObjectId. */
+	void WriteObjectId(const FBsonKey& Key, const FBsonObjectId& Id);
+	void WriteObjectId(const FString& FieldName, const FBsonObjectId& Id);
+
+	/** Writes an ObjectId as the next element of the current array. */
+	void WriteObjectId(const FBsonObjectId& Id);
+
+	/** Writes a field of type boolean. */
+	void WriteBool(const FBsonKey& Key, bool Bool);
+	void WriteBool(const FString& FieldName, bool Bool);
+
+	/** Writes a boolean as the next element of the current array. */
+	void WriteBool(bool Bool);
+
+	/** Writes a field of type string. */
+	void WriteString(const FBsonKey& Key, const FString& StringValue);
+	void WriteString(const FString& FieldName, const FString& StringValue);
+
+	/** Writes a string as the next element of the current array. */
+	void WriteString(const FString& StringValue);
+
+	/** Writes a field of type null. */
+	void WriteNull(const FBsonKey& Key);
+	void WriteNull(const FString& FieldName);
+
+	/** Writes a null as the next element of the current array. */
+	void WriteNull();
+
+	/** Copies a finished FBsonObject into an object field. */
+	void WriteObject(const FBsonKey& Key, const FBsonObject& InObject);
+	void WriteObject(const FString& FieldName, const FBsonObject& InObject);
+
+	/** Copies a finished FBsonObject as the next element of the current array. */
+	void WriteObject(const FBsonObject& InObject);
+
+private:
+
+	struct FFrame;
+
+	FBsonObject& Object;
+
+	/** Open objects and arrays, innermost last. Only the first Depth frames are in use, the rest are kept for reuse. */
+	TArray<FFrame*> Frames;
+
+	int32 Depth;
+
+	/** Begin calls outside of any frame that failed and are still waiting for their End. */
+	uint32 RootFailedBegins;
+
+	FBsonWriter(const FBsonWriter&) = delete;
+	FBsonWriter& operator=(const FBsonWriter&) = delete;
+
+	/** @return the document the next field has to be appended to. */
+	struct _bson_t* GetTarget();
+
+	/** Takes the index of the next element of the current array, fails if no array is open. */
+	bool NextArrayIndex(uint32& OutIndex);
+
+	/** @return the frame the next Begin call opens its object or array in, without pushing it yet. */
+	FFrame& GetNextFrame();
+
+	/**
+	* Pushes the frame returned by GetNextFrame() if it was opened. A failed Begin is logged and
+	* remembered instead, so that its End is a no-op rather than closing the enclosing frame.
+	*/
+	void PushFrame(bool bArray, bool bOpened);
+
+	/** @return the number of failed Begin calls waiting for their End in the innermost frame. */
+	uint32& GetFailedBegins();
+
+	void PopFrame(bool bArray);
+};
@@ -6,4 +6,20 @@
 
 #include "BsonTypes.h"
 #include "BsonObject.h"
-#include "BsonValue.h"
\ No newline at end of file
+#include "BsonValue.h"
+#include "BsonKey.h"
+#include "BsonObjectId.h"
+#include "BsonValueView.h"
+#include "BsonVariant.h"
+#include "BsonPath.h"
+#include "BsonFieldSet.h"
+#include "BsonWriter.h"
+#include "BsonObjectConverter.h"
+#include "BsonTraits.h"
+#include "BsonFileStats.h"
+#include "BsonFileWriter.h"
+#include "BsonFileIndex.h"
+#include "BsonFileReader.h"
+#include "BsonCompressedFileReader.h"
+#include "BsonParallelScan.h"
+#include "BsonScopedArena.h"